@@ -0,0 +1,329 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "CBORParser.h"
+
+#include <limits.h>
+#include <math.h>
+
+#include "CBORWriter.h"
+
+/* initialize constants */
+const int CBORParser::MAX_DEPTH = 512;
+
+CBORParser::CBORParser() {
+	m_current = NULL;
+	m_end = NULL;
+	m_handler = NULL;
+	m_pushContent = new std::string;
+	m_pushHandler = NULL;
+	m_string = new std::string;
+}
+
+CBORParser::~CBORParser() {
+	delete m_pushContent;
+	delete m_string;
+}
+
+/*
+ * Prepares to parse content that is provided incrementally through push().
+ * Each data item is preceded by its length, so rather than keeping the state
+ * of a partial item between calls the content is accumulated and then parsed
+ * by endPush() in a single pass.  The accumulated content's buffer is kept
+ * for reuse by the next packet.
+ */
+void CBORParser::beginPush(IJSONHandler* handler) {
+	m_pushContent->clear();
+	m_pushHandler = handler;
+}
+
+bool CBORParser::endPush() {
+	bool success = parse(m_pushContent->data(), m_pushContent->length(), m_pushHandler);
+	m_pushContent->clear();
+	m_pushHandler = NULL;
+	return success;
+}
+
+/*
+ * Parses CBOR content in place.  The content must consist of exactly one
+ * data item.
+ */
+bool CBORParser::parse(const char* cbor, size_t length, IJSONHandler* handler) {
+	m_handler = handler;
+	m_current = cbor;
+	m_end = cbor + length;
+	bool success = parseValue(0);
+	if (success && m_current != m_end) {
+		Logger::error("CBOR content continues after its value");
+		success = false;
+	}
+	m_current = m_end = NULL;
+	m_handler = NULL;
+	return success;
+}
+
+/*
+ * Reads the argument (a value, length or count) that follows an initial byte
+ * with the given additional information.  Indefinite lengths are handled by
+ * the caller.
+ */
+bool CBORParser::parseArgument(unsigned char info, unsigned __int64* _value) {
+	if (info < 24) {
+		*_value = info;
+		return true;
+	}
+	if (info <= 27) {
+		return readBytes((size_t)1 << (info - 24), _value);
+	}
+	Logger::error("CBOR content contains an invalid argument length");
+	return false;
+}
+
+bool CBORParser::parseContainer(unsigned char initial, int depth) {
+	if (MAX_DEPTH <= depth) {
+		Logger::error("CBOR content is nested too deeply");
+		return false;
+	}
+
+	bool isMap = (initial & 0xE0) == CBORWriter::MAJOR_MAP;
+	bool indefinite = (initial & 0x1F) == CBORWriter::CBOR_INDEFINITE;
+	unsigned __int64 count = 0;
+	if (!indefinite) {
+		if (!parseArgument(initial & 0x1F, &count)) {
+			return false;
+		}
+
+		/* each array element occupies at least one byte, and each map member at least two */
+		if ((unsigned __int64)(m_end - m_current) / (isMap ? 2 : 1) < count) {
+			Logger::error("CBOR content ended before its value was complete");
+			return false;
+		}
+	}
+
+	if (!(isMap ? m_handler->onStartObject() : m_handler->onStartArray())) {
+		return false;
+	}
+	for (unsigned __int64 i = 0; indefinite || i < count; i++) {
+		if (m_current == m_end) {
+			Logger::error("CBOR content ended before its value was complete");
+			return false;
+		}
+		if (indefinite && (unsigned char)*m_current == CBORWriter::CBOR_BREAK) {
+			m_current++;
+			break;
+		}
+		if (isMap) {
+			unsigned char keyInitial = (unsigned char)*m_current++;
+			if ((keyInitial & 0xE0) != CBORWriter::MAJOR_TEXT) {
+				Logger::error("CBOR content has a map key that is not a text string");
+				return false;
+			}
+			if (!parseText(keyInitial, m_string) || !m_handler->onKey(m_string)) {
+				return false;
+			}
+		}
+		if (!parseValue(depth + 1)) {
+			return false;
+		}
+	}
+	return isMap ? m_handler->onEndObject() : m_handler->onEndArray();
+}
+
+/*
+ * Half-precision floats are widened to single precision by adjusting their
+ * exponent bias, which also carries infinities and NaNs across.
+ */
+bool CBORParser::parseFloat(unsigned char initial) {
+	double value = 0;
+	unsigned __int64 bits = 0;
+	switch (initial) {
+		case CBORWriter::CBOR_HALF: {
+			if (!readBytes(2, &bits)) {
+				return false;
+			}
+			unsigned int sign = (unsigned int)(bits & 0x8000) << 16;
+			unsigned int exponent = (unsigned int)(bits >> 10) & 0x1F;
+			unsigned int mantissa = (unsigned int)bits & 0x3FF;
+			if (exponent == 0) {
+				/* zero or subnormal */
+				value = ldexp((double)mantissa, -24);
+				if (sign) {
+					value = -value;
+				}
+				break;
+			}
+			unsigned int singleBits = sign | (mantissa << 13);
+			singleBits |= exponent == 0x1F ? 0x7F800000 : (exponent + 112) << 23;
+			float single = 0;
+			memcpy(&single, &singleBits, sizeof(single));
+			value = single;
+			break;
+		}
+		case CBORWriter::CBOR_FLOAT: {
+			if (!readBytes(4, &bits)) {
+				return false;
+			}
+			unsigned int singleBits = (unsigned int)bits;
+			float single = 0;
+			memcpy(&single, &singleBits, sizeof(single));
+			value = single;
+			break;
+		}
+		default: {
+			/* CBOR_DOUBLE */
+			if (!readBytes(8, &bits)) {
+				return false;
+			}
+			memcpy(&value, &bits, sizeof(value));
+			break;
+		}
+	}
+	return m_handler->onNumber(value);
+}
+
+/*
+ * Reads a text string into the target, joining the chunks of a string of
+ * indefinite length.  As with JSON content, the string's bytes are not
+ * validated as UTF-8.
+ */
+bool CBORParser::parseText(unsigned char initial, std::string* target) {
+	target->clear();
+	bool indefinite = (initial & 0x1F) == CBORWriter::CBOR_INDEFINITE;
+	while (true) {
+		unsigned char chunkInitial = initial;
+		if (indefinite) {
+			if (m_current == m_end) {
+				Logger::error("CBOR content ended before its value was complete");
+				return false;
+			}
+			chunkInitial = (unsigned char)*m_current++;
+			if (chunkInitial == CBORWriter::CBOR_BREAK) {
+				return true;
+			}
+			if ((chunkInitial & 0xE0) != CBORWriter::MAJOR_TEXT || (chunkInitial & 0x1F) == CBORWriter::CBOR_INDEFINITE) {
+				Logger::error("CBOR content has a text string chunk that is not a definite-length text string");
+				return false;
+			}
+		}
+
+		unsigned __int64 length = 0;
+		if (!parseArgument(chunkInitial & 0x1F, &length)) {
+			return false;
+		}
+		if ((unsigned __int64)(m_end - m_current) < length) {
+			Logger::error("CBOR content ended before its value was complete");
+			return false;
+		}
+		target->append(m_current, (size_t)length);
+		m_current += length;
+		if (!indefinite) {
+			return true;
+		}
+	}
+}
+
+bool CBORParser::parseValue(int depth) {
+	unsigned char initial = 0;
+	unsigned __int64 argument = 0;
+	while (true) {
+		if (m_current == m_end) {
+			Logger::error("CBOR content ended before its value was complete");
+			return false;
+		}
+		initial = (unsigned char)*m_current++;
+		if ((initial & 0xE0) != CBORWriter::MAJOR_TAG) {
+			break;
+		}
+
+		/* tags only qualify the value that follows them, so they are skipped */
+		if (!parseArgument(initial & 0x1F, &argument)) {
+			return false;
+		}
+	}
+
+	switch (initial & 0xE0) {
+		case CBORWriter::MAJOR_UNSIGNED: {
+			if (!parseArgument(initial & 0x1F, &argument)) {
+				return false;
+			}
+			return m_handler->onNumber((double)argument);
+		}
+		case CBORWriter::MAJOR_NEGATIVE: {
+			if (!parseArgument(initial & 0x1F, &argument)) {
+				return false;
+			}
+			/* the value is -1 - argument, which is computed as an integer so that it is rounded only once */
+			if (argument == _UI64_MAX) {
+				return m_handler->onNumber(-18446744073709551616.0);
+			}
+			return m_handler->onNumber(-(double)(argument + 1));
+		}
+		case CBORWriter::MAJOR_BYTES: {
+			Logger::error("CBOR content has a byte string, which has no JSON equivalent");
+			return false;
+		}
+		case CBORWriter::MAJOR_TEXT: {
+			if (!parseText(initial, m_string)) {
+				return false;
+			}
+			return m_handler->onString(m_string);
+		}
+		case CBORWriter::MAJOR_ARRAY:
+		case CBORWriter::MAJOR_MAP: {
+			return parseContainer(initial, depth);
+		}
+	}
+
+	/* MAJOR_SIMPLE */
+	switch (initial) {
+		case CBORWriter::CBOR_FALSE: {
+			return m_handler->onBoolean(false);
+		}
+		case CBORWriter::CBOR_TRUE: {
+			return m_handler->onBoolean(true);
+		}
+		case CBORWriter::CBOR_NULL:
+		case CBORWriter::CBOR_UNDEFINED: {
+			return m_handler->onNull();
+		}
+		case CBORWriter::CBOR_HALF:
+		case CBORWriter::CBOR_FLOAT:
+		case CBORWriter::CBOR_DOUBLE: {
+			return parseFloat(initial);
+		}
+	}
+	Logger::error("CBOR content has a simple value that has no JSON equivalent");
+	return false;
+}
+
+bool CBORParser::push(const char* cbor, size_t length) {
+	m_pushContent->append(cbor, length);
+	return true;
+}
+
+/*
+ * Reads a big-endian unsigned integer of the given number of bytes.
+ */
+bool CBORParser::readBytes(size_t count, unsigned __int64* _value) {
+	if ((size_t)(m_end - m_current) < count) {
+		Logger::error("CBOR content ended before its value was complete");
+		return false;
+	}
+	unsigned __int64 result = 0;
+	for (size_t i = 0; i < count; i++) {
+		result = (result << 8) | (unsigned char)m_current[i];
+	}
+	m_current += count;
+	*_value = result;
+	return true;
+}
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+#include "IJSONHandler.h"
+#include "Logger.h"
+
+/*
+ * Parses CBOR (RFC 7049) content, reporting it to an IJSONHandler in the
+ * same way that JSONParser reports JSON content, so that a handler does not
+ * need to know which encoding a packet was received in.  Only data items
+ * that have a JSON equivalent are accepted: byte strings, map keys that are
+ * not text strings and unassigned simple values cause the parse to fail,
+ * tags are ignored, and undefined is reported as null.
+ */
+class CBORParser {
+
+public:
+	CBORParser();
+	~CBORParser();
+	void beginPush(IJSONHandler* handler);
+	bool endPush();
+	bool parse(const char* cbor, size_t length, IJSONHandler* handler);
+	bool push(const char* cbor, size_t length);
+
+private:
+	bool parseArgument(unsigned char info, unsigned __int64* _value);
+	bool parseContainer(unsigned char initial, int depth);
+	bool parseFloat(unsigned char initial);
+	bool parseText(unsigned char initial, std::string* target);
+	bool parseValue(int depth);
+	bool readBytes(size_t count, unsigned __int64* _value);
+
+	const char* m_current;
+	const char* m_end;
+	IJSONHandler* m_handler;
+	std::string* m_pushContent;
+	IJSONHandler* m_pushHandler;
+	std::string* m_string;
+
+	/* constants */
+	static const int MAX_DEPTH;
+};
@@ -0,0 +1,185 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "CBORWriter.h"
+
+#include <math.h>
+
+/* initialize constants */
+const char* CBORWriter::VALUE_UNDEFINED = "undefined";
+
+CBORWriter::CBORWriter() : PacketWriter() {
+}
+
+CBORWriter::~CBORWriter() {
+}
+
+void CBORWriter::beginObject() {
+	m_buffer->push_back((char)(MAJOR_MAP | CBOR_INDEFINITE));
+}
+
+void CBORWriter::endObject() {
+	m_buffer->push_back((char)CBOR_BREAK);
+}
+
+void CBORWriter::write(Value* value) {
+	switch (value->getType()) {
+		case TYPE_NULL: {
+			writeNull();
+			break;
+		}
+		case TYPE_BOOLEAN: {
+			writeBoolean(value->getBooleanValue());
+			break;
+		}
+		case TYPE_NUMBER: {
+			writeNumber(value->getNumberValue());
+			break;
+		}
+		case TYPE_STRING: {
+			writeString(value->getStringValue(), value->getStringLength());
+			break;
+		}
+		case TYPE_ARRAY: {
+			size_t size = value->getArraySize();
+			writeHead(MAJOR_ARRAY, size);
+			for (size_t index = 0; index < size; index++) {
+				write(value->peekArrayValueAt(index));
+			}
+			break;
+		}
+		case TYPE_OBJECT: {
+			size_t size = value->getObjectSize();
+			writeHead(MAJOR_MAP, size);
+			for (size_t index = 0; index < size; index++) {
+				const std::string* key = value->getObjectKeyAt(index);
+				writeText(key->c_str(), key->length());
+				beginMember(key);
+				write(value->peekObjectValueAt(index));
+				endMember();
+			}
+			break;
+		}
+		default: {
+			/* TYPE_UNDEFINED, written as JSON packets write it */
+			writeString(VALUE_UNDEFINED);
+			break;
+		}
+	}
+}
+
+void CBORWriter::writeBoolean(bool value) {
+	m_buffer->push_back((char)(value ? CBOR_TRUE : CBOR_FALSE));
+}
+
+/*
+ * Writes the initial byte of a data item followed by its argument (a value,
+ * length or count) in the fewest bytes that hold it, most significant first.
+ */
+void CBORWriter::writeHead(unsigned char major, unsigned __int64 argument) {
+	char head[9];
+	size_t length = 0;
+	if (argument < 24) {
+		head[0] = (char)(major | argument);
+		length = 1;
+	} else if (argument <= 0xFF) {
+		head[0] = (char)(major | 24);
+		length = 2;
+	} else if (argument <= 0xFFFF) {
+		head[0] = (char)(major | 25);
+		length = 3;
+	} else if (argument <= 0xFFFFFFFF) {
+		head[0] = (char)(major | 26);
+		length = 5;
+	} else {
+		head[0] = (char)(major | 27);
+		length = 9;
+	}
+	for (size_t i = length - 1; i > 0; i--) {
+		head[i] = (char)(argument & 0xFF);
+		argument >>= 8;
+	}
+	m_buffer->append(head, length);
+}
+
+void CBORWriter::writeKey(ValueAtom* key) {
+	writeText(key->getChars(), key->getLength());
+	setMember(key);
+}
+
+void CBORWriter::writeNull() {
+	m_buffer->push_back((char)CBOR_NULL);
+}
+
+/*
+ * Integral numbers are written as integers, and others as single-precision
+ * floats if this does not lose precision, or as double-precision floats if
+ * it does.  Negative zero is written as a float so that its sign is kept.
+ */
+void CBORWriter::writeNumber(double value) {
+	static const double TWO_TO_64 = 18446744073709551616.0;
+	if (value == floor(value) && -TWO_TO_64 < value && value < TWO_TO_64) {
+		if (0 < value || (value == 0 && 1 / value > 0)) {
+			writeHead(MAJOR_UNSIGNED, (unsigned __int64)value);
+			return;
+		}
+		if (value < 0) {
+			writeHead(MAJOR_NEGATIVE, (unsigned __int64)-value - 1);
+			return;
+		}
+	}
+
+	float single = (float)value;
+	if ((double)single == value) {
+		unsigned int bits = 0;
+		memcpy(&bits, &single, sizeof(bits));
+		char chars[5] = {(char)CBOR_FLOAT};
+		for (int i = 4; i > 0; i--) {
+			chars[i] = (char)(bits & 0xFF);
+			bits >>= 8;
+		}
+		m_buffer->append(chars, 5);
+		return;
+	}
+
+	unsigned __int64 bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	char chars[9] = {(char)CBOR_DOUBLE};
+	for (int i = 8; i > 0; i--) {
+		chars[i] = (char)(bits & 0xFF);
+		bits >>= 8;
+	}
+	m_buffer->append(chars, 9);
+}
+
+void CBORWriter::writeString(const char* value) {
+	writeString(value, strlen(value));
+}
+
+void CBORWriter::writeString(std::string* value) {
+	writeString(value->c_str(), value->length());
+}
+
+void CBORWriter::writeString(const char* chars, size_t length) {
+	unsigned int id = 0;
+	if (findStringId(chars, length, &id)) {
+		writeHead(MAJOR_UNSIGNED, id);
+		return;
+	}
+	writeText(chars, length);
+}
+
+void CBORWriter::writeText(const char* chars, size_t length) {
+	writeHead(MAJOR_TEXT, length);
+	m_buffer->append(chars, length);
+}
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+#include "PacketWriter.h"
+#include "Value.h"
+
+/*
+ * Writes packet content as CBOR (RFC 7049), for clients that request it in
+ * their handshake.  The packet schema is the same as for JSON, but numbers
+ * and booleans take at most nine bytes, integral numbers are written as
+ * integers, and strings are written as a length followed by their UTF-8
+ * bytes without being scanned for characters to escape.
+ *
+ * Objects whose members are written one at a time are written as maps of
+ * indefinite length, since the number of members is not known in advance.
+ */
+class CBORWriter : public PacketWriter {
+
+public:
+	CBORWriter();
+	virtual ~CBORWriter();
+	virtual void beginObject();
+	virtual void endObject();
+	virtual void write(Value* value);
+	virtual void writeBoolean(bool value);
+	virtual void writeKey(ValueAtom* key);
+	virtual void writeNull();
+	virtual void writeNumber(double value);
+	virtual void writeString(const char* value);
+	virtual void writeString(std::string* value);
+	virtual void writeString(const char* chars, size_t length);
+
+	/* major types */
+	enum {
+		MAJOR_UNSIGNED = 0x00,
+		MAJOR_NEGATIVE = 0x20,
+		MAJOR_BYTES = 0x40,
+		MAJOR_TEXT = 0x60,
+		MAJOR_ARRAY = 0x80,
+		MAJOR_MAP = 0xA0,
+		MAJOR_TAG = 0xC0,
+		MAJOR_SIMPLE = 0xE0,
+	};
+
+	/* initial bytes */
+	enum {
+		CBOR_FALSE = 0xF4,
+		CBOR_TRUE = 0xF5,
+		CBOR_NULL = 0xF6,
+		CBOR_UNDEFINED = 0xF7,
+		CBOR_HALF = 0xF9,
+		CBOR_FLOAT = 0xFA,
+		CBOR_DOUBLE = 0xFB,
+		CBOR_BREAK = 0xFF,
+		CBOR_INDEFINITE = 0x1F,
+	};
+
+private:
+	void writeHead(unsigned char major, unsigned __int64 argument);
+	void writeText(const char* chars, size_t length);
+
+	/* constants */
+	static const char* VALUE_UNDEFINED;
+};
@@ -13,7 +13,7 @@
 #include "StdAfx.h"
 #include "CrossfireBPManager.h"
 
-const wchar_t* CrossfireBPManager::KEY_BREAKPOINTS = L"breakpoints";
+ValueAtom* CrossfireBPManager::KEY_BREAKPOINTS = ValueAtom::intern("breakpoints");
 
 CrossfireBPManager::CrossfireBPManager() {
 	m_breakpoints = new std::map<unsigned int, CrossfireBreakpoint*>;
@@ -30,7 +30,7 @@ CrossfireBPManager::~CrossfireBPManager() {
 
 /* IBreakpointTarget */
 
-bool CrossfireBPManager::breakpointAttributeChanged(unsigned int handle, wchar_t* name, Value* value) {
+bool CrossfireBPManager::breakpointAttributeChanged(unsigned int handle, char* name, Value* value) {
 	/* no further action required since this object just stores the breakpoint data */
 	return true;
 }
@@ -90,29 +90,27 @@ bool CrossfireBPManager::setBreakpoint(CrossfireBreakpoint *breakpoint) {
 
 /* CrossfireBPManager */
 
-int CrossfireBPManager::commandChangeBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, wchar_t** _message) {
+int CrossfireBPManager::commandChangeBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, char** _message) {
 	*_responseBody = NULL;
 
 	Value* value_handles = arguments->getObjectValue(CrossfireBreakpoint::KEY_HANDLES);
 	if (!value_handles || value_handles->getType() != TYPE_ARRAY) {
-		*_message = _wcsdup(L"'changeBreakpoints' command does not have a valid 'handles' value");
+		*_message = _strdup("'changeBreakpoints' command does not have a valid 'handles' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
 	Value* value_attributes = arguments->getObjectValue(CrossfireBreakpoint::KEY_ATTRIBUTES);
 	if (!value_attributes || value_attributes->getType() != TYPE_OBJECT) {
-		*_message = _wcsdup(L"'changeBreakpoints' command does not have a valid 'attributes' value");
+		*_message = _strdup("'changeBreakpoints' command does not have a valid 'attributes' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
 	int code = CODE_OK;
-	Value** handles = NULL;
-	value_handles->getArrayValues(&handles);
-	int handlesIndex = 0;
-	Value* value_handle = handles[handlesIndex++];
-	while (value_handle) {
+	size_t handlesSize = value_handles->getArraySize();
+	for (size_t handlesIndex = 0; handlesIndex < handlesSize; handlesIndex++) {
+		Value* value_handle = value_handles->getArrayValueAt(handlesIndex);
 		if (value_handle->getType() != TYPE_NUMBER || value_handle->getNumberValue() < 1) {
-			*_message = _wcsdup(L"'changeBreakpoints' command specifies an invalid handle value");
+			*_message = _strdup("'changeBreakpoints' command specifies an invalid handle value");
 			code = CODE_INVALID_ARGUMENT;
 			break;
 		}
@@ -121,31 +119,27 @@ int CrossfireBPManager::commandChangeBreakpoints(Value* arguments, IBreakpointTa
 		unsigned int handle = (unsigned int)value_handle->getNumberValue();
 		CrossfireBreakpoint* breakpoint = getBreakpoint(handle);
 		if (!breakpoint) {
-			*_message = _wcsdup(L"'changeBreakpoints' command specifies an unknown breakpoint handle");
+			*_message = _strdup("'changeBreakpoints' command specifies an unknown breakpoint handle");
 			code = CODE_COMMAND_FAILED;
 			break;
 		}
 
 		/* ensure that all attributes can be applied to the current breakpoint */
 		if (!breakpoint->attributesValueIsValid(value_attributes)) {
-			*_message = _wcsdup(L"'changeBreakpoints' command specifies an invalid breakpoint attribute");
+			*_message = _strdup("'changeBreakpoints' command specifies an invalid breakpoint attribute");
 			code = CODE_COMMAND_FAILED;
 			break;
 		}
-
-		value_handle = handles[handlesIndex++];
 	}
 
 	if (code != CODE_OK) {
-		delete[] handles;
 		return code;
 	}
 
 	/* the request is valid, so now perform the changes */
 
-	handlesIndex = 0;
-	value_handle = handles[handlesIndex++];
-	while (value_handle) {
+	for (size_t handlesIndex = 0; handlesIndex < handlesSize; handlesIndex++) {
+		Value* value_handle = value_handles->getArrayValueAt(handlesIndex);
 		unsigned int handle = (unsigned int)value_handle->getNumberValue();
 		CrossfireBreakpoint* breakpoint = getBreakpoint(handle);
 		breakpoint->setAttributesFromValue(value_attributes);
@@ -162,10 +156,7 @@ int CrossfireBPManager::commandChangeBreakpoints(Value* arguments, IBreakpointTa
 				target = targets[targetsIndex++];
 			}
 		}
-
-		value_handle = handles[handlesIndex++];
 	}
-	delete[] handles;
 
 	Value* result = new Value();
 	result->setType(TYPE_OBJECT);
@@ -173,23 +164,20 @@ int CrossfireBPManager::commandChangeBreakpoints(Value* arguments, IBreakpointTa
 	return CODE_OK;
 }
 
-int CrossfireBPManager::commandDeleteBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, wchar_t** _message) {
+int CrossfireBPManager::commandDeleteBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, char** _message) {
 	*_responseBody = NULL;
 
 	Value* value_handles = arguments->getObjectValue(CrossfireBreakpoint::KEY_HANDLES);
 	if (!value_handles || value_handles->getType() != TYPE_ARRAY) {
-		*_message = _wcsdup(L"'deleteBreakpoints' command does not have a valid 'handles' value");
+		*_message = _strdup("'deleteBreakpoints' command does not have a valid 'handles' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
-	Value** handles = NULL;
-	value_handles->getArrayValues(&handles);
-	int index = 0;
-	Value* value_current = handles[index++];
-	while (value_current) {
+	size_t size = value_handles->getArraySize();
+	for (size_t index = 0; index < size; index++) {
+		Value* value_current = value_handles->getArrayValueAt(index);
 		if (value_current->getType() != TYPE_NUMBER || (unsigned int)value_current->getNumberValue() < 1) {
-			*_message = _wcsdup(L"'deleteBreakpoints' command specifies an invalid handle value");
-			delete[] handles;
+			*_message = _strdup("'deleteBreakpoints' command specifies an invalid handle value");
 			return CODE_INVALID_ARGUMENT;
 		}
 
@@ -198,18 +186,15 @@ int CrossfireBPManager::commandDeleteBreakpoints(Value* arguments, IBreakpointTa
 		/* look up the breakpoint in the local breakpoints table to ensure that the handle is valid */
 		std::map<unsigned int, CrossfireBreakpoint*>::iterator iterator = m_breakpoints->find(handle);
 		if (iterator == m_breakpoints->end()) {
-			*_message = _wcsdup(L"'deleteBreakpoints' command specifies an unknown breakpoint handle");
-			delete[] handles;
+			*_message = _strdup("'deleteBreakpoints' command specifies an unknown breakpoint handle");
 			return CODE_COMMAND_FAILED;
 		}
-		value_current = handles[index++];
 	}
 
 	/* the request is valid, so now perform the deletions */
 
-	index = 0;
-	value_current = handles[index++];
-	while (value_current) {
+	for (size_t index = 0; index < size; index++) {
+		Value* value_current = value_handles->getArrayValueAt(index);
 		unsigned int handle = (unsigned int)value_current->getNumberValue();
 		deleteBreakpoint(handle); /* delete from the global table */
 
@@ -225,9 +210,7 @@ int CrossfireBPManager::commandDeleteBreakpoints(Value* arguments, IBreakpointTa
 				current = targets[targetsIndex++];
 			}
 		}
-		value_current = handles[index++];
 	}
-	delete[] handles;
 
 	Value* result = new Value();
 	result->setType(TYPE_OBJECT);
@@ -235,20 +218,18 @@ int CrossfireBPManager::commandDeleteBreakpoints(Value* arguments, IBreakpointTa
 	return CODE_OK;
 }
 
-int CrossfireBPManager::commandGetBreakpoints(Value* arguments, IBreakpointTarget* target, Value** _responseBody, wchar_t** _message) {
+int CrossfireBPManager::commandGetBreakpoints(Value* arguments, IBreakpointTarget* target, Value** _responseBody, char** _message) {
 	CrossfireBreakpoint** breakpoints = NULL;
 	Value* value_handles = arguments->getObjectValue(CrossfireBreakpoint::KEY_HANDLES);
 	if (value_handles) {
 		if (value_handles->getType() != TYPE_ARRAY) {
-			*_message = _wcsdup(L"'getBreakpoints' command has an invalid 'handles' value");
+			*_message = _strdup("'getBreakpoints' command has an invalid 'handles' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		std::vector<CrossfireBreakpoint*> breakpointsCollection;
-		Value** handles = NULL;
-		value_handles->getArrayValues(&handles);
-		int index = 0;
-		Value* value_current = handles[index++];
-		while (value_current) {
+		size_t size = value_handles->getArraySize();
+		for (size_t index = 0; index < size; index++) {
+			Value* value_current = value_handles->getArrayValueAt(index);
 			if (value_current->getType() == TYPE_NUMBER && value_current->getNumberValue() > 0) {
 				unsigned int handle = (unsigned int)value_current->getNumberValue();
 				CrossfireBreakpoint* breakpoint = target->getBreakpoint(handle);
@@ -256,9 +237,7 @@ int CrossfireBPManager::commandGetBreakpoints(Value* arguments, IBreakpointTarge
 					breakpointsCollection.push_back(breakpoint);
 				}
 			}
-			value_current = handles[index++];
 		}
-		delete[] handles;
 
 		int length = breakpointsCollection.size();
 		breakpoints = new CrossfireBreakpoint*[length + 1];
@@ -270,15 +249,14 @@ int CrossfireBPManager::commandGetBreakpoints(Value* arguments, IBreakpointTarge
 		target->getBreakpoints(&breakpoints);
 	}
 
-	Value breakpointsArray;
-	breakpointsArray.setType(TYPE_ARRAY);
+	Value* breakpointsArray = new Value();
+	breakpointsArray->setType(TYPE_ARRAY);
 	int index = 0;
 	while (breakpoints[index]) {
 		CrossfireBreakpoint* current = breakpoints[index];
 		Value* value_breakpoint = NULL;
 		if (current->toValueObject(&value_breakpoint)) {
-			breakpointsArray.addArrayValue(value_breakpoint);
-			delete value_breakpoint;
+			breakpointsArray->adoptArrayValue(value_breakpoint);
 		}
 		delete current;
 		index++;
@@ -286,41 +264,36 @@ int CrossfireBPManager::commandGetBreakpoints(Value* arguments, IBreakpointTarge
 	delete[] breakpoints;
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_BREAKPOINTS, &breakpointsArray);
+	result->adoptObjectValue(KEY_BREAKPOINTS, breakpointsArray);
 	*_responseBody = result;
 	return CODE_OK;
 }
 
-int CrossfireBPManager::commandSetBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, wchar_t** _message) {
+int CrossfireBPManager::commandSetBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, char** _message) {
 	*_responseBody = NULL;
 
 	Value* value_breakpoints = arguments->getObjectValue(KEY_BREAKPOINTS);
 	if (!value_breakpoints || value_breakpoints->getType() != TYPE_ARRAY) {
-		*_message = _wcsdup(L"'setBreakpoints' command does not have a valid 'breakpoints' value");
+		*_message = _strdup("'setBreakpoints' command does not have a valid 'breakpoints' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
 	std::vector<CrossfireBreakpoint*> bpObjects;
 
-	Value** breakpoints = NULL;
-	value_breakpoints->getArrayValues(&breakpoints);
-	int index = 0;
-	Value* current = breakpoints[index++];
 	int code = CODE_OK;
-	while (current) {
+	size_t size = value_breakpoints->getArraySize();
+	for (size_t index = 0; index < size; index++) {
 		CrossfireBreakpoint* breakpoint = NULL;
-		code = createBreakpoint(current, &breakpoint, _message);
+		code = createBreakpoint(value_breakpoints->getArrayValueAt(index), &breakpoint, _message);
 		if (code != CODE_OK) {
 			break;
 		}
 		bpObjects.push_back(breakpoint);
-		current = breakpoints[index++];
 	}
-	delete[] breakpoints;
 
 	if (code == CODE_OK) {
-		Value value_array;
-		value_array.setType(TYPE_ARRAY);
+		Value* value_array = new Value();
+		value_array->setType(TYPE_ARRAY);
 
 		std::vector<CrossfireBreakpoint*>::iterator iterator = bpObjects.begin();
 		while (iterator != bpObjects.end()) {
@@ -350,53 +323,52 @@ int CrossfireBPManager::commandSetBreakpoints(Value* arguments, IBreakpointTarge
 
 			Value* value_breakpoint = NULL;
 			breakpoint->toValueObject(&value_breakpoint);
-			value_array.addArrayValue(value_breakpoint);
-			delete value_breakpoint;
+			value_array->adoptArrayValue(value_breakpoint);
 			delete *iterator;
 			iterator++;
 		}
 
 		Value* result = new Value();
-		result->addObjectValue(KEY_BREAKPOINTS, &value_array);
+		result->adoptObjectValue(KEY_BREAKPOINTS, value_array);
 		*_responseBody = result;
 	}
 
 	return code;
 }
 
-int CrossfireBPManager::createBreakpoint(Value* arguments, CrossfireBreakpoint** _result, wchar_t** _message) {
+int CrossfireBPManager::createBreakpoint(Value* arguments, CrossfireBreakpoint** _result, char** _message) {
 	*_result = NULL;
 
 	Value* value_type = arguments->getObjectValue(CrossfireBreakpoint::KEY_TYPE);
 	if (!value_type || value_type->getType() != TYPE_STRING) {
-		*_message = _wcsdup(L"breakpoint creation arguments do not have a valid 'type' value");
+		*_message = _strdup("breakpoint creation arguments do not have a valid 'type' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
 	Value* value_attributes = arguments->getObjectValue(CrossfireBreakpoint::KEY_ATTRIBUTES);
 	if (value_attributes && value_attributes->getType() != TYPE_OBJECT) {
-		*_message = _wcsdup(L"breakpoint creation arguments have an invalid 'attributes' value");
+		*_message = _strdup("breakpoint creation arguments have an invalid 'attributes' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
 	Value* value_location = arguments->getObjectValue(CrossfireBreakpoint::KEY_LOCATION);
 	if (!value_location || value_location->getType() != TYPE_OBJECT) {
-		*_message = _wcsdup(L"breakpoint creation arguments do not have a valid 'location' value");
+		*_message = _strdup("breakpoint creation arguments do not have a valid 'location' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
 	CrossfireBreakpoint* breakpoint = NULL;
-	wchar_t* type = (wchar_t*)value_type->getStringValue()->c_str();
+	char* type = (char*)value_type->getStringValue();
 	if (CrossfireLineBreakpoint::CanHandleBPType(type)) {
 		breakpoint = new CrossfireLineBreakpoint();
 	} else {
-		*_message = _wcsdup(L"breakpoint creation arguments specify an unknown 'type' value");
+		*_message = _strdup("breakpoint creation arguments specify an unknown 'type' value");
 		return CODE_COMMAND_FAILED;
 	}
 
 	if (value_attributes) {
 		if (!breakpoint->attributesValueIsValid(value_attributes)) {
-			*_message = _wcsdup(L"breakpoint creation arguments specify an invalid attribute name or value");
+			*_message = _strdup("breakpoint creation arguments specify an invalid attribute name or value");
 			delete breakpoint;
 			return CODE_COMMAND_FAILED;
 		}
@@ -404,7 +376,7 @@ int CrossfireBPManager::createBreakpoint(Value* arguments, CrossfireBreakpoint**
 	}
 
 	if (!breakpoint->setLocationFromValue(value_location)) {
-		*_message = _wcsdup(L"breakpoint creation arguments do not validly specify a location");
+		*_message = _strdup("breakpoint creation arguments do not validly specify a location");
 		delete breakpoint;
 		return CODE_COMMAND_FAILED;
 	}
@@ -26,23 +26,23 @@ public:
 	CrossfireBPManager();
 	virtual ~CrossfireBPManager();
 
-	int commandChangeBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, wchar_t** _message);
-	int commandDeleteBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, wchar_t** _message);
-	int commandGetBreakpoints(Value* arguments, IBreakpointTarget* target, Value** _responseBody, wchar_t** _message);
-	int commandSetBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, wchar_t** _message);
+	int commandChangeBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, char** _message);
+	int commandDeleteBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, char** _message);
+	int commandGetBreakpoints(Value* arguments, IBreakpointTarget* target, Value** _responseBody, char** _message);
+	int commandSetBreakpoints(Value* arguments, IBreakpointTarget** targets, Value** _responseBody, char** _message);
 	void setBreakpointsForScript(URL* url, IBreakpointTarget* target);
 
 	/* IBreakpointTarget methods */
-	bool breakpointAttributeChanged(unsigned int handle, wchar_t* name, Value* value);
+	bool breakpointAttributeChanged(unsigned int handle, char* name, Value* value);
 	bool deleteBreakpoint(unsigned int handle);
 	CrossfireBreakpoint* getBreakpoint(unsigned int handle);
 	void getBreakpoints(CrossfireBreakpoint*** ___values);
 	bool setBreakpoint(CrossfireBreakpoint* breakpoint);
 
 private:
-	int createBreakpoint(Value* arguments, CrossfireBreakpoint** _result, wchar_t** _message);
+	int createBreakpoint(Value* arguments, CrossfireBreakpoint** _result, char** _message);
 
 	std::map<unsigned int, CrossfireBreakpoint*>* m_breakpoints;
 
-	static const wchar_t* KEY_BREAKPOINTS;
+	static ValueAtom* KEY_BREAKPOINTS;
 };
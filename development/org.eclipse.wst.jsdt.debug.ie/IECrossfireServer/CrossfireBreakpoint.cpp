@@ -14,30 +14,30 @@
 #include "CrossfireBreakpoint.h"
 
 /* initialize constants */
-const wchar_t* CrossfireBreakpoint::KEY_ATTRIBUTES = L"attributes";
-const wchar_t* CrossfireBreakpoint::KEY_CONTEXTID = L"contextId";
-const wchar_t* CrossfireBreakpoint::KEY_HANDLE = L"handle";
-const wchar_t* CrossfireBreakpoint::KEY_HANDLES = L"handles";
-const wchar_t* CrossfireBreakpoint::KEY_LOCATION = L"location";
-const wchar_t* CrossfireBreakpoint::KEY_TYPE = L"type";
+ValueAtom* CrossfireBreakpoint::KEY_ATTRIBUTES = ValueAtom::intern("attributes");
+ValueAtom* CrossfireBreakpoint::KEY_CONTEXTID = ValueAtom::intern("contextId");
+ValueAtom* CrossfireBreakpoint::KEY_HANDLE = ValueAtom::intern("handle");
+ValueAtom* CrossfireBreakpoint::KEY_HANDLES = ValueAtom::intern("handles");
+ValueAtom* CrossfireBreakpoint::KEY_LOCATION = ValueAtom::intern("location");
+ValueAtom* CrossfireBreakpoint::KEY_TYPE = ValueAtom::intern("type");
 
 CrossfireBreakpoint::CrossfireBreakpoint() {
 	static unsigned int s_nextBreakpointHandle = 1;
-	m_attributes = new std::map<std::wstring, Value*>;
+	m_attributes = new std::map<std::string, Value*>;
 	m_contextId = NULL;
 	m_handle = s_nextBreakpointHandle++;
 	m_target = NULL;
 }
 
 CrossfireBreakpoint::CrossfireBreakpoint(unsigned int handle) {
-	m_attributes = new std::map<std::wstring, Value*>;
+	m_attributes = new std::map<std::string, Value*>;
 	m_contextId = NULL;
 	m_handle = handle;
 	m_target = NULL;
 }
 
 CrossfireBreakpoint::~CrossfireBreakpoint() {
-	std::map<std::wstring, Value*>::iterator iterator = m_attributes->begin();
+	std::map<std::string, Value*>::iterator iterator = m_attributes->begin();
 	while (iterator != m_attributes->end()) {
 		delete iterator->second;
 		iterator++;
@@ -57,38 +57,28 @@ bool CrossfireBreakpoint::attributesValueIsValid(Value* attributes) {
 		return false;
 	}
 
-	std::wstring** keys = NULL;
-	Value** values = NULL;
-	attributes->getObjectValues(&keys, &values);
-	bool success = true;
-	int index = 0;
-	std::wstring* currentKey = keys[index];
-	while (currentKey) {
-		Value* currentValue = values[index];
-		if (!attributeIsValid((wchar_t*)currentKey->c_str(), currentValue)) {
-			success = false;
-			break;
+	size_t size = attributes->getObjectSize();
+	for (size_t index = 0; index < size; index++) {
+		const std::string* currentKey = attributes->getObjectKeyAt(index);
+		if (!attributeIsValid((char*)currentKey->c_str(), attributes->getObjectValueAt(index))) {
+			return false;
 		}
-		currentKey = keys[++index];
 	}
-
-	delete[] keys;
-	delete[] values;
-	return success;
+	return true;
 }
 
 void CrossfireBreakpoint::breakpointHit() {
 }
 
-Value* CrossfireBreakpoint::getAttribute(wchar_t* name) {
-	std::map<std::wstring, Value*>::iterator iterator = m_attributes->find(std::wstring(name));
+Value* CrossfireBreakpoint::getAttribute(char* name) {
+	std::map<std::string, Value*>::iterator iterator = m_attributes->find(std::string(name));
 	if (iterator == m_attributes->end()) {
 		return NULL;
 	}
 	return iterator->second;
 }
 
-const std::wstring* CrossfireBreakpoint::getContextId() {
+const std::string* CrossfireBreakpoint::getContextId() {
 	return m_contextId;
 }
 
@@ -100,8 +90,8 @@ IBreakpointTarget* CrossfireBreakpoint::getTarget() {
 	return m_target;
 }
 
-void CrossfireBreakpoint::setAttribute(wchar_t* name, Value* value) {
-	std::map<std::wstring, Value*>::iterator iterator = m_attributes->find(std::wstring(name));
+void CrossfireBreakpoint::setAttribute(char* name, Value* value) {
+	std::map<std::string, Value*>::iterator iterator = m_attributes->find(std::string(name));
 	if (iterator != m_attributes->end()) {
 		if (iterator->second->equals(value)) {
 			return;
@@ -117,34 +107,27 @@ void CrossfireBreakpoint::setAttribute(wchar_t* name, Value* value) {
 
 	Value* valueCopy = NULL;
 	value->clone(&valueCopy);
-	m_attributes->insert(std::pair<std::wstring, Value*>(std::wstring(name), valueCopy));
+	m_attributes->insert(std::pair<std::string, Value*>(std::string(name), valueCopy));
 	if (m_target) {
 		m_target->breakpointAttributeChanged(m_handle, name, value);
 	}
 }
 
 void CrossfireBreakpoint::setAttributesFromValue(Value* value) {
-	std::wstring** objectKeys = NULL;
-	Value** objectValues = NULL;
-	value->getObjectValues(&objectKeys, &objectValues);
-	int index = 0;
-	std::wstring* currentKey = objectKeys[index];
-	while (currentKey) {
-		setAttribute((wchar_t*)currentKey->c_str(), objectValues[index]);
-		currentKey = objectKeys[++index];
+	size_t size = value->getObjectSize();
+	for (size_t index = 0; index < size; index++) {
+		const std::string* currentKey = value->getObjectKeyAt(index);
+		setAttribute((char*)currentKey->c_str(), value->getObjectValueAt(index));
 	}
-
-	delete[] objectKeys;
-	delete[] objectValues;
 }
 
-void CrossfireBreakpoint::setContextId(std::wstring* value) {
+void CrossfireBreakpoint::setContextId(std::string* value) {
 	if (m_contextId) {
 		delete m_contextId;
 		m_contextId = NULL;
 	}
 	if (value) {
-		m_contextId = new std::wstring;
+		m_contextId = new std::string;
 		m_contextId->assign(*value);
 	}
 }
@@ -159,32 +142,31 @@ void CrossfireBreakpoint::setTarget(IBreakpointTarget* value) {
 
 bool CrossfireBreakpoint::toValueObject(Value** _value) {
 	Value* result = new Value();
-	result->addObjectValue(KEY_HANDLE, &Value((double)m_handle));
-	result->addObjectValue(KEY_TYPE, &Value(getTypeString()));
+	result->adoptObjectValue(KEY_HANDLE, new Value((double)m_handle));
+	result->adoptObjectValue(KEY_TYPE, new Value(getTypeString()));
 	if (!m_contextId) {
-		Value value_null;
-		value_null.setType(TYPE_NULL);
-		result->addObjectValue(KEY_CONTEXTID, &value_null);
+		Value* value_null = new Value();
+		value_null->setType(TYPE_NULL);
+		result->adoptObjectValue(KEY_CONTEXTID, value_null);
 	} else {
-		result->addObjectValue(KEY_CONTEXTID, &Value(m_contextId));
+		result->adoptObjectValue(KEY_CONTEXTID, new Value(m_contextId));
 	}
 
-	Value value_attributes;
-	value_attributes.setType(TYPE_OBJECT);
-	std::map<std::wstring, Value*>::iterator iterator = m_attributes->begin();
+	Value* value_attributes = new Value();
+	value_attributes->setType(TYPE_OBJECT);
+	std::map<std::string, Value*>::iterator iterator = m_attributes->begin();
 	while (iterator != m_attributes->end()) {
-		value_attributes.addObjectValue((std::wstring*)&iterator->first, iterator->second);
+		value_attributes->addObjectValue((std::string*)&iterator->first, iterator->second);
 		iterator++;
 	}
-	result->addObjectValue(KEY_ATTRIBUTES, &value_attributes);
+	result->adoptObjectValue(KEY_ATTRIBUTES, value_attributes);
 
 	Value* value_location = NULL;
 	if (!getLocationAsValue(&value_location)) {
 		delete result;
 		return false;
 	}
-	result->addObjectValue(KEY_LOCATION, value_location);
-	delete value_location;
+	result->adoptObjectValue(KEY_LOCATION, value_location);
 
 	*_value = result;
 	return true;
@@ -27,39 +27,39 @@ public:
 	virtual bool attributesValueIsValid(Value* attributes);
 	virtual void breakpointHit();
 	virtual void clone(CrossfireBreakpoint** _value) = 0;
-	virtual const std::wstring* getContextId();
+	virtual const std::string* getContextId();
 	virtual unsigned int getHandle();
 	virtual IBreakpointTarget* getTarget();
 	virtual int getType() = 0;
 	virtual bool matchesLocation(CrossfireBreakpoint* breakpoint) = 0;
 	virtual void setAttributesFromValue(Value* value);
-	virtual void setContextId(std::wstring* value);
+	virtual void setContextId(std::string* value);
 	virtual void setHandle(unsigned int value);
 	virtual bool setLocationFromValue(Value* value) = 0;
 	virtual void setTarget(IBreakpointTarget* value);
 	virtual bool toValueObject(Value** _value);
 
 	static const int BPTYPE_LINE = 1;
-	static const wchar_t* KEY_ATTRIBUTES;
-	static const wchar_t* KEY_CONTEXTID;
-	static const wchar_t* KEY_HANDLE;
-	static const wchar_t* KEY_HANDLES;
-	static const wchar_t* KEY_LOCATION;
-	static const wchar_t* KEY_TYPE;
+	static ValueAtom* KEY_ATTRIBUTES;
+	static ValueAtom* KEY_CONTEXTID;
+	static ValueAtom* KEY_HANDLE;
+	static ValueAtom* KEY_HANDLES;
+	static ValueAtom* KEY_LOCATION;
+	static ValueAtom* KEY_TYPE;
 
 protected:
 	CrossfireBreakpoint();
 	CrossfireBreakpoint(unsigned int handle);
-	virtual bool attributeIsValid(wchar_t* name, Value* value) = 0;
-	virtual Value* getAttribute(wchar_t* name);
+	virtual bool attributeIsValid(char* name, Value* value) = 0;
+	virtual Value* getAttribute(char* name);
 	virtual bool getLocationAsValue(Value** _value) = 0;
-	virtual const wchar_t* getTypeString() = 0;
-	virtual void setAttribute(wchar_t* name, Value* value);
+	virtual const char* getTypeString() = 0;
+	virtual void setAttribute(char* name, Value* value);
 
 	unsigned int m_handle;
 
 private:
-	std::map<std::wstring, Value*>* m_attributes;
-	std::wstring* m_contextId;
+	std::map<std::string, Value*>* m_attributes;
+	std::string* m_contextId;
 	IBreakpointTarget* m_target;
 };
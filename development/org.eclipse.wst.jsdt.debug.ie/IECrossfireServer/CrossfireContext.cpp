@@ -14,109 +14,110 @@
 #include "CrossfireContext.h"
 
 #include "JSONParser.h"
+#include "UTF8Transcoder.h"
 
 /* initialize constants */
 const wchar_t* CrossfireContext::ABOUT_BLANK = L"about:blank";
-const wchar_t* CrossfireContext::ID_PREAMBLE = L"xfIE::";
+const char* CrossfireContext::ID_PREAMBLE = "xfIE::";
 const wchar_t* CrossfireContext::NUMBER_NaN = L"NaN";
 const wchar_t* CrossfireContext::NUMBER_INFINITY = L"Infinity";
 const wchar_t* CrossfireContext::NUMBER_NEGATIVEINFINITY = L"-Infinity";
 const wchar_t* CrossfireContext::PDM_DLL = L"pdm.dll";
-const wchar_t* CrossfireContext::SCHEME_SCRIPT = L"script://";
-const wchar_t* CrossfireContext::VALUE_NaN = L"NaN";
-const wchar_t* CrossfireContext::VALUE_INFINITY = L"Infinity";
-const wchar_t* CrossfireContext::VALUE_NEGATIVEINFINITY = L"-Infinity";
+const char* CrossfireContext::SCHEME_SCRIPT = "script://";
+const char* CrossfireContext::VALUE_NaN = "NaN";
+const char* CrossfireContext::VALUE_INFINITY = "Infinity";
+const char* CrossfireContext::VALUE_NEGATIVEINFINITY = "-Infinity";
 
 /* command: backtrace */
-const wchar_t* CrossfireContext::COMMAND_BACKTRACE = L"backtrace";
-const wchar_t* CrossfireContext::KEY_FRAMES = L"frames";
-const wchar_t* CrossfireContext::KEY_FROMFRAME = L"fromFrame";
-const wchar_t* CrossfireContext::KEY_TOFRAME = L"toFrame";
-const wchar_t* CrossfireContext::KEY_TOTALFRAMES = L"totalFrames";
+const char* CrossfireContext::COMMAND_BACKTRACE = "backtrace";
+ValueAtom* CrossfireContext::KEY_FRAMES = ValueAtom::intern("frames");
+ValueAtom* CrossfireContext::KEY_FROMFRAME = ValueAtom::intern("fromFrame");
+ValueAtom* CrossfireContext::KEY_TOFRAME = ValueAtom::intern("toFrame");
+ValueAtom* CrossfireContext::KEY_TOTALFRAMES = ValueAtom::intern("totalFrames");
 
 /* command: continue */
-const wchar_t* CrossfireContext::COMMAND_CONTINUE = L"continue";
+const char* CrossfireContext::COMMAND_CONTINUE = "continue";
 
 /* command: evaluate */
-const wchar_t* CrossfireContext::COMMAND_EVALUATE = L"evaluate";
-const wchar_t* CrossfireContext::KEY_EXPRESSION = L"expression";
-const wchar_t* CrossfireContext::KEY_RESULT = L"result";
+const char* CrossfireContext::COMMAND_EVALUATE = "evaluate";
+ValueAtom* CrossfireContext::KEY_EXPRESSION = ValueAtom::intern("expression");
+ValueAtom* CrossfireContext::KEY_RESULT = ValueAtom::intern("result");
 
 /* command: frame */
-const wchar_t* CrossfireContext::COMMAND_FRAME = L"frame";
-const wchar_t* CrossfireContext::KEY_FRAME = L"frame";
-const wchar_t* CrossfireContext::KEY_INDEX = L"index";
+const char* CrossfireContext::COMMAND_FRAME = "frame";
+ValueAtom* CrossfireContext::KEY_FRAME = ValueAtom::intern("frame");
+ValueAtom* CrossfireContext::KEY_INDEX = ValueAtom::intern("index");
 
 /* command: inspect */
-const wchar_t* CrossfireContext::COMMAND_INSPECT = L"inspect";
+const char* CrossfireContext::COMMAND_INSPECT = "inspect";
 
 /* command: lookup */
-const wchar_t* CrossfireContext::COMMAND_LOOKUP = L"lookup";
-const wchar_t* CrossfireContext::KEY_HANDLES = L"handles";
-const wchar_t* CrossfireContext::KEY_VALUES = L"values";
+const char* CrossfireContext::COMMAND_LOOKUP = "lookup";
+ValueAtom* CrossfireContext::KEY_HANDLES = ValueAtom::intern("handles");
+ValueAtom* CrossfireContext::KEY_VALUES = ValueAtom::intern("values");
 
 /* command: scopes */
-const wchar_t* CrossfireContext::COMMAND_SCOPES = L"scopes";
-const wchar_t* CrossfireContext::KEY_FROMSCOPE = L"fromScope";
-const wchar_t* CrossfireContext::KEY_SCOPES = L"scopes";
-const wchar_t* CrossfireContext::KEY_TOSCOPE = L"toScope";
-const wchar_t* CrossfireContext::KEY_TOTALSCOPECOUNT = L"totalScopeCount";
+const char* CrossfireContext::COMMAND_SCOPES = "scopes";
+ValueAtom* CrossfireContext::KEY_FROMSCOPE = ValueAtom::intern("fromScope");
+ValueAtom* CrossfireContext::KEY_SCOPES = ValueAtom::intern("scopes");
+ValueAtom* CrossfireContext::KEY_TOSCOPE = ValueAtom::intern("toScope");
+ValueAtom* CrossfireContext::KEY_TOTALSCOPECOUNT = ValueAtom::intern("totalScopeCount");
 
 /* command: scripts */
-const wchar_t* CrossfireContext::COMMAND_SCRIPTS = L"scripts";
-const wchar_t* CrossfireContext::KEY_SCRIPTS = L"scripts";
-const wchar_t* CrossfireContext::KEY_URLS = L"urls";
+const char* CrossfireContext::COMMAND_SCRIPTS = "scripts";
+ValueAtom* CrossfireContext::KEY_SCRIPTS = ValueAtom::intern("scripts");
+ValueAtom* CrossfireContext::KEY_URLS = ValueAtom::intern("urls");
 
 /* command: suspend */
-const wchar_t* CrossfireContext::COMMAND_SUSPEND = L"suspend";
-const wchar_t* CrossfireContext::KEY_STEPACTION = L"stepAction";
-const wchar_t* CrossfireContext::VALUE_IN = L"in";
-const wchar_t* CrossfireContext::VALUE_NEXT = L"next";
-const wchar_t* CrossfireContext::VALUE_OUT = L"out";
+const char* CrossfireContext::COMMAND_SUSPEND = "suspend";
+ValueAtom* CrossfireContext::KEY_STEPACTION = ValueAtom::intern("stepAction");
+const char* CrossfireContext::VALUE_IN = "in";
+const char* CrossfireContext::VALUE_NEXT = "next";
+const char* CrossfireContext::VALUE_OUT = "out";
 
 /* event: onBreak */
-const wchar_t* CrossfireContext::EVENT_ONBREAK = L"onBreak";
-const wchar_t* CrossfireContext::KEY_CAUSE = L"cause";
-const wchar_t* CrossfireContext::KEY_MESSAGE = L"message";
-const wchar_t* CrossfireContext::KEY_TITLE = L"title";
+const char* CrossfireContext::EVENT_ONBREAK = "onBreak";
+ValueAtom* CrossfireContext::KEY_CAUSE = ValueAtom::intern("cause");
+ValueAtom* CrossfireContext::KEY_MESSAGE = ValueAtom::intern("message");
+ValueAtom* CrossfireContext::KEY_TITLE = ValueAtom::intern("title");
 
 /* event: onError */
-const wchar_t* CrossfireContext::EVENT_ONERROR = L"onError";
-const wchar_t* CrossfireContext::KEY_CATEGORY = L"category";
-const wchar_t* CrossfireContext::KEY_COLUMNNUMBER = L"columnNumber";
-const wchar_t* CrossfireContext::KEY_ERROR = L"error";
-const wchar_t* CrossfireContext::KEY_FILENAME = L"fileName";
-const wchar_t* CrossfireContext::KEY_LINENUMBER = L"lineNumber";
-const wchar_t* CrossfireContext::VALUE_JS = L"js";
+const char* CrossfireContext::EVENT_ONERROR = "onError";
+ValueAtom* CrossfireContext::KEY_CATEGORY = ValueAtom::intern("category");
+ValueAtom* CrossfireContext::KEY_COLUMNNUMBER = ValueAtom::intern("columnNumber");
+ValueAtom* CrossfireContext::KEY_ERROR = ValueAtom::intern("error");
+ValueAtom* CrossfireContext::KEY_FILENAME = ValueAtom::intern("fileName");
+ValueAtom* CrossfireContext::KEY_LINENUMBER = ValueAtom::intern("lineNumber");
+const char* CrossfireContext::VALUE_JS = "js";
 
 /* event: onResume */
-const wchar_t* CrossfireContext::EVENT_ONRESUME = L"onResume";
+const char* CrossfireContext::EVENT_ONRESUME = "onResume";
 
 /* event: onScript */
-const wchar_t* CrossfireContext::EVENT_ONSCRIPT = L"onScript";
-const wchar_t* CrossfireContext::KEY_SCRIPT = L"script";
+const char* CrossfireContext::EVENT_ONSCRIPT = "onScript";
+ValueAtom* CrossfireContext::KEY_SCRIPT = ValueAtom::intern("script");
 
 /* event: onToggleBreakpoint */
-const wchar_t* CrossfireContext::EVENT_ONTOGGLEBREAKPOINT = L"onToggleBreakpoint";
-const wchar_t* CrossfireContext::KEY_SET = L"set";
+const char* CrossfireContext::EVENT_ONTOGGLEBREAKPOINT = "onToggleBreakpoint";
+ValueAtom* CrossfireContext::KEY_SET = ValueAtom::intern("set");
 
 /* shared */
-const wchar_t* CrossfireContext::KEY_BREAKPOINT = L"breakpoint";
-const wchar_t* CrossfireContext::KEY_CONTEXTID = L"contextId";
-const wchar_t* CrossfireContext::KEY_FRAMEINDEX = L"frameIndex";
-const wchar_t* CrossfireContext::KEY_HANDLE = L"handle";
-const wchar_t* CrossfireContext::KEY_LOCATION = L"location";
-const wchar_t* CrossfireContext::KEY_INCLUDESCOPES = L"includeScopes";
-const wchar_t* CrossfireContext::KEY_INCLUDESOURCE = L"includeSource";
-const wchar_t* CrossfireContext::KEY_LINE = L"line";
-const wchar_t* CrossfireContext::KEY_TYPE = L"type";
-const wchar_t* CrossfireContext::KEY_URL = L"url";
+ValueAtom* CrossfireContext::KEY_BREAKPOINT = ValueAtom::intern("breakpoint");
+ValueAtom* CrossfireContext::KEY_CONTEXTID = ValueAtom::intern("contextId");
+ValueAtom* CrossfireContext::KEY_FRAMEINDEX = ValueAtom::intern("frameIndex");
+ValueAtom* CrossfireContext::KEY_HANDLE = ValueAtom::intern("handle");
+ValueAtom* CrossfireContext::KEY_LOCATION = ValueAtom::intern("location");
+ValueAtom* CrossfireContext::KEY_INCLUDESCOPES = ValueAtom::intern("includeScopes");
+ValueAtom* CrossfireContext::KEY_INCLUDESOURCE = ValueAtom::intern("includeSource");
+ValueAtom* CrossfireContext::KEY_LINE = ValueAtom::intern("line");
+ValueAtom* CrossfireContext::KEY_TYPE = ValueAtom::intern("type");
+ValueAtom* CrossfireContext::KEY_URL = ValueAtom::intern("url");
 
 /* breakpoint objects */
-const wchar_t* CrossfireContext::BPTYPE_LINE = L"line";
+const char* CrossfireContext::BPTYPE_LINE = "line";
 
 /* frame objects */
-const wchar_t* CrossfireContext::KEY_FUNCTIONNAME = L"functionName";
+ValueAtom* CrossfireContext::KEY_FUNCTIONNAME = ValueAtom::intern("functionName");
 
 /* object objects */
 const wchar_t* CrossfireContext::JSVALUE_BOOLEAN = L"Boolean";
@@ -126,37 +127,37 @@ const wchar_t* CrossfireContext::JSVALUE_NULL = L"Null";
 const wchar_t* CrossfireContext::JSVALUE_STRING = L"String";
 const wchar_t* CrossfireContext::JSVALUE_TRUE = L"true";
 const wchar_t* CrossfireContext::JSVALUE_UNDEFINED = L"Undefined";
-const wchar_t* CrossfireContext::KEY_LOCALS = L"locals";
-const wchar_t* CrossfireContext::KEY_THIS = L"this";
-const wchar_t* CrossfireContext::KEY_VALUE = L"value";
-const wchar_t* CrossfireContext::VALUE_BOOLEAN = L"boolean";
-const wchar_t* CrossfireContext::VALUE_FUNCTION = L"function";
-const wchar_t* CrossfireContext::VALUE_NUMBER = L"number";
-const wchar_t* CrossfireContext::VALUE_OBJECT = L"object";
-const wchar_t* CrossfireContext::VALUE_STRING = L"string";
-const wchar_t* CrossfireContext::VALUE_UNDEFINED = L"undefined";
+ValueAtom* CrossfireContext::KEY_LOCALS = ValueAtom::intern("locals");
+ValueAtom* CrossfireContext::KEY_THIS = ValueAtom::intern("this");
+ValueAtom* CrossfireContext::KEY_VALUE = ValueAtom::intern("value");
+const char* CrossfireContext::VALUE_BOOLEAN = "boolean";
+const char* CrossfireContext::VALUE_FUNCTION = "function";
+const char* CrossfireContext::VALUE_NUMBER = "number";
+const char* CrossfireContext::VALUE_OBJECT = "object";
+const char* CrossfireContext::VALUE_STRING = "string";
+const char* CrossfireContext::VALUE_UNDEFINED = "undefined";
 
 /* script objects */
-const wchar_t* CrossfireContext::KEY_COLUMNOFFSET = L"columnOffset";
-const wchar_t* CrossfireContext::KEY_LINECOUNT = L"lineCount";
-const wchar_t* CrossfireContext::KEY_LINEOFFSET = L"lineOffset";
-const wchar_t* CrossfireContext::KEY_SOURCE = L"source";
-const wchar_t* CrossfireContext::KEY_SOURCELENGTH = L"sourceLength";
-const wchar_t* CrossfireContext::VALUE_EVALCODE = L"eval code";
-const wchar_t* CrossfireContext::VALUE_EVALLEVEL = L"eval-level";
-const wchar_t* CrossfireContext::VALUE_TOPLEVEL = L"top-level";
+ValueAtom* CrossfireContext::KEY_COLUMNOFFSET = ValueAtom::intern("columnOffset");
+ValueAtom* CrossfireContext::KEY_LINECOUNT = ValueAtom::intern("lineCount");
+ValueAtom* CrossfireContext::KEY_LINEOFFSET = ValueAtom::intern("lineOffset");
+ValueAtom* CrossfireContext::KEY_SOURCE = ValueAtom::intern("source");
+ValueAtom* CrossfireContext::KEY_SOURCELENGTH = ValueAtom::intern("sourceLength");
+const char* CrossfireContext::VALUE_EVALCODE = "eval code";
+const char* CrossfireContext::VALUE_EVALLEVEL = "eval-level";
+const char* CrossfireContext::VALUE_TOPLEVEL = "top-level";
 
 
 CrossfireContext::CrossfireContext(DWORD processId, DWORD threadId, wchar_t* url, CrossfireServer* server) {
 	static int s_counter = 0;
 	m_processId = processId;
 	m_threadId = threadId;
-	std::wstringstream stream;
+	std::stringstream stream;
 	stream << ID_PREAMBLE;
 	stream << m_processId;
 	stream << "-";
 	stream << s_counter++;
-	m_name = _wcsdup((wchar_t*)stream.str().c_str());
+	m_name = _strdup(stream.str().c_str());
 
 	CComObject<IEDebugger>* result = NULL;
 	HRESULT hr = CComObject<IEDebugger>::CreateInstance(&result);
@@ -178,7 +179,9 @@ CrossfireContext::CrossfireContext(DWORD processId, DWORD threadId, wchar_t* url
 	m_pendingScriptLoads = new std::map<IDebugApplicationNode*, PendingScriptLoad*>;
 	m_running = true;
 	m_scriptNodes = NULL;
-	m_url = _wcsdup(url);
+	std::string utf8Url;
+	UTF8Transcoder::toUTF8(url, &utf8Url);
+	m_url = _strdup(utf8Url.c_str());
 	hookDebugger();
 }
 
@@ -216,7 +219,7 @@ CrossfireContext::~CrossfireContext() {
 	}
 
 	if (m_scriptNodes) {
-		std::multimap<std::wstring, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->begin();
+		std::multimap<std::string, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->begin();
 		while (iterator != m_scriptNodes->end()) {
 			iterator->second->Release();
 			iterator++;
@@ -277,7 +280,7 @@ CrossfireContext::~CrossfireContext() {
 
 /* IBreakpointTarget */
 
-bool CrossfireContext::breakpointAttributeChanged(unsigned int handle, wchar_t* name, Value* value) {
+bool CrossfireContext::breakpointAttributeChanged(unsigned int handle, char* name, Value* value) {
 	std::map<unsigned int, CrossfireBreakpoint*>::iterator iterator = m_breakpoints->find(handle);
 	if (iterator == m_breakpoints->end()) {
 		Logger::error("CrossfireContext.breakpointAttributeChanged(): unknown breakpoint handle", handle);
@@ -285,14 +288,14 @@ bool CrossfireContext::breakpointAttributeChanged(unsigned int handle, wchar_t*
 	}
 	CrossfireBreakpoint* breakpoint = iterator->second;
 
-	if (wcscmp(name, CrossfireLineBreakpoint::ATTRIBUTE_ENABLED) == 0) {
+	if (strcmp(name, CrossfireLineBreakpoint::ATTRIBUTE_ENABLED) == 0) {
 		return setBreakpointEnabled((CrossfireLineBreakpoint*)breakpoint, value->getBooleanValue());
 	}
-	if (wcscmp(name, CrossfireLineBreakpoint::ATTRIBUTE_CONDITION) == 0) {
+	if (strcmp(name, CrossfireLineBreakpoint::ATTRIBUTE_CONDITION) == 0) {
 		((CrossfireLineBreakpoint*)breakpoint)->setCondition(value->getStringValue());
 		return true;
 	}
-	if (wcscmp(name, CrossfireLineBreakpoint::ATTRIBUTE_HITCOUNT) == 0) {
+	if (strcmp(name, CrossfireLineBreakpoint::ATTRIBUTE_HITCOUNT) == 0) {
 		((CrossfireLineBreakpoint*)breakpoint)->setHitCount((unsigned int)value->getNumberValue());
 		return true;
 	}
@@ -436,13 +439,12 @@ bool CrossfireContext::deleteBreakpoint(unsigned int handle) {
 
 	CrossfireEvent toggleEvent;
 	toggleEvent.setName(EVENT_ONTOGGLEBREAKPOINT);
-	Value body;
-	body.addObjectValue(KEY_SET, &Value(false));
+	Value* body = new Value();
+	body->adoptObjectValue(KEY_SET, new Value(false));
 	Value* value_breakpoint = NULL;
 	breakpoint->toValueObject(&value_breakpoint);
-	body.addObjectValue(KEY_BREAKPOINT, value_breakpoint);
-	delete value_breakpoint;
-	toggleEvent.setBody(&body);
+	body->adoptObjectValue(KEY_BREAKPOINT, value_breakpoint);
+	toggleEvent.adoptBody(body);
 	sendEvent(&toggleEvent);
 
 	delete iterator->second;
@@ -604,18 +606,17 @@ bool CrossfireContext::setBreakpoint(CrossfireBreakpoint *breakpoint) {
 	CrossfireLineBreakpoint* copy = NULL;
 	lineBp->clone((CrossfireBreakpoint**)&copy);
 	copy->setLine(bpLineNumber + 1);
-	copy->setContextId(&std::wstring(m_name));
+	copy->setContextId(&std::string(m_name));
 	m_breakpoints->insert(std::pair<unsigned int, CrossfireBreakpoint*>(handle, copy));
 
 	CrossfireEvent toggleEvent;
 	toggleEvent.setName(EVENT_ONTOGGLEBREAKPOINT);
-	Value body;
-	body.addObjectValue(KEY_SET, &Value(true));
+	Value* body = new Value();
+	body->adoptObjectValue(KEY_SET, new Value(true));
 	Value* value_breakpoint = NULL;
 	copy->toValueObject(&value_breakpoint);
-	body.addObjectValue(KEY_BREAKPOINT, value_breakpoint);
-	delete value_breakpoint;
-	toggleEvent.setBody(&body);
+	body->adoptObjectValue(KEY_BREAKPOINT, value_breakpoint);
+	toggleEvent.adoptBody(body);
 	sendEvent(&toggleEvent);
 	return true;
 }
@@ -667,15 +668,15 @@ void CrossfireContext::evalComplete(IDebugProperty* value, void* data) {
 	CrossfireLineBreakpoint* breakpoint = (CrossfireLineBreakpoint*)data;
 	CrossfireEvent onBreakEvent;
 	onBreakEvent.setName(EVENT_ONBREAK);
-	Value value_body;
-	Value location;
-	location.addObjectValue(KEY_LINE, &Value((double)breakpoint->getLine()));
-	location.addObjectValue(KEY_URL, &Value(((URL*)breakpoint->getUrl())->getString()));
-	value_body.addObjectValue(KEY_LOCATION, &location);
-	Value cause;
-	cause.addObjectValue(KEY_TITLE, &Value(L"breakpoint"));
-	value_body.addObjectValue(KEY_CAUSE, &cause);
-	onBreakEvent.setBody(&value_body);
+	Value* value_body = new Value();
+	Value* location = new Value();
+	location->adoptObjectValue(KEY_LINE, new Value((double)breakpoint->getLine()));
+	location->adoptObjectValue(KEY_URL, new Value(((URL*)breakpoint->getUrl())->getString()));
+	value_body->adoptObjectValue(KEY_LOCATION, location);
+	Value* cause = new Value();
+	cause->adoptObjectValue(KEY_TITLE, new Value("breakpoint"));
+	value_body->adoptObjectValue(KEY_CAUSE, cause);
+	onBreakEvent.adoptBody(value_body);
 	sendEvent(&onBreakEvent);
 }
 
@@ -778,23 +779,23 @@ bool CrossfireContext::createValueForFrame(IDebugStackFrame* stackFrame, unsigne
 	}
 
 	if (value_this) {
-		locals->addObjectValue(KEY_THIS, value_this);
-		delete value_this;
+		locals->adoptObjectValue(KEY_THIS, value_this);
 	} else {
 		/* create an empty "this" value */
-		Value value_thisChildren;
-		value_thisChildren.setType(TYPE_OBJECT);
-		Value value_this2;
-		value_this2.addObjectValue(KEY_TYPE, &Value(VALUE_OBJECT));
-		value_this2.addObjectValue(KEY_VALUE, &value_thisChildren);
-		locals->addObjectValue(KEY_THIS, &value_this2);
+		Value* value_thisChildren = new Value();
+		value_thisChildren->setType(TYPE_OBJECT);
+		Value* value_this2 = new Value();
+		value_this2->adoptObjectValue(KEY_TYPE, new Value(VALUE_OBJECT));
+		value_this2->adoptObjectValue(KEY_VALUE, value_thisChildren);
+		locals->adoptObjectValue(KEY_THIS, value_this2);
 	}
 
 	URL url;
 	CComBSTR bstrUrl = NULL;
 	hr = document->GetName(DOCUMENTNAMETYPE_URL, &bstrUrl);
+	std::string utf8Url;
 	if (SUCCEEDED(hr)) {
-		url.setString(bstrUrl);
+		UTF8Transcoder::toUTF8(bstrUrl.m_str, &utf8Url);
 	} else {
 		/*
 		 * Failure to get the URL indicates that the node represents something like a JScript
@@ -807,14 +808,10 @@ bool CrossfireContext::createValueForFrame(IDebugStackFrame* stackFrame, unsigne
 			return false;
 		}
 
-		int length = wcslen(SCHEME_SCRIPT) + wcslen(bstrUrl.m_str) + 1;
-		wchar_t* string = new wchar_t[length];
-		ZeroMemory(string, length * sizeof(wchar_t));
-		wcscat_s(string, length, SCHEME_SCRIPT);
-		wcscat_s(string, length, bstrUrl.m_str);
-		url.setString(string);
-		delete[] string;
+		UTF8Transcoder::toUTF8(bstrUrl.m_str, &utf8Url);
+		utf8Url.insert(0, SCHEME_SCRIPT);
 	}
+	url.setString((char*)utf8Url.c_str());
 
 	if (!locals) {
 		locals = new Value();
@@ -822,13 +819,12 @@ bool CrossfireContext::createValueForFrame(IDebugStackFrame* stackFrame, unsigne
 	}
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_FUNCTIONNAME, &Value(description));
-	result->addObjectValue(KEY_INDEX, &Value((double)frameIndex));
-	result->addObjectValue(KEY_LINE, &Value((double)lineNumber + 1));
-	result->addObjectValue(KEY_LOCALS, locals);
-	result->addObjectValue(KEY_URL, &Value(url.getString()));
+	result->adoptObjectValue(KEY_FUNCTIONNAME, new Value(description));
+	result->adoptObjectValue(KEY_INDEX, new Value((double)frameIndex));
+	result->adoptObjectValue(KEY_LINE, new Value((double)lineNumber + 1));
+	result->adoptObjectValue(KEY_LOCALS, locals);
+	result->adoptObjectValue(KEY_URL, new Value(url.getString()));
 	// TODO includeScopes
-	delete locals;
 
 	*_value = result;
 	return true;
@@ -846,52 +842,53 @@ bool CrossfireContext::createValueForObject(JSObject* object, bool resolveChildO
 	}
 
 	BSTR type = propertyInfo.m_bstrType;
-	Value result;
+	Value* result = new Value();
 	if (wcscmp(type, JSVALUE_NULL) == 0) {
-		result.setType(TYPE_NULL);
+		result->setType(TYPE_NULL);
 	} else if (wcscmp(type, JSVALUE_UNDEFINED) == 0) {
-		result.setValue(VALUE_UNDEFINED);
+		result->setValue(VALUE_UNDEFINED);
 	} else {
 		BSTR stringValue = propertyInfo.m_bstrValue;
 		if (wcscmp(type, JSVALUE_NUMBER) == 0) {
 			wchar_t* endPtr = 0;
-			result.addObjectValue(KEY_TYPE, &Value(VALUE_NUMBER));
+			result->adoptObjectValue(KEY_TYPE, new Value(VALUE_NUMBER));
 			if (wcscmp(stringValue, NUMBER_NaN) == 0) {
-				result.addObjectValue(KEY_VALUE, &Value(VALUE_NaN));
+				result->adoptObjectValue(KEY_VALUE, new Value(VALUE_NaN));
 			} else if (wcscmp(stringValue, NUMBER_INFINITY) == 0) {
-				result.addObjectValue(KEY_VALUE, &Value(VALUE_INFINITY));
+				result->adoptObjectValue(KEY_VALUE, new Value(VALUE_INFINITY));
 			} else if (wcscmp(stringValue, NUMBER_NEGATIVEINFINITY) == 0) {
-				result.addObjectValue(KEY_VALUE, &Value(VALUE_NEGATIVEINFINITY));
+				result->adoptObjectValue(KEY_VALUE, new Value(VALUE_NEGATIVEINFINITY));
 			} else {
 				double value = wcstod(stringValue, &endPtr);
-				result.addObjectValue(KEY_VALUE, &Value(value));
+				result->adoptObjectValue(KEY_VALUE, new Value(value));
 			}
 		} else if (wcscmp(type, JSVALUE_BOOLEAN) == 0) {
-			result.addObjectValue(KEY_TYPE, &Value(VALUE_BOOLEAN));
+			result->adoptObjectValue(KEY_TYPE, new Value(VALUE_BOOLEAN));
 			if (wcscmp(stringValue, JSVALUE_TRUE) == 0) {
-				result.addObjectValue(KEY_VALUE, &Value(true));
+				result->adoptObjectValue(KEY_VALUE, new Value(true));
 			} else {
-				result.addObjectValue(KEY_VALUE, &Value(false));
+				result->adoptObjectValue(KEY_VALUE, new Value(false));
 			}
 		} else if (wcscmp(type, JSVALUE_STRING) == 0) {
-			std::wstring string(stringValue);
-			string = string.substr(1, string.length() - 2);
-			result.addObjectValue(KEY_TYPE, &Value(VALUE_STRING));
-			result.addObjectValue(KEY_VALUE, &Value(&string));
+			/* the value is quoted, and the quotes are not included in the result */
+			std::string string;
+			UTF8Transcoder::toUTF8(stringValue + 1, wcslen(stringValue) - 2, &string);
+			result->adoptObjectValue(KEY_TYPE, new Value(VALUE_STRING));
+			result->adoptObjectValue(KEY_VALUE, new Value(&string));
 		} else if ((propertyInfo.m_dwAttrib & DBGPROP_ATTRIB_VALUE_IS_INVALID) != 0) {
 			// TODO error object, should fail?
 		} else if ((propertyInfo.m_dwAttrib & DBGPROP_ATTRIB_VALUE_IS_EXPANDABLE) == 0) {
 			/* object is a function */
-			result.addObjectValue(KEY_TYPE, &Value(VALUE_FUNCTION));
+			result->adoptObjectValue(KEY_TYPE, new Value(VALUE_FUNCTION));
 			if (resolveChildObjects) {
 				// TODO
-				Value value_empty;
-				value_empty.setType(TYPE_OBJECT);
-				result.addObjectValue(KEY_VALUE, &value_empty);
+				Value* value_empty = new Value();
+				value_empty->setType(TYPE_OBJECT);
+				result->adoptObjectValue(KEY_VALUE, value_empty);
 			}
 		} else {
 			if (!resolveChildObjects) {
-				result.addObjectValue(KEY_TYPE, &Value(VALUE_OBJECT));
+				result->adoptObjectValue(KEY_TYPE, new Value(VALUE_OBJECT));
 			} else {
 				CComPtr<IEnumDebugPropertyInfo> enumPropertyInfo = NULL;
 				HRESULT hr = debugProperty->EnumMembers(
@@ -901,6 +898,7 @@ bool CrossfireContext::createValueForObject(JSObject* object, bool resolveChildO
 					&enumPropertyInfo);
 				if (FAILED(hr)) {
 					Logger::error("CrossfireContext.createValueForObject(): EnumMembers() failed", hr);
+					delete result;
 					return false;
 				}
 
@@ -912,8 +910,8 @@ bool CrossfireContext::createValueForObject(JSObject* object, bool resolveChildO
 				ULONG count = 0;
 				enumPropertyInfo->GetCount(&count);
 
-				Value children;
-				children.setType(TYPE_OBJECT);
+				Value* children = new Value();
+				children->setType(TYPE_OBJECT);
 				ULONG fetched;
 				do {
 					DebugPropertyInfo propertyInfo;
@@ -927,40 +925,39 @@ bool CrossfireContext::createValueForObject(JSObject* object, bool resolveChildO
 						if (createValueForObject(&childObject, false, &value_child)) {
 							if (value_child->getType() == TYPE_OBJECT) {
 								Value* value_type = value_child->getObjectValue(KEY_TYPE);
-								const wchar_t* type = value_type->getStringValue()->c_str();
-								if (wcscmp(type, VALUE_OBJECT) == 0 || (wcscmp(type, VALUE_FUNCTION) == 0)) {
+								const char* type = value_type->getStringValue();
+								if (strcmp(type, VALUE_OBJECT) == 0 || (strcmp(type, VALUE_FUNCTION) == 0)) {
 									std::map<std::wstring, unsigned int> objects = object->children;
 									std::map<std::wstring, unsigned int>::iterator iterator = objects.find(propertyInfo.m_bstrName);
-									Value value_handle;
+									Value* value_handle = new Value();
 									if (iterator != objects.end()) {
-										value_handle.setValue((double)iterator->second);
+										value_handle->setValue((double)iterator->second);
 									} else {
-										value_handle.setValue((double)m_nextObjectHandle);
+										value_handle->setValue((double)m_nextObjectHandle);
 										JSObject* newObject = new JSObject();
 										newObject->debugProperty = propertyInfo.m_pDebugProp;
 										newObject->debugProperty->AddRef();
-										newObject->isObject = wcscmp(type, VALUE_OBJECT) == 0;
+										newObject->isObject = strcmp(type, VALUE_OBJECT) == 0;
 										newObject->stackFrame = stackFrame;
 										newObject->stackFrame->AddRef();
 										m_objects->insert(std::pair<unsigned int, JSObject*>(m_nextObjectHandle++, newObject));
 									}
-									value_child->addObjectValue(KEY_HANDLE, &value_handle);
+									value_child->adoptObjectValue(KEY_HANDLE, value_handle);
 								}
 							}
-							children.addObjectValue(propertyInfo.m_bstrName, value_child);
-							delete value_child;
+							std::string name;
+							UTF8Transcoder::toUTF8(propertyInfo.m_bstrName, &name);
+							children->adoptObjectValue(&name, value_child);
 						}
 					}
 				} while (fetched);
-				result.addObjectValue(KEY_TYPE, &Value(VALUE_OBJECT));
-				result.addObjectValue(KEY_VALUE, &children);
+				result->adoptObjectValue(KEY_TYPE, new Value(VALUE_OBJECT));
+				result->adoptObjectValue(KEY_VALUE, children);
 			}
 		}
 	}
 
-	Value* copy = NULL;
-	result.clone(&copy);
-	*_value = copy;
+	*_value = result;
 	return true;
 }
 
@@ -999,15 +996,15 @@ bool CrossfireContext::createValueForScript(IDebugApplicationNode* node, bool in
 	}
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_URL, &Value(url->getString()));
-	result->addObjectValue(KEY_LINEOFFSET, &Value((double)0)); // TODO right?
-	result->addObjectValue(KEY_COLUMNOFFSET, &Value((double)0));
-	result->addObjectValue(KEY_SOURCELENGTH, &Value((double)numChars));
-	result->addObjectValue(KEY_LINECOUNT, &Value((double)numLines));
-	if (wcsstr(url->getString(), VALUE_EVALCODE)) {
-		result->addObjectValue(KEY_TYPE, &Value(VALUE_EVALLEVEL)); // TODO right?
+	result->adoptObjectValue(KEY_URL, new Value(url->getString()));
+	result->adoptObjectValue(KEY_LINEOFFSET, new Value((double)0)); // TODO right?
+	result->adoptObjectValue(KEY_COLUMNOFFSET, new Value((double)0));
+	result->adoptObjectValue(KEY_SOURCELENGTH, new Value((double)numChars));
+	result->adoptObjectValue(KEY_LINECOUNT, new Value((double)numLines));
+	if (strstr(url->getString(), VALUE_EVALCODE)) {
+		result->adoptObjectValue(KEY_TYPE, new Value(VALUE_EVALLEVEL)); // TODO right?
 	} else {
-		result->addObjectValue(KEY_TYPE, &Value(VALUE_TOPLEVEL)); // TODO right?
+		result->adoptObjectValue(KEY_TYPE, new Value(VALUE_TOPLEVEL)); // TODO right?
 	}
 	delete url;
 
@@ -1020,7 +1017,7 @@ bool CrossfireContext::createValueForScript(IDebugApplicationNode* node, bool in
 			return false;
 		}
 		sourceChars[numChars] = NULL;
-		result->addObjectValue(KEY_SOURCE, &Value(sourceChars));
+		result->adoptObjectValue(KEY_SOURCE, new Value(sourceChars));
 		delete[] sourceChars;
 	}
 
@@ -1199,7 +1196,9 @@ void CrossfireContext::executionBreak(IRemoteDebugApplicationThread *pDebugAppTh
 		resumeFromBreak(BREAKRESUMEACTION_STEP_OUT);
 		return;
 	}
-	URL url(bstrUrl);
+	std::string utf8Url;
+	UTF8Transcoder::toUTF8(bstrUrl.m_str, &utf8Url);
+	URL url((char*)utf8Url.c_str());
 
 	/*
 	 * If the cause of the break is a breakpoint then locate the breakpoint and
@@ -1218,10 +1217,11 @@ void CrossfireContext::executionBreak(IRemoteDebugApplicationThread *pDebugAppTh
 					if (!lineBp->matchesHitCount() && resumeFromBreak(BREAKRESUMEACTION_CONTINUE)) {
 						return;
 					}
-					const std::wstring* conditionString = lineBp->getCondition();
+					const char* conditionString = lineBp->getCondition();
 					if (conditionString) {
-						wchar_t* condition = (wchar_t*)conditionString->c_str();
-						if (evaluateAsync(frame, condition, DEBUG_TEXT_RETURNVALUE | DEBUG_TEXT_NOSIDEEFFECTS, this, lineBp)) {
+						std::wstring condition;
+						UTF8Transcoder::toWide(conditionString, &condition);
+						if (evaluateAsync(frame, (wchar_t*)condition.c_str(), DEBUG_TEXT_RETURNVALUE | DEBUG_TEXT_NOSIDEEFFECTS, this, lineBp)) {
 							return;
 						}
 					}
@@ -1236,23 +1236,23 @@ void CrossfireContext::executionBreak(IRemoteDebugApplicationThread *pDebugAppTh
 	if (br == BREAKREASON_ERROR) {
 		/* broken out separately because this event object differs from the others */
 		breakEvent.setName(EVENT_ONERROR);
-		Value body;
-		Value error;
+		Value* body = new Value();
+		Value* error = new Value();
 		EXCEPINFO excepInfo;
 		HRESULT hr = pScriptErrorDebug->GetExceptionInfo(&excepInfo);
 		if (FAILED(hr)) {
 			Logger::error("IEDebugger::executionBreak(): GetExceptionInfo() failed", hr);
 		} else {
 			if (excepInfo.bstrDescription) {
-				error.addObjectValue(KEY_MESSAGE, &Value(excepInfo.bstrDescription));
+				error->adoptObjectValue(KEY_MESSAGE, new Value(excepInfo.bstrDescription));
 			}
 		}
-		error.addObjectValue(KEY_LINENUMBER, &Value((double)lineNumber));
-		error.addObjectValue(KEY_COLUMNNUMBER, &Value((double)column));
-		error.addObjectValue(KEY_FILENAME, &Value(url.getString()));
-		error.addObjectValue(KEY_CATEGORY, &Value(VALUE_JS));
-		body.addObjectValue(KEY_ERROR, &error);
-		breakEvent.setBody(&body);
+		error->adoptObjectValue(KEY_LINENUMBER, new Value((double)lineNumber));
+		error->adoptObjectValue(KEY_COLUMNNUMBER, new Value((double)column));
+		error->adoptObjectValue(KEY_FILENAME, new Value(url.getString()));
+		error->adoptObjectValue(KEY_CATEGORY, new Value(VALUE_JS));
+		body->adoptObjectValue(KEY_ERROR, error);
+		breakEvent.adoptBody(body);
 
 		/*
 		 * The Crossfire spec does not specify that the server should be left in a
@@ -1262,32 +1262,32 @@ void CrossfireContext::executionBreak(IRemoteDebugApplicationThread *pDebugAppTh
 		resumeFromBreak(BREAKRESUMEACTION_CONTINUE);
 	} else {
 		breakEvent.setName(EVENT_ONBREAK);
-		Value body;
-		Value location;
-		location.addObjectValue(KEY_LINE, &Value((double)lineNumber));
-		location.addObjectValue(KEY_URL, &Value(url.getString()));
-		body.addObjectValue(KEY_LOCATION, &location);
-		Value cause;
+		Value* body = new Value();
+		Value* location = new Value();
+		location->adoptObjectValue(KEY_LINE, new Value((double)lineNumber));
+		location->adoptObjectValue(KEY_URL, new Value(url.getString()));
+		body->adoptObjectValue(KEY_LOCATION, location);
+		Value* cause = new Value();
 		switch (br) {
 			case BREAKREASON_DEBUGGER_HALT: {
-				cause.addObjectValue(KEY_TITLE, &Value(L"suspend"));
+				cause->adoptObjectValue(KEY_TITLE, new Value("suspend"));
 				break;
 			}
 			case BREAKREASON_STEP: {
-				cause.addObjectValue(KEY_TITLE, &Value(L"step"));
+				cause->adoptObjectValue(KEY_TITLE, new Value("step"));
 				break;
 			}
 			case BREAKREASON_BREAKPOINT: {
-				cause.addObjectValue(KEY_TITLE, &Value(L"breakpoint"));
+				cause->adoptObjectValue(KEY_TITLE, new Value("breakpoint"));
 				break;
 			}
 			default: {
-				cause.addObjectValue(KEY_TITLE, &Value(L"suspend"));
+				cause->adoptObjectValue(KEY_TITLE, new Value("suspend"));
 				break;
 			}
 		}
-		body.addObjectValue(KEY_CAUSE, &cause);
-		breakEvent.setBody(&body);
+		body->adoptObjectValue(KEY_CAUSE, cause);
+		breakEvent.adoptBody(body);
 	}
 	sendEvent(&breakEvent);
 }
@@ -1389,7 +1389,7 @@ IDebugApplicationNode* CrossfireContext::getLastInitializedScriptNode() {
 	return m_lastInitializedScriptNode;
 }
 
-wchar_t* CrossfireContext::getName() {
+char* CrossfireContext::getName() {
 	return m_name;
 }
 
@@ -1404,10 +1404,10 @@ bool CrossfireContext::getScriptUrl(IDebugApplicationNode* node, URL** _value) {
 		return false;
 	}
 
-	std::multimap<std::wstring, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->begin();
+	std::multimap<std::string, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->begin();
 	while (iterator != m_scriptNodes->end()) {
 		if (iterator->second == node) {
-			*_value = new URL((wchar_t*)iterator->first.c_str());
+			*_value = new URL((char*)iterator->first.c_str());
 			return true;
 		}
 		iterator++;
@@ -1420,8 +1420,8 @@ IDebugApplicationNode* CrossfireContext::getScriptNode(URL* url) {
 		return NULL;
 	}
 
-	std::wstring string(url->getString());
-	std::multimap<std::wstring, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->find(string);
+	std::string string(url->getString());
+	std::multimap<std::string, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->find(string);
 	if (iterator == m_scriptNodes->end()) {
 		return NULL;
 	}
@@ -1429,7 +1429,7 @@ IDebugApplicationNode* CrossfireContext::getScriptNode(URL* url) {
 	return iterator->second;
 }
 
-wchar_t* CrossfireContext::getUrl() {
+char* CrossfireContext::getUrl() {
 	return m_url;
 }
 
@@ -1468,8 +1468,8 @@ void CrossfireContext::installBreakpoints(std::vector<Value*>* breakpoints) {
 	std::vector<Value*>::iterator iterator = breakpoints->begin();
 	while (iterator != breakpoints->end()) {
 		Value* current = *iterator;
-		std::wstring* type = current->getObjectValue(KEY_TYPE)->getStringValue();
-		if (type->compare(std::wstring(BPTYPE_LINE)) == 0) {
+		const char* type = current->getObjectValue(KEY_TYPE)->getStringValue();
+		if (strcmp(type, BPTYPE_LINE) == 0) {
 			Value* value_location = current->getObjectValue(KEY_LOCATION);
 			Value* value_url = value_location->getObjectValue(KEY_LINE);
 			if (value_url && value_url->getType() == TYPE_STRING) {
@@ -1484,36 +1484,36 @@ bool CrossfireContext::performRequest(CrossfireRequest* request) {
 	if (!m_debuggerHooked) {
 		hookDebugger();
 	}
-	wchar_t* command = request->getName();
+	char* command = request->getName();
 	Value* arguments = request->getArguments();
 	Value* responseBody = NULL;
-	wchar_t* message = NULL;
+	char* message = NULL;
 	int code = CODE_OK;
 
-	if (wcscmp(command, COMMAND_BACKTRACE) == 0) {
+	if (strcmp(command, COMMAND_BACKTRACE) == 0) {
 		code = commandBacktrace(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_CONTINUE) == 0) {
+	} else if (strcmp(command, COMMAND_CONTINUE) == 0) {
 		code = commandContinue(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_EVALUATE) == 0) {
+	} else if (strcmp(command, COMMAND_EVALUATE) == 0) {
 		code = commandEvaluate(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_FRAME) == 0) {
+	} else if (strcmp(command, COMMAND_FRAME) == 0) {
 		code = commandFrame(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_LOOKUP) == 0) {
+	} else if (strcmp(command, COMMAND_LOOKUP) == 0) {
 		code = commandLookup(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_SCRIPTS) == 0) {
+	} else if (strcmp(command, COMMAND_SCRIPTS) == 0) {
 		code = commandScripts(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_SCOPES) == 0) {
+	} else if (strcmp(command, COMMAND_SCOPES) == 0) {
 		code = commandScopes(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_SUSPEND) == 0) {
+	} else if (strcmp(command, COMMAND_SUSPEND) == 0) {
 		code = commandSuspend(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_INSPECT) == 0) {
+	} else if (strcmp(command, COMMAND_INSPECT) == 0) {
 		code = CODE_COMMAND_NOT_IMPLEMENTED;
 	} else {
 		return false;	/* command not handled */
 	}
 
 	CrossfireResponse response;
-	response.setContextId(&std::wstring(m_name));
+	response.setContextId(&std::string(m_name));
 	response.setName(command);
 	response.setRequestSeq(request->getSeq());
 	response.setRunning(m_running);
@@ -1522,16 +1522,14 @@ bool CrossfireContext::performRequest(CrossfireRequest* request) {
 	if (message) {
 		free(message);
 	}
-	if (code == CODE_OK) {
-		response.setBody(responseBody);
-	} else {
-		Value emptyBody;
-		emptyBody.setType(TYPE_OBJECT);
-		response.setBody(&emptyBody);
-	}
-	if (responseBody) {
-		delete responseBody;
+	if (code != CODE_OK) {
+		if (responseBody) {
+			delete responseBody;
+		}
+		responseBody = new Value();
+		responseBody->setType(TYPE_OBJECT);
 	}
+	response.adoptBody(responseBody);
 	m_server->sendResponse(&response);
 	return true;
 }
@@ -1546,7 +1544,9 @@ bool CrossfireContext::registerScript(IDebugApplicationNode* applicationNode, bo
 		if (wcscmp(value.m_str, ABOUT_BLANK) == 0) {
 			return false;
 		}
-		url.setString(value.m_str);
+		std::string utf8Url;
+		UTF8Transcoder::toUTF8(value.m_str, &utf8Url);
+		url.setString((char*)utf8Url.c_str());
 	} else {
 		// the following is intentionally commented
 		///*
@@ -1576,7 +1576,7 @@ bool CrossfireContext::registerScript(IDebugApplicationNode* applicationNode, bo
 	}
 
 	if (!m_scriptNodes) {
-		m_scriptNodes = new std::multimap<std::wstring, IDebugApplicationNode*>;
+		m_scriptNodes = new std::multimap<std::string, IDebugApplicationNode*>;
 	}
 
 	// the following is intentionally commented
@@ -1599,7 +1599,7 @@ bool CrossfireContext::registerScript(IDebugApplicationNode* applicationNode, bo
 	//}
 
 	applicationNode->AddRef();
-	m_scriptNodes->insert(std::pair<std::wstring, IDebugApplicationNode*>(url.getString(), applicationNode));
+	m_scriptNodes->insert(std::pair<std::string, IDebugApplicationNode*>(url.getString(), applicationNode));
 
 	if (recurse) {
 		CComPtr<IEnumDebugApplicationNodes> nodes = NULL;
@@ -1723,15 +1723,14 @@ void CrossfireContext::scriptLoaded(IDebugApplicationNode *applicationNode, bool
 
 	CrossfireEvent onScriptEvent;
 	onScriptEvent.setName(EVENT_ONSCRIPT);
-	Value body;
-	body.addObjectValue(KEY_SCRIPT, script);
-	delete script;
-	onScriptEvent.setBody(&body);
+	Value* body = new Value();
+	body->adoptObjectValue(KEY_SCRIPT, script);
+	onScriptEvent.adoptBody(body);
 	sendEvent(&onScriptEvent);
 }
 
 void CrossfireContext::sendEvent(CrossfireEvent* eventObj) {
-	eventObj->setContextId(&std::wstring(m_name));
+	eventObj->setContextId(&std::string(m_name));
 	m_server->sendEvent(eventObj);
 }
 
@@ -1755,9 +1754,9 @@ bool CrossfireContext::unhookDebugger() {
 
 /* commands */
 
-int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody, char** _message) {
 	if (m_running) {
-		*_message = _wcsdup(L"'backtrace' request is only valid when execution is suspended");
+		*_message = _strdup("'backtrace' request is only valid when execution is suspended");
 		return CODE_INVALID_STATE;
 	}
 
@@ -1765,7 +1764,7 @@ int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody,
 	Value* value_fromFrame = arguments->getObjectValue(KEY_FROMFRAME);
 	if (value_fromFrame) {
 		if (value_fromFrame->getType() != TYPE_NUMBER || (unsigned int)value_fromFrame->getNumberValue() < 0) {
-			*_message = _wcsdup(L"'backtrace' command has an invalid 'fromFrame' value");
+			*_message = _strdup("'backtrace' command has an invalid 'fromFrame' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		fromFrame = (unsigned int)value_fromFrame->getNumberValue();
@@ -1775,12 +1774,12 @@ int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody,
 	Value* value_toFrame = arguments->getObjectValue(KEY_TOFRAME);
 	if (value_toFrame) {
 		if (value_toFrame->getType() != TYPE_NUMBER || (unsigned int)value_toFrame->getNumberValue() < 0) {
-			*_message = _wcsdup(L"'backtrace' command has an invalid 'toFrame' value");
+			*_message = _strdup("'backtrace' command has an invalid 'toFrame' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		toFrame = (unsigned int)value_toFrame->getNumberValue();
 		if (toFrame < fromFrame) {
-			*_message = _wcsdup(L"'backtrace' command has 'toFrame' value < 'fromFrame' value");
+			*_message = _strdup("'backtrace' command has 'toFrame' value < 'fromFrame' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 	}
@@ -1789,7 +1788,7 @@ int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody,
 	Value* value_includeScopes = arguments->getObjectValue(KEY_INCLUDESCOPES);
 	if (value_includeScopes) {
 		if (value_includeScopes->getType() != TYPE_BOOLEAN) {
-			*_message = _wcsdup(L"'backtrace' command has an invalid 'includeScopes' value");
+			*_message = _strdup("'backtrace' command has an invalid 'includeScopes' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		includeScopes = value_includeScopes->getBooleanValue();
@@ -1817,8 +1816,8 @@ int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody,
 
 	/* count the available frames, and adjust toFrame accordingly if needed */
 
-	Value framesArray;
-	framesArray.setType(TYPE_ARRAY);
+	Value* framesArray = new Value();
+	framesArray->setType(TYPE_ARRAY);
 	unsigned int index = 0;
 	for (index = fromFrame; index <= toFrame; index++) {
 		ULONG fetched = 0;
@@ -1838,8 +1837,7 @@ int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody,
 			break;
 		}
 
-		framesArray.addArrayValue(frame);
-		delete frame;
+		framesArray->adoptArrayValue(frame);
 	}
 
 	/* index now points to one frame beyond the last frame to be returned */
@@ -1863,17 +1861,17 @@ int CrossfireContext::commandBacktrace(Value* arguments, Value** _responseBody,
 	}
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_FRAMES, &framesArray);
-	result->addObjectValue(KEY_FROMFRAME, &Value((double)fromFrame));
-	result->addObjectValue(KEY_TOFRAME, &Value((double)index - 1));
-	result->addObjectValue(KEY_TOTALFRAMES, &Value((double)totalFrameCount));
+	result->adoptObjectValue(KEY_FRAMES, framesArray);
+	result->adoptObjectValue(KEY_FROMFRAME, new Value((double)fromFrame));
+	result->adoptObjectValue(KEY_TOFRAME, new Value((double)index - 1));
+	result->adoptObjectValue(KEY_TOTALFRAMES, new Value((double)totalFrameCount));
 	*_responseBody = result;
 	return CODE_OK;
 }
 
-int CrossfireContext::commandContinue(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandContinue(Value* arguments, Value** _responseBody, char** _message) {
 	if (m_running) {
-		*_message = _wcsdup(L"'continue' request is only valid when execution is suspended");
+		*_message = _strdup("'continue' request is only valid when execution is suspended");
 		return CODE_INVALID_STATE;
 	}
 
@@ -1886,18 +1884,18 @@ int CrossfireContext::commandContinue(Value* arguments, Value** _responseBody, w
 		action = BREAKRESUMEACTION_CONTINUE;
 	} else {
 		if (value_action->getType() != TYPE_STRING) {
-			*_message = _wcsdup(L"'continue' command has invalid 'stepaction' value");
+			*_message = _strdup("'continue' command has invalid 'stepaction' value");
 			return CODE_INVALID_ARGUMENT;
 		}
-		std::wstring* actionString = value_action->getStringValue();
-		if (actionString->compare(VALUE_IN) == 0) {
+		const char* actionString = value_action->getStringValue();
+		if (strcmp(actionString, VALUE_IN) == 0) {
 			action = BREAKRESUMEACTION_STEP_INTO;
-		} else if (actionString->compare(VALUE_NEXT) == 0) {
+		} else if (strcmp(actionString, VALUE_NEXT) == 0) {
 			action = BREAKRESUMEACTION_STEP_OVER;
-		} else if (actionString->compare(VALUE_OUT) == 0) {
+		} else if (strcmp(actionString, VALUE_OUT) == 0) {
 			action = BREAKRESUMEACTION_STEP_OUT;
 		} else {
-			*_message = _wcsdup(L"'continue' command has invalid 'stepaction' value");
+			*_message = _strdup("'continue' command has invalid 'stepaction' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 	}
@@ -1933,9 +1931,9 @@ int CrossfireContext::commandContinue(Value* arguments, Value** _responseBody, w
 	return CODE_OK;
 }
 
-int CrossfireContext::commandEvaluate(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandEvaluate(Value* arguments, Value** _responseBody, char** _message) {
 	if (m_running) {
-		*_message = _wcsdup(L"'evaluate' request is only valid when execution is suspended");
+		*_message = _strdup("'evaluate' request is only valid when execution is suspended");
 		return CODE_INVALID_STATE;
 	}
 
@@ -1943,7 +1941,7 @@ int CrossfireContext::commandEvaluate(Value* arguments, Value** _responseBody, w
 	Value* value_frame = arguments->getObjectValue(KEY_FRAMEINDEX);
 	if (value_frame) {
 		if (value_frame->getType() != TYPE_NUMBER || (unsigned int)value_frame->getNumberValue() < 0) {
-			*_message = _wcsdup(L"'evaluate' command has invalid 'frame' value");
+			*_message = _strdup("'evaluate' command has invalid 'frame' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		frame = (unsigned int)value_frame->getNumberValue();
@@ -1951,7 +1949,7 @@ int CrossfireContext::commandEvaluate(Value* arguments, Value** _responseBody, w
 
 	Value* value_expression = arguments->getObjectValue(KEY_EXPRESSION);
 	if (!value_expression || value_expression->getType() != TYPE_STRING) {
-		*_message = _wcsdup(L"'evaluate' command does not have a valid 'expression' value");
+		*_message = _strdup("'evaluate' command does not have a valid 'expression' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
@@ -1985,9 +1983,11 @@ int CrossfireContext::commandEvaluate(Value* arguments, Value** _responseBody, w
 
 	IDebugStackFrame* stackFrame = stackFrameDescriptor.pdsf;
 	CComPtr<IDebugProperty> debugProperty = NULL;
+	std::wstring expression;
+	UTF8Transcoder::toWide(value_expression->getStringValue(), value_expression->getStringLength(), &expression);
 	if (!evaluate(
 		stackFrame,
-		(wchar_t *)value_expression->getStringValue()->c_str(),
+		(wchar_t *)expression.c_str(),
 		DEBUG_TEXT_ISEXPRESSION | DEBUG_TEXT_RETURNVALUE | DEBUG_TEXT_ALLOWBREAKPOINTS | DEBUG_TEXT_ALLOWERRORREPORT,
 		&debugProperty)) {
 			return CODE_COMMAND_FAILED;
@@ -2002,15 +2002,14 @@ int CrossfireContext::commandEvaluate(Value* arguments, Value** _responseBody, w
 	}
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_RESULT, value_result);
-	delete value_result;
+	result->adoptObjectValue(KEY_RESULT, value_result);
 	*_responseBody = result;
 	return CODE_OK;
 }
 
-int CrossfireContext::commandFrame(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandFrame(Value* arguments, Value** _responseBody, char** _message) {
 	if (m_running) {
-		*_message = _wcsdup(L"'frame' request is only valid when execution is suspended");
+		*_message = _strdup("'frame' request is only valid when execution is suspended");
 		return CODE_INVALID_STATE;
 	}
 
@@ -2018,7 +2017,7 @@ int CrossfireContext::commandFrame(Value* arguments, Value** _responseBody, wcha
 	Value* value_includeScopes = arguments->getObjectValue(KEY_INCLUDESCOPES);
 	if (value_includeScopes) {
 		if (value_includeScopes->getType() != TYPE_BOOLEAN) {
-			*_message = _wcsdup(L"'frame' command has an invalid 'includeScopes' value");
+			*_message = _strdup("'frame' command has an invalid 'includeScopes' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		includeScopes = value_includeScopes->getBooleanValue();
@@ -2028,7 +2027,7 @@ int CrossfireContext::commandFrame(Value* arguments, Value** _responseBody, wcha
 	Value* value_index = arguments->getObjectValue(KEY_INDEX);
 	if (value_index) {
 		if (value_index->getType() != TYPE_NUMBER || (unsigned int)value_index->getNumberValue() < 0) {
-			*_message = _wcsdup(L"'frame' command has an invalid 'index' value");
+			*_message = _strdup("'frame' command has an invalid 'index' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		index = (unsigned int)value_index->getNumberValue();
@@ -2068,21 +2067,20 @@ int CrossfireContext::commandFrame(Value* arguments, Value** _responseBody, wcha
 	}
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_FRAME, frame);
+	result->adoptObjectValue(KEY_FRAME, frame);
 	*_responseBody = result;
-	delete frame;
 	return CODE_OK;
 }
 
-int CrossfireContext::commandLookup(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandLookup(Value* arguments, Value** _responseBody, char** _message) {
 	if (m_running) {
-		*_message = _wcsdup(L"'lookup' request is only valid when execution is suspended");
+		*_message = _strdup("'lookup' request is only valid when execution is suspended");
 		return CODE_INVALID_STATE;
 	}
 
 	Value* value_handles = arguments->getObjectValue(KEY_HANDLES);
 	if (!value_handles || value_handles->getType() != TYPE_ARRAY) {
-		*_message = _wcsdup(L"'lookup' command does not have a valid 'handles' value");
+		*_message = _strdup("'lookup' command does not have a valid 'handles' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
@@ -2090,19 +2088,17 @@ int CrossfireContext::commandLookup(Value* arguments, Value** _responseBody, wch
 	Value* value_includeSource = arguments->getObjectValue(KEY_INCLUDESOURCE);
 	if (value_includeSource) {
 		if (value_includeSource->getType() != TYPE_BOOLEAN) {
-			*_message = _wcsdup(L"'lookup' command has an invalid 'includeSource' value");
+			*_message = _strdup("'lookup' command has an invalid 'includeSource' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		includeSource = value_includeSource->getBooleanValue();
 	}
 
-	Value** handles = NULL;
-	value_handles->getArrayValues(&handles);
-	Value value_values;
-	value_values.setType(TYPE_ARRAY);
-	int index = 0;
-	Value* current = handles[index++];
-	while (current) {
+	Value* value_values = new Value();
+	value_values->setType(TYPE_ARRAY);
+	size_t size = value_handles->getArraySize();
+	for (size_t index = 0; index < size; index++) {
+		Value* current = value_handles->getArrayValueAt(index);
 		if (current->getType() == TYPE_NUMBER && current->getNumberValue() > 0) {
 			unsigned int handle = (unsigned int)current->getNumberValue();
 			std::map<unsigned int, JSObject*>::iterator iterator = m_objects->find(handle);
@@ -2141,24 +2137,21 @@ int CrossfireContext::commandLookup(Value* arguments, Value** _responseBody, wch
 				//			}
 				//		}
 					}
-					value_values.addArrayValue(value_object);
-					delete value_object;
+					value_values->adoptArrayValue(value_object);
 				}
 			}
 		}
-		current = handles[index++];
 	}
-	delete[] handles;
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_VALUES, &value_values);
+	result->adoptObjectValue(KEY_VALUES, value_values);
 	*_responseBody = result;
 	return CODE_OK;
 }
 
-int CrossfireContext::commandScopes(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandScopes(Value* arguments, Value** _responseBody, char** _message) {
 	if (m_running) {
-		*_message = _wcsdup(L"'scopes' request is only valid when execution is suspended");
+		*_message = _strdup("'scopes' request is only valid when execution is suspended");
 		return CODE_INVALID_STATE;
 	}
 
@@ -2166,25 +2159,21 @@ int CrossfireContext::commandScopes(Value* arguments, Value** _responseBody, wch
 	return CODE_COMMAND_NOT_IMPLEMENTED;
 }
 
-int CrossfireContext::commandScripts(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandScripts(Value* arguments, Value** _responseBody, char** _message) {
 	bool includeSource = false;
 	Value* value_includeSource = arguments->getObjectValue(KEY_INCLUDESOURCE);
 	if (value_includeSource) {
 		if (value_includeSource->getType() != TYPE_BOOLEAN) {
-			*_message = _wcsdup(L"'scripts' command has an invalid 'includeSource' value");
+			*_message = _strdup("'scripts' command has an invalid 'includeSource' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		includeSource = value_includeSource->getBooleanValue();
 	}
 
 	Value* value_ids = arguments->getObjectValue(KEY_URLS);
-	Value** ids = NULL;
-	if (value_ids) {
-		if (value_ids->getType() != TYPE_ARRAY) {
-			*_message = _wcsdup(L"'scripts' command has an invalid 'urls' value");
-			return CODE_INVALID_ARGUMENT;
-		}
-		value_ids->getArrayValues(&ids);
+	if (value_ids && value_ids->getType() != TYPE_ARRAY) {
+		*_message = _strdup("'scripts' command has an invalid 'urls' value");
+		return CODE_INVALID_ARGUMENT;
 	}
 
 	/*
@@ -2215,61 +2204,58 @@ int CrossfireContext::commandScripts(Value* arguments, Value** _responseBody, wc
 		}
 	}
 
-	Value scriptsArray;
-	scriptsArray.setType(TYPE_ARRAY);
+	Value* scriptsArray = new Value();
+	scriptsArray->setType(TYPE_ARRAY);
 	if (m_scriptNodes) {
 		/*
 		 * m_scriptNodes can contain multiple values with the same key (url), so
 		 * start by creating a map containing only one entry per url key.
 		 */
-		std::map<std::wstring, IDebugApplicationNode*> distinctUrls;
-		std::multimap<std::wstring, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->begin();
+		std::map<std::string, IDebugApplicationNode*> distinctUrls;
+		std::multimap<std::string, IDebugApplicationNode*>::iterator iterator = m_scriptNodes->begin();
 		while (iterator != m_scriptNodes->end()) {
-			distinctUrls.insert(std::pair<std::wstring, IDebugApplicationNode*>(iterator->first, iterator->second));
+			distinctUrls.insert(std::pair<std::string, IDebugApplicationNode*>(iterator->first, iterator->second));
 			iterator++;
 		}
 
-		std::map<std::wstring, IDebugApplicationNode*>::iterator distinctIterator = distinctUrls.begin();
+		std::map<std::string, IDebugApplicationNode*>::iterator distinctIterator = distinctUrls.begin();
 		while (distinctIterator != distinctUrls.end()) {
 			Value* value = NULL;
 			IDebugApplicationNode* node = distinctIterator->second;
 			bool include = false;
-			if (!ids) {
+			if (!value_ids) {
 				include = true;
 			} else {
 				URL* url = NULL;
 				getScriptUrl(node, &url);
-				int index = 0;
-				Value* current = ids[index++];
-				while (current) {
+				size_t size = value_ids->getArraySize();
+				for (size_t index = 0; index < size; index++) {
+					Value* current = value_ids->getArrayValueAt(index);
 					if (current->getType() == TYPE_STRING) {
-						if (url->isEqual((wchar_t*)current->getStringValue()->c_str())) {
+						if (url->isEqual((char*)current->getStringValue())) {
 							include = true;
 							break;
 						}
 					}
-					current = ids[index++];
 				}
 				delete url;
 			}
 			if (include && createValueForScript(node, includeSource, false, &value)) {
-				scriptsArray.addArrayValue(value);
-				delete value;
+				scriptsArray->adoptArrayValue(value);
 			}
 			distinctIterator++;
 		}
 	}
 
-	delete[] ids;
 	Value* result = new Value();
-	result->addObjectValue(KEY_SCRIPTS, &scriptsArray);
+	result->adoptObjectValue(KEY_SCRIPTS, scriptsArray);
 	*_responseBody = result;
 	return CODE_OK;
 }
 
-int CrossfireContext::commandSuspend(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireContext::commandSuspend(Value* arguments, Value** _responseBody, char** _message) {
 	if (!m_running) {
-		*_message = _wcsdup(L"'suspend' request is not valid when execution is suspended");
+		*_message = _strdup("'suspend' request is not valid when execution is suspended");
 		return CODE_INVALID_STATE;
 	}
 
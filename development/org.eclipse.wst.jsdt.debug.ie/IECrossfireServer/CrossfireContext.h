@@ -38,16 +38,16 @@ public:
 	void executionBreak(IRemoteDebugApplicationThread *pDebugAppThread, BREAKREASON br, IActiveScriptErrorDebug *pScriptErrorDebug);
 	bool getDebugApplication(IRemoteDebugApplication** _value);
 	IDebugApplicationNode* getLastInitializedScriptNode();
-	wchar_t* getName();
+	char* getName();
 	DWORD getProcessId();
-	wchar_t* getUrl();
+	char* getUrl();
 	void installBreakpoints(std::vector<Value*>* breakpoints);
 	bool performRequest(CrossfireRequest* request);
 	bool scriptInitialized(IDebugApplicationNode *applicationNode, bool isFromAnotherContext);
 	void scriptLoaded(IDebugApplicationNode *applicationNode, bool sendScriptLoadEvent);
 
 	/* IBreakpointTarget methods */
-	bool breakpointAttributeChanged(unsigned int handle, wchar_t* name, Value* value);
+	bool breakpointAttributeChanged(unsigned int handle, char* name, Value* value);
 	bool deleteBreakpoint(unsigned int handle);
 	CrossfireBreakpoint* getBreakpoint(unsigned int handle);
 	void getBreakpoints(CrossfireBreakpoint*** ___values);
@@ -88,115 +88,115 @@ private:
 	IIEDebugger* m_debugger;
 	IDebugApplicationNode* m_lastInitializedScriptNode;
 	bool m_debuggerHooked;
-	wchar_t* m_name;
+	char* m_name;
 	unsigned int m_nextObjectHandle;
 	std::map<unsigned int, JSObject*>* m_objects;
 	std::map<IDebugApplicationNode*, PendingScriptLoad*>* m_pendingScriptLoads;
 	DWORD m_processId;
 	bool m_running;
-	std::multimap<std::wstring, IDebugApplicationNode*>* m_scriptNodes;
+	std::multimap<std::string, IDebugApplicationNode*>* m_scriptNodes;
 	CrossfireServer* m_server;
 	DWORD m_threadId;
-	wchar_t* m_url;
+	char* m_url;
 
 	/* command: backtrace */
-	static const wchar_t* COMMAND_BACKTRACE;
-	static const wchar_t* KEY_FRAMES;
-	static const wchar_t* KEY_FROMFRAME;
-	static const wchar_t* KEY_TOFRAME;
-	static const wchar_t* KEY_TOTALFRAMES;
-	int commandBacktrace(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_BACKTRACE;
+	static ValueAtom* KEY_FRAMES;
+	static ValueAtom* KEY_FROMFRAME;
+	static ValueAtom* KEY_TOFRAME;
+	static ValueAtom* KEY_TOTALFRAMES;
+	int commandBacktrace(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: continue */
-	static const wchar_t* COMMAND_CONTINUE;
-	int commandContinue(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_CONTINUE;
+	int commandContinue(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: evaluate */
-	static const wchar_t* COMMAND_EVALUATE;
-	static const wchar_t* KEY_EXPRESSION;
-	static const wchar_t* KEY_RESULT;
-	int commandEvaluate(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_EVALUATE;
+	static ValueAtom* KEY_EXPRESSION;
+	static ValueAtom* KEY_RESULT;
+	int commandEvaluate(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: frame */
-	static const wchar_t* COMMAND_FRAME;
-	static const wchar_t* KEY_FRAME;
-	static const wchar_t* KEY_INDEX;
-	int commandFrame(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_FRAME;
+	static ValueAtom* KEY_FRAME;
+	static ValueAtom* KEY_INDEX;
+	int commandFrame(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: inspect */
-	static const wchar_t* COMMAND_INSPECT;
+	static const char* COMMAND_INSPECT;
 
 	/* command: lookup */
-	static const wchar_t* COMMAND_LOOKUP;
-	static const wchar_t* KEY_HANDLES;
-	static const wchar_t* KEY_VALUES;
-	int commandLookup(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_LOOKUP;
+	static ValueAtom* KEY_HANDLES;
+	static ValueAtom* KEY_VALUES;
+	int commandLookup(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: scopes */
-	static const wchar_t* COMMAND_SCOPES;
-	static const wchar_t* KEY_FROMSCOPE;
-	static const wchar_t* KEY_SCOPES;
-	static const wchar_t* KEY_TOSCOPE;
-	static const wchar_t* KEY_TOTALSCOPECOUNT;
-	int commandScopes(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_SCOPES;
+	static ValueAtom* KEY_FROMSCOPE;
+	static ValueAtom* KEY_SCOPES;
+	static ValueAtom* KEY_TOSCOPE;
+	static ValueAtom* KEY_TOTALSCOPECOUNT;
+	int commandScopes(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: scripts */
-	static const wchar_t* COMMAND_SCRIPTS;
-	static const wchar_t* KEY_SCRIPTS;
-	static const wchar_t* KEY_URLS;
-	int commandScripts(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_SCRIPTS;
+	static ValueAtom* KEY_SCRIPTS;
+	static ValueAtom* KEY_URLS;
+	int commandScripts(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: suspend */
-	static const wchar_t* COMMAND_SUSPEND;
-	static const wchar_t* KEY_STEPACTION;
-	static const wchar_t* VALUE_IN;
-	static const wchar_t* VALUE_NEXT;
-	static const wchar_t* VALUE_OUT;
-	int commandSuspend(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_SUSPEND;
+	static ValueAtom* KEY_STEPACTION;
+	static const char* VALUE_IN;
+	static const char* VALUE_NEXT;
+	static const char* VALUE_OUT;
+	int commandSuspend(Value* arguments, Value** _responseBody, char** _message);
 
 	/* event: onBreak */
-	static const wchar_t* EVENT_ONBREAK;
-	static const wchar_t* KEY_CAUSE;
-	static const wchar_t* KEY_MESSAGE;
-	static const wchar_t* KEY_TITLE;
+	static const char* EVENT_ONBREAK;
+	static ValueAtom* KEY_CAUSE;
+	static ValueAtom* KEY_MESSAGE;
+	static ValueAtom* KEY_TITLE;
 
 	/* event: onError */
-	static const wchar_t* EVENT_ONERROR;
-	static const wchar_t* KEY_CATEGORY;
-	static const wchar_t* KEY_COLUMNNUMBER;
-	static const wchar_t* KEY_ERROR;
-	static const wchar_t* KEY_FILENAME;
-	static const wchar_t* KEY_LINENUMBER;
-	static const wchar_t* VALUE_JS;
+	static const char* EVENT_ONERROR;
+	static ValueAtom* KEY_CATEGORY;
+	static ValueAtom* KEY_COLUMNNUMBER;
+	static ValueAtom* KEY_ERROR;
+	static ValueAtom* KEY_FILENAME;
+	static ValueAtom* KEY_LINENUMBER;
+	static const char* VALUE_JS;
 
 	/* event: onResume */
-	static const wchar_t* EVENT_ONRESUME;
+	static const char* EVENT_ONRESUME;
 
 	/* event: onScript */
-	static const wchar_t* EVENT_ONSCRIPT;
-	static const wchar_t* KEY_SCRIPT;
+	static const char* EVENT_ONSCRIPT;
+	static ValueAtom* KEY_SCRIPT;
 
 	/* event: onToggleBreakpoint */
-	static const wchar_t* EVENT_ONTOGGLEBREAKPOINT;
-	static const wchar_t* KEY_SET;
+	static const char* EVENT_ONTOGGLEBREAKPOINT;
+	static ValueAtom* KEY_SET;
 
 	/* shared */
-	static const wchar_t* KEY_BREAKPOINT;
-	static const wchar_t* KEY_CONTEXTID;
-	static const wchar_t* KEY_FRAMEINDEX;
-	static const wchar_t* KEY_HANDLE;
-	static const wchar_t* KEY_INCLUDESCOPES;
-	static const wchar_t* KEY_INCLUDESOURCE;
-	static const wchar_t* KEY_LINE;
-	static const wchar_t* KEY_LOCATION;
-	static const wchar_t* KEY_TYPE;
-	static const wchar_t* KEY_URL;
+	static ValueAtom* KEY_BREAKPOINT;
+	static ValueAtom* KEY_CONTEXTID;
+	static ValueAtom* KEY_FRAMEINDEX;
+	static ValueAtom* KEY_HANDLE;
+	static ValueAtom* KEY_INCLUDESCOPES;
+	static ValueAtom* KEY_INCLUDESOURCE;
+	static ValueAtom* KEY_LINE;
+	static ValueAtom* KEY_LOCATION;
+	static ValueAtom* KEY_TYPE;
+	static ValueAtom* KEY_URL;
 
 	/* breakpoint objects */
-	static const wchar_t* BPTYPE_LINE;
+	static const char* BPTYPE_LINE;
 
 	/* frame objects */
-	static const wchar_t* KEY_FUNCTIONNAME;
+	static ValueAtom* KEY_FUNCTIONNAME;
 
 	/* object objects */
 	static const wchar_t* JSVALUE_BOOLEAN;
@@ -206,35 +206,35 @@ private:
 	static const wchar_t* JSVALUE_STRING;
 	static const wchar_t* JSVALUE_TRUE;
 	static const wchar_t* JSVALUE_UNDEFINED;
-	static const wchar_t* KEY_LOCALS;
-	static const wchar_t* KEY_THIS;
-	static const wchar_t* KEY_VALUE;
-	static const wchar_t* VALUE_BOOLEAN;
-	static const wchar_t* VALUE_FUNCTION;
-	static const wchar_t* VALUE_NUMBER;
-	static const wchar_t* VALUE_OBJECT;
-	static const wchar_t* VALUE_STRING;
-	static const wchar_t* VALUE_UNDEFINED;
+	static ValueAtom* KEY_LOCALS;
+	static ValueAtom* KEY_THIS;
+	static ValueAtom* KEY_VALUE;
+	static const char* VALUE_BOOLEAN;
+	static const char* VALUE_FUNCTION;
+	static const char* VALUE_NUMBER;
+	static const char* VALUE_OBJECT;
+	static const char* VALUE_STRING;
+	static const char* VALUE_UNDEFINED;
 
 	/* script objects */
-	static const wchar_t* KEY_COLUMNOFFSET;
-	static const wchar_t* KEY_LINECOUNT;
-	static const wchar_t* KEY_LINEOFFSET;
-	static const wchar_t* KEY_SOURCE;
-	static const wchar_t* KEY_SOURCELENGTH;
-	static const wchar_t* VALUE_EVALCODE;
-	static const wchar_t* VALUE_EVALLEVEL;
-	static const wchar_t* VALUE_TOPLEVEL;
+	static ValueAtom* KEY_COLUMNOFFSET;
+	static ValueAtom* KEY_LINECOUNT;
+	static ValueAtom* KEY_LINEOFFSET;
+	static ValueAtom* KEY_SOURCE;
+	static ValueAtom* KEY_SOURCELENGTH;
+	static const char* VALUE_EVALCODE;
+	static const char* VALUE_EVALLEVEL;
+	static const char* VALUE_TOPLEVEL;
 
 	/* other */
 	static const wchar_t* ABOUT_BLANK;
-	static const wchar_t* ID_PREAMBLE;
+	static const char* ID_PREAMBLE;
 	static const wchar_t* NUMBER_INFINITY;
 	static const wchar_t* NUMBER_NaN;
 	static const wchar_t* NUMBER_NEGATIVEINFINITY;
 	static const wchar_t* PDM_DLL;
-	static const wchar_t* SCHEME_SCRIPT;
-	static const wchar_t* VALUE_INFINITY;
-	static const wchar_t* VALUE_NaN;
-	static const wchar_t* VALUE_NEGATIVEINFINITY;
+	static const char* SCHEME_SCRIPT;
+	static const char* VALUE_INFINITY;
+	static const char* VALUE_NaN;
+	static const char* VALUE_NEGATIVEINFINITY;
 };
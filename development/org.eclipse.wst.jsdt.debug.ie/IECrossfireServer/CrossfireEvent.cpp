@@ -23,6 +23,22 @@ CrossfireEvent::~CrossfireEvent() {
 	}
 }
 
+/*
+ * Sets the event's body to the given value without copying it, so the event
+ * becomes responsible for deleting it, even if it is rejected for not being an object.
+ */
+bool CrossfireEvent::adoptBody(Value* value) {
+	if (value && value->getType() != TYPE_OBJECT) {
+		delete value;
+		return false;
+	}
+	if (m_body) {
+		delete m_body;
+	}
+	m_body = value;
+	return true;
+}
+
 void CrossfireEvent::clone(CrossfirePacket** _value) {
 	CrossfireEvent* result = new CrossfireEvent();
 	result->setContextId(getContextId());
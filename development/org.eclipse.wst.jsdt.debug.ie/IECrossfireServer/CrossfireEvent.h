@@ -20,6 +20,7 @@ class CrossfireEvent : public CrossfirePacket {
 public:
 	CrossfireEvent();
 	virtual ~CrossfireEvent();
+	bool adoptBody(Value* value);
 	void clone(CrossfirePacket** _value);
 	Value* getBody();
 	int getType();
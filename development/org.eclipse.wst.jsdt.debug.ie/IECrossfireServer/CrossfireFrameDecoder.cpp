@@ -0,0 +1,228 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "CrossfireFrameDecoder.h"
+
+/* initialize constants */
+const char* CrossfireFrameDecoder::HANDSHAKE = "CrossfireHandshake\r\n";
+const char* CrossfireFrameDecoder::HEADER_CONTENTLENGTH = "Content-Length:";
+const char* CrossfireFrameDecoder::LINEBREAK = "\r\n";
+const size_t CrossfireFrameDecoder::LINEBREAK_LENGTH = 2;
+const size_t CrossfireFrameDecoder::MAX_CONTENT_LENGTH = 0x7FFFFFFF;
+const size_t CrossfireFrameDecoder::MAX_HANDSHAKE_LENGTH = 4096;
+
+CrossfireFrameDecoder::CrossfireFrameDecoder() {
+	m_line = new std::string;
+	reset();
+}
+
+CrossfireFrameDecoder::~CrossfireFrameDecoder() {
+	delete m_line;
+}
+
+/*
+ * Decodes bytes until a frame is complete or the bytes are exhausted, and
+ * returns the number of bytes consumed.  The frame's type is FRAME_NONE if
+ * all of the bytes were consumed without completing a frame.  Any slice in
+ * the frame is only valid until the next call.
+ */
+size_t CrossfireFrameDecoder::decode(const char* bytes, size_t length, Frame* _frame) {
+	_frame->type = FRAME_NONE;
+	_frame->chars = NULL;
+	_frame->length = 0;
+	_frame->isFirst = false;
+	_frame->isTerminated = false;
+	_frame->message = NULL;
+
+	const char* current = bytes;
+	const char* end = bytes + length;
+	while (current < end) {
+		switch (m_state) {
+			case STATE_HANDSHAKE: {
+				if (*current++ != HANDSHAKE[m_matched]) {
+					return fail("Crossfire content received before handshake, not processing it", length, _frame);
+				}
+				if (!HANDSHAKE[++m_matched]) {
+					m_line->clear();
+					m_state = STATE_HANDSHAKE_TOOLS;
+				}
+				break;
+			}
+			case STATE_HANDSHAKE_TOOLS: {
+				/* the tools line is accumulated, so its length is bounded */
+				const char* lineEnd = (const char*)memchr(current, '\r', end - current);
+				size_t chunkLength = (lineEnd ? lineEnd : end) - current;
+				if (MAX_HANDSHAKE_LENGTH - m_line->length() < chunkLength) {
+					return fail("Invalid handshake packet, its tools line is too long", length, _frame);
+				}
+				if (!lineEnd) {
+					m_line->append(current, chunkLength);
+					current = end;
+					break;
+				}
+				m_line->append(current, chunkLength);
+				current = lineEnd + 1;
+				m_state = STATE_HANDSHAKE_LF;
+				break;
+			}
+			case STATE_HANDSHAKE_LF: {
+				if (*current++ != '\n') {
+					return fail("Invalid handshake packet, does not follow '\\r' with '\\n'", length, _frame);
+				}
+				m_matched = 0;
+				m_state = STATE_HEADER;
+				_frame->type = FRAME_HANDSHAKE;
+				_frame->chars = m_line->data();
+				_frame->length = m_line->length();
+				return current - bytes;
+			}
+			case STATE_HEADER: {
+				if (*current++ != HEADER_CONTENTLENGTH[m_matched]) {
+					return fail("request packet does not start with 'Content-Length:', not processing it", length, _frame);
+				}
+				if (!HEADER_CONTENTLENGTH[++m_matched]) {
+					m_contentLength = 0;
+					m_matched = 0;
+					m_state = STATE_LENGTH;
+				}
+				break;
+			}
+			case STATE_LENGTH: {
+				char c = *current++;
+				if ('0' <= c && c <= '9') {
+					if ((MAX_CONTENT_LENGTH - (c - '0')) / 10 < m_contentLength) {
+						return fail("request packet does not have a valid 'Content-Length' value, not processing it", length, _frame);
+					}
+					m_contentLength = m_contentLength * 10 + (c - '0');
+					m_matched++;
+				} else if (c == ' ' && !m_matched) {
+					/* whitespace before the value */
+				} else if (c == '\r' && m_contentLength) {
+					m_state = STATE_LENGTH_LF;
+				} else {
+					return fail("request packet does not have a valid 'Content-Length' value, not processing it", length, _frame);
+				}
+				break;
+			}
+			case STATE_LENGTH_LF: {
+				if (*current++ != '\n') {
+					return fail("request packet does not follow initial '\\r' with '\\n', not processing it", length, _frame);
+				}
+				m_state = STATE_HEADER_LINE_START;
+				break;
+			}
+			case STATE_HEADER_LINE_START: {
+				m_state = *current++ == '\r' ? STATE_HEADER_END_LF : STATE_HEADER_LINE;
+				break;
+			}
+			case STATE_HEADER_LINE: {
+				// TODO for now just skip over "tool:" lines, though these should really be validated
+				const char* lineEnd = (const char*)memchr(current, '\r', end - current);
+				if (!lineEnd) {
+					current = end;
+					break;
+				}
+				current = lineEnd + 1;
+				m_state = STATE_HEADER_LINE_LF;
+				break;
+			}
+			case STATE_HEADER_LINE_LF:
+			case STATE_HEADER_END_LF: {
+				if (*current++ != '\n') {
+					return fail("request packet has a header line that does not end with '\\r\\n', not processing it", length, _frame);
+				}
+				if (m_state == STATE_HEADER_LINE_LF) {
+					m_state = STATE_HEADER_LINE_START;
+					break;
+				}
+				m_isFirst = true;
+				m_remaining = m_contentLength;
+				m_state = STATE_CONTENT;
+				break;
+			}
+			case STATE_CONTENT: {
+				size_t available = end - current;
+				if (m_isFirst && m_remaining + LINEBREAK_LENGTH <= available) {
+					/* common case, the entire packet has been received at once */
+					_frame->type = FRAME_PACKET;
+					_frame->chars = current;
+					_frame->length = m_remaining;
+					_frame->isTerminated = memcmp(current + m_remaining, LINEBREAK, LINEBREAK_LENGTH) == 0;
+					current += m_remaining + LINEBREAK_LENGTH;
+					m_matched = 0;
+					m_state = STATE_HEADER;
+					return current - bytes;
+				}
+
+				size_t count = m_remaining < available ? m_remaining : available;
+				_frame->type = FRAME_CONTENT;
+				_frame->chars = current;
+				_frame->length = count;
+				_frame->isFirst = m_isFirst;
+				current += count;
+				m_isFirst = false;
+				m_remaining -= count;
+				if (!m_remaining) {
+					m_matched = 0;
+					m_terminated = true;
+					m_state = STATE_CONTENT_TERMINATOR;
+				}
+				return current - bytes;
+			}
+			case STATE_CONTENT_TERMINATOR: {
+				if (*current++ != LINEBREAK[m_matched]) {
+					m_terminated = false;
+				}
+				if (++m_matched == LINEBREAK_LENGTH) {
+					m_matched = 0;
+					m_state = STATE_HEADER;
+					_frame->type = FRAME_CONTENT_END;
+					_frame->isTerminated = m_terminated;
+					return current - bytes;
+				}
+				break;
+			}
+		}
+	}
+	return length;
+}
+
+/*
+ * Reports an error in the handshake or a packet's header.  The remainder of
+ * the bytes cannot be framed, so they are discarded, and decoding resumes
+ * with the next chunk at the start of the handshake or a packet.
+ */
+size_t CrossfireFrameDecoder::fail(const char* message, size_t length, Frame* _frame) {
+	if (m_state == STATE_HANDSHAKE || m_state == STATE_HANDSHAKE_LF || m_state == STATE_HANDSHAKE_TOOLS) {
+		m_state = STATE_HANDSHAKE;
+	} else {
+		m_state = STATE_HEADER;
+	}
+	m_matched = 0;
+	_frame->type = FRAME_ERROR;
+	_frame->message = message;
+	return length;
+}
+
+/*
+ * Prepares to decode a new connection, which starts with the handshake.
+ */
+void CrossfireFrameDecoder::reset() {
+	m_contentLength = 0;
+	m_isFirst = false;
+	m_line->clear();
+	m_matched = 0;
+	m_remaining = 0;
+	m_state = STATE_HANDSHAKE;
+	m_terminated = true;
+}
@@ -0,0 +1,89 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+/*
+ * Splits the bytes received from the client into the handshake and request
+ * packets.  Each received chunk is passed to decode() until it is consumed,
+ * and its bytes are examined once, in place, by a state machine that keeps
+ * its position within the handshake or packet between chunks.  A packet's
+ * content is reported as a slice of the chunk, in a single FRAME_PACKET if
+ * the chunk contains all of it, or otherwise as the FRAME_CONTENT portions
+ * that each chunk contains followed by a FRAME_CONTENT_END.  Content-Length
+ * counts the content's bytes, so UTF-8 content is framed correctly.
+ */
+class CrossfireFrameDecoder {
+
+public:
+	CrossfireFrameDecoder();
+	~CrossfireFrameDecoder();
+
+	/* frame types */
+	enum {
+		FRAME_NONE,
+		FRAME_CONTENT,
+		FRAME_CONTENT_END,
+		FRAME_ERROR,
+		FRAME_HANDSHAKE,
+		FRAME_PACKET,
+	};
+
+	struct Frame {
+		int type;
+		const char* chars; /* the handshake's tools, or all or part of a packet's content */
+		size_t length;
+		bool isFirst; /* FRAME_CONTENT: whether this is the first portion of the content */
+		bool isTerminated; /* FRAME_CONTENT_END, FRAME_PACKET: whether the content is followed by "\r\n" */
+		const char* message; /* FRAME_ERROR */
+	};
+
+	size_t decode(const char* bytes, size_t length, Frame* _frame);
+	void reset();
+
+private:
+	size_t fail(const char* message, size_t length, Frame* _frame);
+
+	size_t m_contentLength;
+	bool m_isFirst;
+	std::string* m_line;
+	size_t m_matched;
+	size_t m_remaining;
+	int m_state;
+	bool m_terminated;
+
+	/* decoder states */
+	enum {
+		STATE_CONTENT,
+		STATE_CONTENT_TERMINATOR,
+		STATE_HANDSHAKE,
+		STATE_HANDSHAKE_LF,
+		STATE_HANDSHAKE_TOOLS,
+		STATE_HEADER,
+		STATE_HEADER_END_LF,
+		STATE_HEADER_LINE,
+		STATE_HEADER_LINE_LF,
+		STATE_HEADER_LINE_START,
+		STATE_LENGTH,
+		STATE_LENGTH_LF,
+	};
+
+	/* constants */
+	static const char* HANDSHAKE;
+	static const char* HEADER_CONTENTLENGTH;
+	static const char* LINEBREAK;
+	static const size_t LINEBREAK_LENGTH;
+	static const size_t MAX_CONTENT_LENGTH;
+	static const size_t MAX_HANDSHAKE_LENGTH;
+};
@@ -14,15 +14,15 @@
 #include "CrossfireLineBreakpoint.h"
 
 /* initialize constants */
-const wchar_t* CrossfireLineBreakpoint::BPTYPESTRING_LINE = L"line";
-const wchar_t* CrossfireLineBreakpoint::KEY_CONDITION = L"condition";
-const wchar_t* CrossfireLineBreakpoint::KEY_ENABLED = L"enabled";
-const wchar_t* CrossfireLineBreakpoint::KEY_HITCOUNT = L"hitCount";
-const wchar_t* CrossfireLineBreakpoint::KEY_LINE = L"line";
-const wchar_t* CrossfireLineBreakpoint::KEY_URL = L"url";
-const wchar_t* CrossfireLineBreakpoint::ATTRIBUTE_CONDITION = KEY_CONDITION;
-const wchar_t* CrossfireLineBreakpoint::ATTRIBUTE_ENABLED = KEY_ENABLED;
-const wchar_t* CrossfireLineBreakpoint::ATTRIBUTE_HITCOUNT = KEY_HITCOUNT;
+const char* CrossfireLineBreakpoint::BPTYPESTRING_LINE = "line";
+ValueAtom* CrossfireLineBreakpoint::KEY_CONDITION = ValueAtom::intern("condition");
+ValueAtom* CrossfireLineBreakpoint::KEY_ENABLED = ValueAtom::intern("enabled");
+ValueAtom* CrossfireLineBreakpoint::KEY_HITCOUNT = ValueAtom::intern("hitCount");
+ValueAtom* CrossfireLineBreakpoint::KEY_LINE = ValueAtom::intern("line");
+ValueAtom* CrossfireLineBreakpoint::KEY_URL = ValueAtom::intern("url");
+const char* CrossfireLineBreakpoint::ATTRIBUTE_CONDITION = KEY_CONDITION->getChars();
+const char* CrossfireLineBreakpoint::ATTRIBUTE_ENABLED = KEY_ENABLED->getChars();
+const char* CrossfireLineBreakpoint::ATTRIBUTE_HITCOUNT = KEY_HITCOUNT->getChars();
 
 CrossfireLineBreakpoint::CrossfireLineBreakpoint() : CrossfireBreakpoint() {
 	m_hitCounter = 0;
@@ -42,8 +42,8 @@ CrossfireLineBreakpoint::~CrossfireLineBreakpoint() {
 	}
 }
 
-bool CrossfireLineBreakpoint::CanHandleBPType(wchar_t* type) {
-	return wcscmp(type, BPTYPESTRING_LINE) == 0;
+bool CrossfireLineBreakpoint::CanHandleBPType(char* type) {
+	return strcmp(type, BPTYPESTRING_LINE) == 0;
 }
 
 bool CrossfireLineBreakpoint::appliesToUrl(URL* url) {
@@ -53,16 +53,16 @@ bool CrossfireLineBreakpoint::appliesToUrl(URL* url) {
 	return m_url->isEqual(url);
 }
 
-bool CrossfireLineBreakpoint::attributeIsValid(wchar_t* name, Value* value) {
-	if (wcscmp(name, ATTRIBUTE_CONDITION) == 0) {
+bool CrossfireLineBreakpoint::attributeIsValid(char* name, Value* value) {
+	if (strcmp(name, ATTRIBUTE_CONDITION) == 0) {
 		return (value->getType() & (TYPE_STRING | TYPE_NULL)) != 0;
 	}
 
-	if (wcscmp(name, ATTRIBUTE_ENABLED) == 0) {
+	if (strcmp(name, ATTRIBUTE_ENABLED) == 0) {
 		return (value->getType() & (TYPE_BOOLEAN | TYPE_NULL)) != 0;
 	}
 
-	if (wcscmp(name, ATTRIBUTE_HITCOUNT) == 0) {
+	if (strcmp(name, ATTRIBUTE_HITCOUNT) == 0) {
 		return value->getType() == TYPE_NULL || (value->getType() == TYPE_NUMBER && value->getNumberValue() >= 0);
 	}
 
@@ -76,8 +76,8 @@ void CrossfireLineBreakpoint::breakpointHit() {
 
 void CrossfireLineBreakpoint::clone(CrossfireBreakpoint** _value) {
 	CrossfireLineBreakpoint* result = new CrossfireLineBreakpoint(getHandle());
-	result->setCondition((std::wstring*)getCondition());
-	result->setContextId((std::wstring*)getContextId());
+	result->setCondition(getCondition());
+	result->setContextId((std::string*)getContextId());
 	result->setEnabled(isEnabled());
 	result->setHitCount(getHitCount());
 	result->setLine(getLine());
@@ -86,8 +86,8 @@ void CrossfireLineBreakpoint::clone(CrossfireBreakpoint** _value) {
 	*_value = result;
 }
 
-const std::wstring* CrossfireLineBreakpoint::getCondition() {
-	Value* value = getAttribute((wchar_t*)ATTRIBUTE_CONDITION);
+const char* CrossfireLineBreakpoint::getCondition() {
+	Value* value = getAttribute((char*)ATTRIBUTE_CONDITION);
 	if (value) {
 		return value->getStringValue();
 	}
@@ -95,7 +95,7 @@ const std::wstring* CrossfireLineBreakpoint::getCondition() {
 }
 
 unsigned int CrossfireLineBreakpoint::getHitCount() {
-	Value* value = getAttribute((wchar_t*)ATTRIBUTE_HITCOUNT);
+	Value* value = getAttribute((char*)ATTRIBUTE_HITCOUNT);
 	if (value) {
 		return (unsigned int)value->getNumberValue();
 	}
@@ -111,8 +111,8 @@ bool CrossfireLineBreakpoint::getLocationAsValue(Value** _value) {
 		return false;
 	}
 	Value* result = new Value();
-	result->setObjectValue(KEY_URL, &Value(m_url->getString()));
-	result->setObjectValue(KEY_LINE, &Value((double)m_line));
+	result->adoptObjectValue(KEY_URL, new Value(m_url->getString()));
+	result->adoptObjectValue(KEY_LINE, new Value((double)m_line));
 	*_value = result;
 	return true;
 }
@@ -121,7 +121,7 @@ int CrossfireLineBreakpoint::getType() {
 	return BPTYPE_LINE;
 }
 
-const wchar_t* CrossfireLineBreakpoint::getTypeString() {
+const char* CrossfireLineBreakpoint::getTypeString() {
 	return BPTYPESTRING_LINE;
 }
 
@@ -130,7 +130,7 @@ const URL* CrossfireLineBreakpoint::getUrl() {
 }
 
 bool CrossfireLineBreakpoint::isEnabled() {
-	Value* value = getAttribute((wchar_t*)ATTRIBUTE_ENABLED);
+	Value* value = getAttribute((char*)ATTRIBUTE_ENABLED);
 	if (value) {
 		return value->getBooleanValue();
 	}
@@ -162,22 +162,22 @@ bool CrossfireLineBreakpoint::matchesLocation(CrossfireBreakpoint* breakpoint) {
 	return true;
 }
 
-void CrossfireLineBreakpoint::setCondition(std::wstring* value) {
+void CrossfireLineBreakpoint::setCondition(const char* value) {
 	if (!value) {
 		Value value_null;
 		value_null.setType(TYPE_NULL);
-		setAttribute((wchar_t*)ATTRIBUTE_CONDITION, &value_null);
+		setAttribute((char*)ATTRIBUTE_CONDITION, &value_null);
 	} else {
-		setAttribute((wchar_t*)ATTRIBUTE_CONDITION, &Value(value));
+		setAttribute((char*)ATTRIBUTE_CONDITION, &Value(value));
 	}
 }
 
 void CrossfireLineBreakpoint::setEnabled(bool value) {
-	setAttribute((wchar_t*)ATTRIBUTE_ENABLED, &Value(value));
+	setAttribute((char*)ATTRIBUTE_ENABLED, &Value(value));
 }
 
 void CrossfireLineBreakpoint::setHitCount(unsigned int value) {
-	setAttribute((wchar_t*)ATTRIBUTE_HITCOUNT, &Value((double)value));
+	setAttribute((char*)ATTRIBUTE_HITCOUNT, &Value((double)value));
 }
 
 void CrossfireLineBreakpoint::setLine(unsigned int value) {
@@ -195,8 +195,8 @@ bool CrossfireLineBreakpoint::setLocationFromValue(Value* value) {
 		return false;
 	}
 
-	std::wstring* url = value_url->getStringValue();
-	if (!setUrl(&URL((wchar_t*)url->c_str()))) {
+	const char* url = value_url->getStringValue();
+	if (!setUrl(&URL((char*)url))) {
 		return false;
 	}
 	setLine((unsigned int)value_line->getNumberValue());
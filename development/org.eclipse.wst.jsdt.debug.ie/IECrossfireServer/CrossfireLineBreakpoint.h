@@ -25,16 +25,16 @@ public:
 	bool appliesToUrl(URL* url);
 	void breakpointHit();
 	void clone(CrossfireBreakpoint** _value);
-	const std::wstring* getCondition();
+	const char* getCondition();
 	unsigned int getHitCount();
 	unsigned int getLine();
 	int getType();
-	const wchar_t* getTypeString();
+	const char* getTypeString();
 	const URL* getUrl();
 	bool isEnabled();
 	bool matchesHitCount();
 	bool matchesLocation(CrossfireBreakpoint* breakpoint);
-	void setCondition(std::wstring* value);
+	void setCondition(const char* value);
 	void setEnabled(bool value);
 	void setHitCount(unsigned int value);
 	void setLine(unsigned int value);
@@ -42,15 +42,15 @@ public:
 	bool setUrl(URL* value);
 
 	/* static methods */
-	static bool CanHandleBPType(wchar_t* type);
+	static bool CanHandleBPType(char* type);
 
-	static const wchar_t* ATTRIBUTE_CONDITION;
-	static const wchar_t* ATTRIBUTE_ENABLED;
-	static const wchar_t* ATTRIBUTE_HITCOUNT;
+	static const char* ATTRIBUTE_CONDITION;
+	static const char* ATTRIBUTE_ENABLED;
+	static const char* ATTRIBUTE_HITCOUNT;
 
 protected:
 	CrossfireLineBreakpoint(unsigned int handle);
-	bool attributeIsValid(wchar_t* name, Value* value);
+	bool attributeIsValid(char* name, Value* value);
 	bool getLocationAsValue(Value** _value);
 
 private:
@@ -58,10 +58,10 @@ private:
 	unsigned int m_line;
 	URL* m_url;
 
-	static const wchar_t* BPTYPESTRING_LINE;
-	static const wchar_t* KEY_CONDITION;
-	static const wchar_t* KEY_ENABLED;
-	static const wchar_t* KEY_HITCOUNT;
-	static const wchar_t* KEY_LINE;
-	static const wchar_t* KEY_URL;
+	static const char* BPTYPESTRING_LINE;
+	static ValueAtom* KEY_CONDITION;
+	static ValueAtom* KEY_ENABLED;
+	static ValueAtom* KEY_HITCOUNT;
+	static ValueAtom* KEY_LINE;
+	static ValueAtom* KEY_URL;
 };
@@ -28,11 +28,11 @@ CrossfirePacket::~CrossfirePacket() {
 	}
 }
 
-std::wstring* CrossfirePacket::getContextId() {
+std::string* CrossfirePacket::getContextId() {
 	return m_contextId;
 }
 
-wchar_t* CrossfirePacket::getName() {
+char* CrossfirePacket::getName() {
 	return m_name;
 }
 
@@ -40,24 +40,24 @@ unsigned int CrossfirePacket::getSeq() {
 	return m_seq;
 }
 
-void CrossfirePacket::setContextId(std::wstring* value) {
+void CrossfirePacket::setContextId(std::string* value) {
 	if (m_contextId) {
 		delete m_contextId;
 		m_contextId = NULL;
 	}
 	if (value) {
-		m_contextId = new std::wstring;
+		m_contextId = new std::string;
 		m_contextId->assign(*value);
 	}
 }
 
-void CrossfirePacket::setName(const wchar_t* value) {
+void CrossfirePacket::setName(const char* value) {
 	if (m_name) {
 		free(m_name);
 		m_name = NULL;
 	}
 	if (value) {
-		m_name = _wcsdup(value);
+		m_name = _strdup(value);
 	}
 }
 
@@ -20,12 +20,12 @@ public:
 	CrossfirePacket();
 	virtual ~CrossfirePacket();
 	virtual void clone(CrossfirePacket** _value) = 0;
-	std::wstring* getContextId();
-	wchar_t* getName();
+	std::string* getContextId();
+	char* getName();
 	unsigned int getSeq();
 	virtual int getType() = 0;
-	void setContextId(std::wstring* value);
-	void setName(const wchar_t* value);
+	void setContextId(std::string* value);
+	void setName(const char* value);
 	void setSeq(unsigned int);
 
 	enum {
@@ -35,7 +35,7 @@ public:
 	};
 
 private:
-	std::wstring* m_contextId;
-	wchar_t* m_name;
+	std::string* m_contextId;
+	char* m_name;
 	unsigned int m_seq;
 };
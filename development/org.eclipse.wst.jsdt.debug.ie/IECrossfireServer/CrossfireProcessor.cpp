@@ -14,127 +14,171 @@
 #include "CrossfireProcessor.h"
 
 /* initialize constants */
-const wchar_t* CrossfireProcessor::HEADER_CONTENTLENGTH = L"Content-Length:";
-const wchar_t* CrossfireProcessor::LINEBREAK = L"\r\n";
-const size_t CrossfireProcessor::LINEBREAK_LENGTH = 2;
-const wchar_t* CrossfireProcessor::NAME_ARGUMENTS = L"arguments";
-const wchar_t* CrossfireProcessor::NAME_BODY = L"body";
-const wchar_t* CrossfireProcessor::NAME_CODE = L"code";
-const wchar_t* CrossfireProcessor::NAME_COMMAND = L"command";
-const wchar_t* CrossfireProcessor::NAME_CONTEXTID = L"contextId";
-const wchar_t* CrossfireProcessor::NAME_EVENT = L"event";
-const wchar_t* CrossfireProcessor::NAME_MESSAGE = L"message";
-const wchar_t* CrossfireProcessor::NAME_REQUESTSEQ = L"requestSeq";
-const wchar_t* CrossfireProcessor::NAME_RUNNING = L"running";
-const wchar_t* CrossfireProcessor::NAME_SEQ = L"seq";
-const wchar_t* CrossfireProcessor::NAME_STATUS = L"status";
-const wchar_t* CrossfireProcessor::NAME_TYPE = L"type";
-const wchar_t* CrossfireProcessor::VALUE_EVENT = L"event";
-const wchar_t* CrossfireProcessor::VALUE_REQUEST = L"request";
-const wchar_t* CrossfireProcessor::VALUE_RESPONSE = L"response";
+ValueAtom* CrossfireProcessor::NAME_ARGUMENTS = ValueAtom::intern("arguments");
+ValueAtom* CrossfireProcessor::NAME_BODY = ValueAtom::intern("body");
+ValueAtom* CrossfireProcessor::NAME_CODE = ValueAtom::intern("code");
+ValueAtom* CrossfireProcessor::NAME_COMMAND = ValueAtom::intern("command");
+ValueAtom* CrossfireProcessor::NAME_CONTEXTID = ValueAtom::intern("contextId");
+ValueAtom* CrossfireProcessor::NAME_EVENT = ValueAtom::intern("event");
+ValueAtom* CrossfireProcessor::NAME_MESSAGE = ValueAtom::intern("message");
+ValueAtom* CrossfireProcessor::NAME_REQUESTSEQ = ValueAtom::intern("requestSeq");
+ValueAtom* CrossfireProcessor::NAME_RUNNING = ValueAtom::intern("running");
+ValueAtom* CrossfireProcessor::NAME_SEQ = ValueAtom::intern("seq");
+ValueAtom* CrossfireProcessor::NAME_STATUS = ValueAtom::intern("status");
+ValueAtom* CrossfireProcessor::NAME_TYPE = ValueAtom::intern("type");
+const char* CrossfireProcessor::VALUE_EVENT = "event";
+const char* CrossfireProcessor::VALUE_REQUEST = "request";
+const char* CrossfireProcessor::VALUE_RESPONSE = "response";
 
 CrossfireProcessor::CrossfireProcessor() {
+	m_cborParser = new CBORParser();
+	m_cborWriter = new CBORWriter();
+	m_encoding = ENCODING_JSON;
 	m_jsonParser = new JSONParser();
+	m_jsonWriter = new JSONWriter();
 	m_nextEventSeq = 0;
+	m_requestArguments = NULL;
+	m_requestArgumentsBuilder = new JSONValueBuilder();
+	m_requestCommand = NULL;
+	m_requestContextId = NULL;
+	m_stringTable = new StringTable();
+	m_writer = m_jsonWriter;
+	resetRequest();
 }
 
 CrossfireProcessor::~CrossfireProcessor() {
+	resetRequest();
+	delete m_cborParser;
+	delete m_cborWriter;
 	delete m_jsonParser;
+	delete m_jsonWriter;
+	delete m_requestArgumentsBuilder;
+	delete m_stringTable;
 }
 
-bool CrossfireProcessor::createEventPacket(CrossfireEvent* eventObj, std::wstring** _value) {
-	*_value = NULL;
-	Value value_packet;
+/*
+ * Begins the parsing of a request packet's content that is received in
+ * portions, each of which is passed to pushRequestContent() as it arrives.
+ * The request is answered by endRequestContent() once all portions are pushed.
+ */
+void CrossfireProcessor::beginRequestContent() {
+	resetRequest();
+	if (m_encoding == ENCODING_CBOR) {
+		m_cborParser->beginPush(this);
+	} else {
+		m_jsonParser->beginPush(this);
+	}
+}
 
-	/* packet type */
-	value_packet.addObjectValue(NAME_TYPE, &Value(VALUE_EVENT));
+/*
+ * The packet is written into a buffer that is reused for each packet, so the
+ * result is only valid until the next packet is created.
+ */
+bool CrossfireProcessor::createEventPacket(CrossfireEvent* eventObj, const char** _value, size_t* _length) {
+	*_value = NULL;
+	*_length = 0;
 
 	/* event type */
 	if (!eventObj->getName()) {
 		Logger::error("CrossfireProcessor.createEventPacket(): event does not have a name");
 		return false;
 	}
-	value_packet.addObjectValue(NAME_EVENT, &Value(eventObj->getName()));
 
-	/* context id */
+	/* body */
+	Value* bodyValue = eventObj->getBody();
+	if (bodyValue && bodyValue->getType() != TYPE_OBJECT) {
+		Logger::error("CrossfireProcessor.createEventPacket(): event has body object of wrong type");
+		return false;
+	}
+
+	m_writer->beginPacket();
+	m_writer->beginObject();
+	m_writer->writeKey(NAME_TYPE);
+	m_writer->writeString(VALUE_EVENT);
+	m_writer->writeKey(NAME_EVENT);
+	m_writer->writeString(eventObj->getName());
+	m_writer->writeKey(NAME_CONTEXTID);
 	if (eventObj->getContextId()) {
-		value_packet.addObjectValue(NAME_CONTEXTID, &Value(eventObj->getContextId()));
+		m_writer->writeString(eventObj->getContextId());
 	} else {
-		Value value_null;
-		value_null.setType(TYPE_NULL);
-		value_packet.addObjectValue(NAME_CONTEXTID, &value_null);
+		m_writer->writeNull();
 	}
-
-	/* body */
-	Value* bodyValue = eventObj->getBody();
 	if (bodyValue) {
-		if (bodyValue->getType() != TYPE_OBJECT) {
-			Logger::error("CrossfireProcessor.createEventPacket(): event has body object of wrong type");
-			return false;
-		}
-		value_packet.addObjectValue(NAME_BODY, bodyValue);
-	}
-
-	/* seq */
-	value_packet.setObjectValue(NAME_SEQ, &Value((double)m_nextEventSeq++));
-
-	std::wstring* content = NULL;
-	m_jsonParser->stringify(&value_packet, &content);
-	wchar_t length[9];
-	_ltow_s((unsigned int)content->length() + LINEBREAK_LENGTH, length, 9, 10); /* trailing linebreak */
-	std::wstring* eventString = new std::wstring;
-	eventString->append(HEADER_CONTENTLENGTH);
-	eventString->append(length);
-	eventString->append(LINEBREAK);
-	eventString->append(LINEBREAK);
-	eventString->append(*content);
-	eventString->append(LINEBREAK);
-	delete content;
-
-	*_value = eventString;
+		m_writer->writeKey(NAME_BODY);
+		m_writer->write(bodyValue);
+	}
+	m_writer->writeKey(NAME_SEQ);
+	m_writer->writeNumber((double)m_nextEventSeq++);
+	m_writer->endObject();
+	m_writer->endPacket();
+
+	*_value = m_writer->getContent();
+	*_length = m_writer->getLength();
 	return true;
 }
 
-bool CrossfireProcessor::createResponsePacket(CrossfireResponse *response, std::wstring **_value) {
+int CrossfireProcessor::createRequest(bool parsed, CrossfireRequest** _value, char** _message) {
+	int code = CODE_MALFORMED_REQUEST;
+	if (!parsed || m_requestArgumentsDepth) {
+		*_message = _strdup("Failure occurred while parsing Request packet content");
+		code = CODE_MALFORMED_PACKET;
+	} else if (!m_requestTypeMatched) {
+		*_message = _strdup("Request packet does not contain a 'type' value of \"request\"");
+	} else if (!(m_requestKeysSeen & REQUEST_KEY_SEQ) || (m_requestInvalidKeys & REQUEST_KEY_SEQ) || m_requestSeq < 0) {
+		*_message = _strdup("Request packet does not contain a 'seq' Number value >= 0");
+	} else if (!m_requestCommand) {
+		*_message = _strdup("Request packet does not contain a String 'command' value");
+	} else if (m_requestInvalidKeys & REQUEST_KEY_CONTEXTID) {
+		*_message = _strdup("Request packet contains a non-string 'context_id' value");
+	} else if (m_requestInvalidKeys & REQUEST_KEY_ARGUMENTS) {
+		*_message = _strdup("Request packet contains a non-object 'arguments' value");
+	} else {
+		CrossfireRequest* result = new CrossfireRequest();
+		result->setName(m_requestCommand->c_str());
+		result->setSeq((unsigned int)m_requestSeq);
+		if (m_requestContextId) {
+			result->setContextId(m_requestContextId);
+		}
+		if (!m_requestArguments) {
+			m_requestArguments = new Value();
+			m_requestArguments->setType(TYPE_OBJECT);
+		}
+		result->adoptArguments(m_requestArguments);
+		m_requestArguments = NULL;
+		*_value = result;
+		code = CODE_OK;
+	}
+
+	resetRequest();
+	return code;
+}
+
+/*
+ * The packet is written into a buffer that is reused for each packet, so the
+ * result is only valid until the next packet is created.
+ */
+bool CrossfireProcessor::createResponsePacket(CrossfireResponse* response, const char** _value, size_t* _length) {
 	static unsigned int s_nextResponseSeq = 0;
 	*_value = NULL;
-	Value value_packet;
+	*_length = 0;
 
-	/* packet type */
-	value_packet.addObjectValue(NAME_TYPE, &Value(VALUE_RESPONSE));
+	/*
+	 * The response to a packet that could not be parsed has no command or
+	 * request seq to answer with, so these are sent as null.
+	 */
+	bool malformed = response->getCode() == CODE_MALFORMED_PACKET;
 
 	/* command */
-	if (!response->getName()) {
+	if (!response->getName() && !malformed) {
 		Logger::error("CrossfireProcessor.createResponsePacket(): response does not have a name");
 		return false;
 	}
-	value_packet.addObjectValue(NAME_COMMAND, &Value(response->getName()));
-
-	/* contextId */
-	if (response->getContextId()) {
-		value_packet.addObjectValue(NAME_CONTEXTID, &Value(response->getContextId()));
-	} else {
-		Value value_null;
-		value_null.setType(TYPE_NULL);
-		value_packet.addObjectValue(NAME_CONTEXTID, &value_null);
-	}
 
 	/* request seq */
-	if (response->getRequestSeq() < 0) {
+	if (response->getRequestSeq() == -1 && !malformed) {
 		Logger::error("CrossfireProcessor.createResponsePacket(): response does not have a request seq value");
 		return false;
 	}
-	value_packet.addObjectValue(NAME_REQUESTSEQ, &Value((double)response->getRequestSeq()));
-
-	/* status */
-	Value status;
-	status.addObjectValue(NAME_CODE, &Value((double)response->getCode()));
-	status.addObjectValue(NAME_RUNNING, &Value(response->getRunning()));
-	wchar_t* message = response->getMessage();
-	if (message) {
-		status.addObjectValue(NAME_MESSAGE, &Value(message));
-	}
-	value_packet.addObjectValue(NAME_STATUS, &status);
 
 	/* body */
 	Value* bodyValue = response->getBody();
@@ -142,102 +186,321 @@ bool CrossfireProcessor::createResponsePacket(CrossfireResponse *response, std::
 		Logger::error("CrossfireProcessor.createResponsePacket(): response does not have a body value of type object");
 		return false;
 	}
-	value_packet.addObjectValue(NAME_BODY, bodyValue);
-
-	/* seq */
-	value_packet.setObjectValue(NAME_SEQ, &Value((double)s_nextResponseSeq++));
-	std::wstring* content = NULL;
-	m_jsonParser->stringify(&value_packet, &content);
-	wchar_t length[9];
-	_ltow_s((unsigned int)content->length() + LINEBREAK_LENGTH, length, 9, 10); /* trailing linebreak */
-	std::wstring* responseString = new std::wstring;
-	responseString->append(HEADER_CONTENTLENGTH);
-	responseString->append(length);
-	responseString->append(LINEBREAK);
-	responseString->append(LINEBREAK);
-	responseString->append(*content);
-	responseString->append(LINEBREAK);
-	delete content;
-
-	*_value = responseString;
+
+	m_writer->beginPacket();
+	m_writer->beginObject();
+	m_writer->writeKey(NAME_TYPE);
+	m_writer->writeString(VALUE_RESPONSE);
+	m_writer->writeKey(NAME_COMMAND);
+	if (response->getName()) {
+		m_writer->writeString(response->getName());
+	} else {
+		m_writer->writeNull();
+	}
+	m_writer->writeKey(NAME_CONTEXTID);
+	if (response->getContextId()) {
+		m_writer->writeString(response->getContextId());
+	} else {
+		m_writer->writeNull();
+	}
+	m_writer->writeKey(NAME_REQUESTSEQ);
+	if (response->getRequestSeq() != -1) {
+		m_writer->writeNumber((double)response->getRequestSeq());
+	} else {
+		m_writer->writeNull();
+	}
+
+	/* status */
+	m_writer->writeKey(NAME_STATUS);
+	m_writer->beginObject();
+	m_writer->writeKey(NAME_CODE);
+	m_writer->writeNumber((double)response->getCode());
+	m_writer->writeKey(NAME_RUNNING);
+	m_writer->writeBoolean(response->getRunning());
+	char* message = response->getMessage();
+	if (message) {
+		m_writer->writeKey(NAME_MESSAGE);
+		m_writer->writeString(message);
+	}
+	m_writer->endObject();
+
+	m_writer->writeKey(NAME_BODY);
+	m_writer->write(bodyValue);
+	m_writer->writeKey(NAME_SEQ);
+	m_writer->writeNumber((double)s_nextResponseSeq++);
+	m_writer->endObject();
+	m_writer->endPacket();
+
+	*_value = m_writer->getContent();
+	*_length = m_writer->getLength();
 	return true;
 }
 
-int CrossfireProcessor::parseRequestPacket(std::wstring* msg, CrossfireRequest** _value, wchar_t** _message) {
+int CrossfireProcessor::endRequestContent(CrossfireRequest** _value, char** _message) {
 	*_value = NULL;
 	*_message = NULL;
 
-	size_t startIndex = msg->find(L"\r\n\r\n") + 2 * LINEBREAK_LENGTH; /* header linebreak */
-	size_t msgLength = msg->length();
+	bool parsed = m_encoding == ENCODING_CBOR ? m_cborParser->endPush() : m_jsonParser->endPush();
+	return createRequest(parsed, _value, _message);
+}
 
-	if (msg->at(msgLength - 2) != wchar_t('\r')) {
-		*_message = _wcsdup(L"Request packet does not contain terminating '\\r'");
-		return CODE_MALFORMED_PACKET;
+/*
+ * The request's top-level values are recorded as they are parsed, with only its
+ * arguments object being passed on to a builder.  The content of any other nested
+ * object or array is ignored.
+ */
+bool CrossfireProcessor::onBoolean(bool value) {
+	if (m_requestArgumentsDepth) {
+		return m_requestArgumentsBuilder->onBoolean(value);
 	}
-	if (msg->at(msgLength - 1) != wchar_t('\n')) {
-		*_message = _wcsdup(L"Request packet does not contain terminating '\\n'");
-		return CODE_MALFORMED_PACKET;
+	return onRequestValue(TYPE_BOOLEAN, 0, NULL);
+}
+
+bool CrossfireProcessor::onEndArray() {
+	if (m_requestArgumentsDepth) {
+		m_requestArgumentsDepth--;
+		return m_requestArgumentsBuilder->onEndArray();
 	}
+	m_requestDepth--;
+	return true;
+}
 
-	std::wstring content = msg->substr(startIndex, msgLength - startIndex - LINEBREAK_LENGTH); /* trailing linebreak */
+bool CrossfireProcessor::onEndObject() {
+	if (m_requestArgumentsDepth) {
+		bool success = m_requestArgumentsBuilder->onEndObject();
+		if (--m_requestArgumentsDepth == 0) {
+			m_requestArgumentsBuilder->getValue(&m_requestArguments);
+		}
+		return success;
+	}
+	m_requestDepth--;
+	return true;
+}
 
-	Value* value_request = NULL;
-	m_jsonParser->parse(&content, &value_request);
-	if (!value_request) {
-		*_message = _wcsdup(L"Failure occurred while parsing Request packet content");
-		return CODE_MALFORMED_PACKET;
+bool CrossfireProcessor::onKey(std::string* key) {
+	if (m_requestArgumentsDepth) {
+		return m_requestArgumentsBuilder->onKey(key);
+	}
+	if (m_requestDepth != 1) {
+		return true;
 	}
 
-	Value* value_type = value_request->getObjectValue(NAME_TYPE);
-	if (!value_type || value_type->getType() != TYPE_STRING || value_type->getStringValue()->compare(VALUE_REQUEST) != 0) {
-		*_message = _wcsdup(L"Request packet does not contain a 'type' value of \"request\"");
-		delete value_request;
-		return CODE_MALFORMED_REQUEST;
+	m_requestKey = REQUEST_KEY_NONE;
+	ValueAtom* atom = ValueAtom::find(key->c_str(), key->length());
+	if (atom == NAME_ARGUMENTS) {
+		m_requestKey = REQUEST_KEY_ARGUMENTS;
+	} else if (atom == NAME_COMMAND) {
+		m_requestKey = REQUEST_KEY_COMMAND;
+	} else if (atom == NAME_CONTEXTID) {
+		m_requestKey = REQUEST_KEY_CONTEXTID;
+	} else if (atom == NAME_SEQ) {
+		m_requestKey = REQUEST_KEY_SEQ;
+	} else if (atom == NAME_TYPE) {
+		m_requestKey = REQUEST_KEY_TYPE;
 	}
+	if (m_requestKeysSeen & m_requestKey) {
+		Logger::error("JSON string has an object with a duplicate key");
+		return false;
+	}
+	m_requestKeysSeen |= m_requestKey;
+	return true;
+}
 
-	Value* value_seq = value_request->getObjectValue(NAME_SEQ);
-	if (!value_seq || value_seq->getType() != TYPE_NUMBER || value_seq->getNumberValue() < 0) {
-		*_message = _wcsdup(L"Request packet does not contain a 'seq' Number value >= 0");
-		delete value_request;
-		return CODE_MALFORMED_REQUEST;
+bool CrossfireProcessor::onNull() {
+	if (m_requestArgumentsDepth) {
+		return m_requestArgumentsBuilder->onNull();
 	}
+	return onRequestValue(TYPE_NULL, 0, NULL);
+}
+
+bool CrossfireProcessor::onNumber(double value) {
+	if (m_requestArgumentsDepth) {
+		return m_requestArgumentsBuilder->onNumber(value);
+	}
+	return onRequestValue(TYPE_NUMBER, value, NULL);
+}
 
-	Value* value_command = value_request->getObjectValue(NAME_COMMAND);
-	if (!value_command || value_command->getType() != TYPE_STRING) {
-		*_message = _wcsdup(L"Request packet does not contain a String 'command' value");
-		delete value_request;
-		return CODE_MALFORMED_REQUEST;
+bool CrossfireProcessor::onRequestValue(int type, double numberValue, std::string* stringValue) {
+	if (m_requestDepth != 1) {
+		return true;
 	}
 
-	Value* value_contextId = value_request->getObjectValue(NAME_CONTEXTID);
-	if (value_contextId && value_contextId->getType() != TYPE_STRING) {
-		*_message = _wcsdup(L"Request packet contains a non-string 'context_id' value");
-		delete value_request;
-		return CODE_MALFORMED_REQUEST;
+	bool valid = false;
+	switch (m_requestKey) {
+		case REQUEST_KEY_COMMAND: {
+			if (type == TYPE_STRING) {
+				m_requestCommand = new std::string(*stringValue);
+				valid = true;
+			}
+			break;
+		}
+		case REQUEST_KEY_CONTEXTID: {
+			if (type == TYPE_STRING) {
+				m_requestContextId = new std::string(*stringValue);
+				valid = true;
+			}
+			break;
+		}
+		case REQUEST_KEY_SEQ: {
+			if (type == TYPE_NUMBER) {
+				m_requestSeq = numberValue;
+				valid = true;
+			}
+			break;
+		}
+		case REQUEST_KEY_TYPE: {
+			m_requestTypeMatched = type == TYPE_STRING && stringValue->compare(VALUE_REQUEST) == 0;
+			valid = true;
+			break;
+		}
 	}
+	if (!valid) {
+		m_requestInvalidKeys |= m_requestKey;
+	}
+	return true;
+}
 
-	Value* value_arguments = value_request->getObjectValue(NAME_ARGUMENTS);
-	if (value_arguments && value_arguments->getType() != TYPE_OBJECT) {
-		*_message = _wcsdup(L"Request packet contains a non-object 'arguments' value");
-		delete value_request;
-		return CODE_MALFORMED_REQUEST;
+bool CrossfireProcessor::onStartArray() {
+	if (m_requestArgumentsDepth) {
+		m_requestArgumentsDepth++;
+		return m_requestArgumentsBuilder->onStartArray();
 	}
+	onRequestValue(TYPE_ARRAY, 0, NULL);
+	m_requestDepth++;
+	return true;
+}
 
-	CrossfireRequest* result = new CrossfireRequest();
-	result->setName((wchar_t*)value_command->getStringValue()->c_str());
-	result->setSeq((unsigned int)value_seq->getNumberValue());
-	if (value_contextId) {
-		result->setContextId(value_contextId->getStringValue());
+bool CrossfireProcessor::onStartObject() {
+	if (m_requestArgumentsDepth) {
+		m_requestArgumentsDepth++;
+		return m_requestArgumentsBuilder->onStartObject();
 	}
-	if (value_arguments) {
-		result->setArguments(value_arguments);
-	} else {
-		Value value_empty;
-		value_empty.setType(TYPE_OBJECT);
-		result->setArguments(&value_empty);
+	if (m_requestDepth == 1 && m_requestKey == REQUEST_KEY_ARGUMENTS) {
+		m_requestArgumentsDepth = 1;
+		return m_requestArgumentsBuilder->onStartObject();
+	}
+	onRequestValue(TYPE_OBJECT, 0, NULL);
+	m_requestDepth++;
+	return true;
+}
+
+bool CrossfireProcessor::onString(std::string* value) {
+	if (m_requestArgumentsDepth) {
+		return m_requestArgumentsBuilder->onString(value);
 	}
+	return onRequestValue(TYPE_STRING, 0, value);
+}
+
+/*
+ * Parses the content of a request packet that has been received in its
+ * entirety.  JSON content is parsed into a JSONDocument, from which only the
+ * request's top-level strings are decoded here, and its arguments Value refers
+ * to the document so that its contents are only created if the command
+ * accesses them.  CBOR content is compact enough to be reported to this
+ * processor's IJSONHandler methods as it is parsed instead.
+ */
+int CrossfireProcessor::parseRequestContent(const char* content, size_t length, CrossfireRequest** _value, char** _message) {
+	*_value = NULL;
+	*_message = NULL;
+
+	resetRequest();
+	if (m_encoding == ENCODING_CBOR) {
+		return createRequest(m_cborParser->parse(content, length, this), _value, _message);
+	}
+
+	JSONDocument* document = new JSONDocument();
+	bool parsed = m_jsonParser->parse(content, length, document);
+	if (parsed) {
+		readRequestDocument(document);
+	}
+	document->release();
+	return createRequest(parsed, _value, _message);
+}
+
+void CrossfireProcessor::readRequestDocument(JSONDocument* document) {
+	if (document->getType(JSONDocument::ROOT) != TYPE_OBJECT) {
+		return;
+	}
+
+	m_requestDepth = 1;
+	unsigned int count = document->getCount(JSONDocument::ROOT);
+	unsigned int index = JSONDocument::ROOT + 1;
+	for (unsigned int i = 0; i < count; i++) {
+		m_requestKey = REQUEST_KEY_NONE;
+		if (document->stringEquals(index, NAME_ARGUMENTS->getChars(), NAME_ARGUMENTS->getLength())) {
+			m_requestKey = REQUEST_KEY_ARGUMENTS;
+		} else if (document->stringEquals(index, NAME_COMMAND->getChars(), NAME_COMMAND->getLength())) {
+			m_requestKey = REQUEST_KEY_COMMAND;
+		} else if (document->stringEquals(index, NAME_CONTEXTID->getChars(), NAME_CONTEXTID->getLength())) {
+			m_requestKey = REQUEST_KEY_CONTEXTID;
+		} else if (document->stringEquals(index, NAME_SEQ->getChars(), NAME_SEQ->getLength())) {
+			m_requestKey = REQUEST_KEY_SEQ;
+		} else if (document->stringEquals(index, NAME_TYPE->getChars(), NAME_TYPE->getLength())) {
+			m_requestKey = REQUEST_KEY_TYPE;
+		}
+		m_requestKeysSeen |= m_requestKey;
+
+		index = document->getNext(index);
+		int type = document->getType(index);
+		if (m_requestKey == REQUEST_KEY_ARGUMENTS && type == TYPE_OBJECT) {
+			m_requestArguments = new Value(document, index);
+		} else if (m_requestKey != REQUEST_KEY_NONE && type == TYPE_STRING) {
+			std::string* stringValue = NULL;
+			document->getStringValue(index, &stringValue);
+			onRequestValue(type, 0, stringValue);
+			delete stringValue;
+		} else {
+			onRequestValue(type, document->getNumberValue(index), NULL);
+		}
+		index = document->getNext(index);
+	}
+}
+
+bool CrossfireProcessor::pushRequestContent(const char* content, size_t length) {
+	if (m_encoding == ENCODING_CBOR) {
+		return m_cborParser->push(content, length);
+	}
+	return m_jsonParser->push(content, length);
+}
+
+void CrossfireProcessor::resetRequest() {
+	if (m_requestArguments) {
+		delete m_requestArguments;
+		m_requestArguments = NULL;
+	}
+	m_requestArgumentsBuilder->clear();
+	m_requestArgumentsDepth = 0;
+	if (m_requestCommand) {
+		delete m_requestCommand;
+		m_requestCommand = NULL;
+	}
+	if (m_requestContextId) {
+		delete m_requestContextId;
+		m_requestContextId = NULL;
+	}
+	m_requestDepth = 0;
+	m_requestInvalidKeys = REQUEST_KEY_NONE;
+	m_requestKey = REQUEST_KEY_NONE;
+	m_requestKeysSeen = REQUEST_KEY_NONE;
+	m_requestSeq = 0;
+	m_requestTypeMatched = false;
+}
+
+/*
+ * Sets the encoding of the packets that are subsequently created and parsed.
+ */
+void CrossfireProcessor::setEncoding(int value) {
+	m_encoding = value;
+	m_writer = value == ENCODING_CBOR ? (PacketWriter*)m_cborWriter : (PacketWriter*)m_jsonWriter;
+}
 
-	*_value = result;
-	delete value_request;
-	return CODE_OK;
+/*
+ * Starts or stops sending URLs and context ids by id.  The table is cleared
+ * either way, since the ids that it has assigned are only known to the client
+ * that the preceding packets were sent to.
+ */
+void CrossfireProcessor::setUseStringTable(bool value) {
+	m_stringTable->clear();
+	m_cborWriter->setStringTable(value ? m_stringTable : NULL);
+	m_jsonWriter->setStringTable(value ? m_stringTable : NULL);
 }
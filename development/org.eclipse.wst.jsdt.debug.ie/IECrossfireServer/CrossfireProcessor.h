@@ -14,43 +14,113 @@
 
 #include <queue>
 
+#include "CBORParser.h"
+#include "CBORWriter.h"
 #include "CrossfireEvent.h"
 #include "CrossfireRequest.h"
 #include "CrossfireResponse.h"
+#include "IJSONHandler.h"
+#include "JSONDocument.h"
 #include "JSONParser.h"
+#include "JSONValueBuilder.h"
+#include "JSONWriter.h"
+#include "PacketWriter.h"
+#include "StringTable.h"
 #include "Value.h"
 #include "Logger.h"
 
-class CrossfireProcessor {
+enum {
+	ENCODING_JSON,
+	ENCODING_CBOR,
+};
+
+/*
+ * Creates outbound packets and parses inbound request packets.  A request's
+ * content is reported to the processor as it is parsed (or read from a parsed
+ * JSONDocument), so the request's fields are set directly and a Value is only
+ * created for its arguments.
+ *
+ * Packets are encoded as JSON unless the client negotiates CBOR in its
+ * handshake, in which case the same packet schema is written and read as CBOR.
+ * Similarly, the URLs and context ids in outbound packets are only sent by id
+ * once they have been sent if the client requests a StringTable.
+ */
+class CrossfireProcessor : public IJSONHandler {
 
 public:
 	CrossfireProcessor();
-	~CrossfireProcessor();
-	bool createEventPacket(CrossfireEvent* eventObj, std::wstring** _value);
-	bool createResponsePacket(CrossfireResponse* response, std::wstring** _value);
-	int parseRequestPacket(std::wstring* msg, CrossfireRequest** _value, wchar_t** _message);
+	virtual ~CrossfireProcessor();
+	void beginRequestContent();
+	bool createEventPacket(CrossfireEvent* eventObj, const char** _value, size_t* _length);
+	bool createResponsePacket(CrossfireResponse* response, const char** _value, size_t* _length);
+	int endRequestContent(CrossfireRequest** _value, char** _message);
+	int parseRequestContent(const char* content, size_t length, CrossfireRequest** _value, char** _message);
+	bool pushRequestContent(const char* content, size_t length);
+	void setEncoding(int value);
+	void setUseStringTable(bool value);
+
+	/* IJSONHandler */
+	virtual bool onBoolean(bool value);
+	virtual bool onEndArray();
+	virtual bool onEndObject();
+	virtual bool onKey(std::string* key);
+	virtual bool onNull();
+	virtual bool onNumber(double value);
+	virtual bool onStartArray();
+	virtual bool onStartObject();
+	virtual bool onString(std::string* value);
 
 private:
+	int createRequest(bool parsed, CrossfireRequest** _value, char** _message);
+	bool onRequestValue(int type, double numberValue, std::string* stringValue);
+	void readRequestDocument(JSONDocument* document);
+	void resetRequest();
+
+	CBORParser* m_cborParser;
+	CBORWriter* m_cborWriter;
+	int m_encoding;
 	JSONParser* m_jsonParser;
+	JSONWriter* m_jsonWriter;
 	unsigned int m_nextEventSeq;
+	StringTable* m_stringTable;
+	PacketWriter* m_writer;
+
+	/* request parse state */
+	Value* m_requestArguments;
+	JSONValueBuilder* m_requestArgumentsBuilder;
+	int m_requestArgumentsDepth;
+	std::string* m_requestCommand;
+	std::string* m_requestContextId;
+	int m_requestDepth;
+	int m_requestInvalidKeys;
+	int m_requestKey;
+	int m_requestKeysSeen;
+	double m_requestSeq;
+	bool m_requestTypeMatched;
+
+	enum {
+		REQUEST_KEY_NONE = 0x0,
+		REQUEST_KEY_ARGUMENTS = 0x1,
+		REQUEST_KEY_COMMAND = 0x2,
+		REQUEST_KEY_CONTEXTID = 0x4,
+		REQUEST_KEY_SEQ = 0x8,
+		REQUEST_KEY_TYPE = 0x10,
+	};
 
 	/* constants */
-	static const wchar_t* HEADER_CONTENTLENGTH;
-	static const wchar_t* LINEBREAK;
-	static const size_t LINEBREAK_LENGTH;
-	static const wchar_t* NAME_ARGUMENTS;
-	static const wchar_t* NAME_BODY;
-	static const wchar_t* NAME_CODE;
-	static const wchar_t* NAME_COMMAND;
-	static const wchar_t* NAME_CONTEXTID;
-	static const wchar_t* NAME_EVENT;
-	static const wchar_t* NAME_MESSAGE;
-	static const wchar_t* NAME_REQUESTSEQ;
-	static const wchar_t* NAME_RUNNING;
-	static const wchar_t* NAME_SEQ;
-	static const wchar_t* NAME_STATUS;
-	static const wchar_t* NAME_TYPE;
-	static const wchar_t* VALUE_EVENT;
-	static const wchar_t* VALUE_REQUEST;
-	static const wchar_t* VALUE_RESPONSE;
+	static ValueAtom* NAME_ARGUMENTS;
+	static ValueAtom* NAME_BODY;
+	static ValueAtom* NAME_CODE;
+	static ValueAtom* NAME_COMMAND;
+	static ValueAtom* NAME_CONTEXTID;
+	static ValueAtom* NAME_EVENT;
+	static ValueAtom* NAME_MESSAGE;
+	static ValueAtom* NAME_REQUESTSEQ;
+	static ValueAtom* NAME_RUNNING;
+	static ValueAtom* NAME_SEQ;
+	static ValueAtom* NAME_STATUS;
+	static ValueAtom* NAME_TYPE;
+	static const char* VALUE_EVENT;
+	static const char* VALUE_REQUEST;
+	static const char* VALUE_RESPONSE;
 };
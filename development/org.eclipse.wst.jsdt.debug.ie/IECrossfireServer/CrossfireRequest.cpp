@@ -23,6 +23,22 @@ CrossfireRequest::~CrossfireRequest() {
 	}
 }
 
+/*
+ * Sets the request's arguments to the given value without copying it, so the
+ * request becomes responsible for deleting it, even if it is rejected for not being an object.
+ */
+bool CrossfireRequest::adoptArguments(Value* value) {
+	if (value && value->getType() != TYPE_OBJECT) {
+		delete value;
+		return false;
+	}
+	if (m_arguments) {
+		delete m_arguments;
+	}
+	m_arguments = value;
+	return true;
+}
+
 void CrossfireRequest::clone(CrossfirePacket** _value) {
 	CrossfireRequest* result = new CrossfireRequest();
 	result->setArguments(m_arguments);
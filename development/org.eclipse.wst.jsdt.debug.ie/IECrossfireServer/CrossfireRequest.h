@@ -20,6 +20,7 @@ class CrossfireRequest : public CrossfirePacket {
 public:
 	CrossfireRequest();
 	virtual ~CrossfireRequest();
+	bool adoptArguments(Value* value);
 	void clone(CrossfirePacket** _value);
 	Value* getArguments();
 	int getType();
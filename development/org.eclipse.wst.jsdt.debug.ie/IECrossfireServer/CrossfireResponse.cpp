@@ -30,6 +30,22 @@ CrossfireResponse::~CrossfireResponse() {
 	}
 }
 
+/*
+ * Sets the response's body to the given value without copying it, so the response
+ * becomes responsible for deleting it, even if it is rejected for not being an object.
+ */
+bool CrossfireResponse::adoptBody(Value* value) {
+	if (value && value->getType() != TYPE_OBJECT) {
+		delete value;
+		return false;
+	}
+	if (m_body) {
+		delete m_body;
+	}
+	m_body = value;
+	return true;
+}
+
 void CrossfireResponse::clone(CrossfirePacket** _value) {
 	CrossfireResponse* result = new CrossfireResponse();
 	result->setBody(m_body);
@@ -49,7 +65,7 @@ int CrossfireResponse::getCode() {
 	return m_code;
 }
 
-wchar_t* CrossfireResponse::getMessage() {
+char* CrossfireResponse::getMessage() {
 	return m_message;
 }
 
@@ -83,13 +99,13 @@ void CrossfireResponse::setCode(int value) {
 	m_code = value;
 }
 
-void CrossfireResponse::setMessage(wchar_t* value) {
+void CrossfireResponse::setMessage(char* value) {
 	if (m_message) {
 		free(m_message);
 		m_message = NULL;
 	}
 	if (value) {
-		m_message = _wcsdup(value);
+		m_message = _strdup(value);
 	}
 }
 
@@ -31,23 +31,24 @@ class CrossfireResponse : public CrossfirePacket {
 public:
 	CrossfireResponse();
 	virtual ~CrossfireResponse();
+	bool adoptBody(Value* value);
 	void clone(CrossfirePacket** _value);
 	Value* getBody();
 	int getCode();
-	wchar_t* getMessage();
+	char* getMessage();
 	unsigned int getRequestSeq();
 	bool getRunning();
 	int getType();
 	bool setBody(Value* value);
 	void setCode(int code);
-	void setMessage(wchar_t* value);
+	void setMessage(char* value);
 	void setRequestSeq(unsigned int value);
 	void setRunning(bool value);
 
 private:
 	Value* m_body;
 	int m_code;
-	wchar_t* m_message;
+	char* m_message;
 	unsigned int m_requestSeq;
 	bool m_running;
 };
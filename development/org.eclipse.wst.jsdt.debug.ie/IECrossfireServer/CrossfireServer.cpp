@@ -15,78 +15,86 @@
 
 /* initialize constants */
 const wchar_t* CrossfireServer::ABOUT_BLANK = L"about:blank";
+const UINT CrossfireServer::DispatchRequestsMsg = WM_APP + 1;
 const UINT CrossfireServer::ServerStateChangeMsg = RegisterWindowMessage(L"IECrossfireServerStateChanged");
 const wchar_t* CrossfireServer::WindowClass = L"_IECrossfireServer";
 
-const wchar_t* CrossfireServer::HANDSHAKE = L"CrossfireHandshake\r\n";
-const wchar_t* CrossfireServer::HEADER_CONTENTLENGTH = L"Content-Length:";
-const wchar_t* CrossfireServer::LINEBREAK = L"\r\n";
-const size_t CrossfireServer::LINEBREAK_LENGTH = 2;
+const char* CrossfireServer::HANDSHAKE = "CrossfireHandshake\r\n";
+const char* CrossfireServer::HANDSHAKE_ENCODING_CBOR = "encoding=cbor";
+const char* CrossfireServer::HANDSHAKE_STRING_TABLE = "strings=table";
+const char* CrossfireServer::LINEBREAK = "\r\n";
+const wchar_t* CrossfireServer::PREFERENCE_EVENTBATCHWINDOW = L"EventBatchWindow";
+const wchar_t* CrossfireServer::PREFERENCES_KEY = L"Software\\IBM\\IECrossfireServer";
 
-const wchar_t* CrossfireServer::COMMAND_CHANGEBREAKPOINTS = L"changeBreakpoints";
-const wchar_t* CrossfireServer::COMMAND_DELETEBREAKPOINTS = L"deleteBreakpoints";
-const wchar_t* CrossfireServer::COMMAND_GETBREAKPOINTS = L"getBreakpoints";
-const wchar_t* CrossfireServer::COMMAND_SETBREAKPOINTS = L"setBreakpoints";
+const char* CrossfireServer::COMMAND_CHANGEBREAKPOINTS = "changeBreakpoints";
+const char* CrossfireServer::COMMAND_DELETEBREAKPOINTS = "deleteBreakpoints";
+const char* CrossfireServer::COMMAND_GETBREAKPOINTS = "getBreakpoints";
+const char* CrossfireServer::COMMAND_SETBREAKPOINTS = "setBreakpoints";
 
 /* command: createContext */
-const wchar_t* CrossfireServer::COMMAND_CREATECONTEXT = L"createContext";
+const char* CrossfireServer::COMMAND_CREATECONTEXT = "createContext";
 
 /* command: disableTools */
-const wchar_t* CrossfireServer::COMMAND_DISABLETOOLS = L"disableTools";
+const char* CrossfireServer::COMMAND_DISABLETOOLS = "disableTools";
 
 /* command: enableTools */
-const wchar_t* CrossfireServer::COMMAND_ENABLETOOLS = L"enableTools";
+const char* CrossfireServer::COMMAND_ENABLETOOLS = "enableTools";
 
 /* command: getTools */
-const wchar_t* CrossfireServer::COMMAND_GETTOOLS = L"getTools";
+const char* CrossfireServer::COMMAND_GETTOOLS = "getTools";
 
 /* command: listContexts */
-const wchar_t* CrossfireServer::COMMAND_LISTCONTEXTS = L"listContexts";
-const wchar_t* CrossfireServer::KEY_CONTEXTS = L"contexts";
-const wchar_t* CrossfireServer::KEY_CURRENT = L"current";
+const char* CrossfireServer::COMMAND_LISTCONTEXTS = "listContexts";
+ValueAtom* CrossfireServer::KEY_CONTEXTS = ValueAtom::intern("contexts");
+ValueAtom* CrossfireServer::KEY_CURRENT = ValueAtom::intern("current");
 
 /* command: version */
-const wchar_t* CrossfireServer::COMMAND_VERSION = L"version";
-const wchar_t* CrossfireServer::KEY_VERSION = L"version";
-const wchar_t* CrossfireServer::VERSION_STRING = L"0.3a10";
+const char* CrossfireServer::COMMAND_VERSION = "version";
+ValueAtom* CrossfireServer::KEY_VERSION = ValueAtom::intern("version");
+const char* CrossfireServer::VERSION_STRING = "0.3a10";
 
 /* event: closed */
-const wchar_t* CrossfireServer::EVENT_CLOSED = L"closed";
+const char* CrossfireServer::EVENT_CLOSED = "closed";
 
 /* event: onContextCreated */
-const wchar_t* CrossfireServer::EVENT_CONTEXTCREATED = L"onContextCreated";
+const char* CrossfireServer::EVENT_CONTEXTCREATED = "onContextCreated";
 
 /* event: onContextDestroyed */
-const wchar_t* CrossfireServer::EVENT_CONTEXTDESTROYED = L"onContextDestroyed";
+const char* CrossfireServer::EVENT_CONTEXTDESTROYED = "onContextDestroyed";
 
 /* event: onContextLoaded */
-const wchar_t* CrossfireServer::EVENT_CONTEXTLOADED = L"onContextLoaded";
+const char* CrossfireServer::EVENT_CONTEXTLOADED = "onContextLoaded";
 
 /* event: onContextSelected */
-const wchar_t* CrossfireServer::EVENT_CONTEXTSELECTED = L"onContextSelected";
-const wchar_t* CrossfireServer::KEY_OLDCONTEXTID = L"oldContextId";
-const wchar_t* CrossfireServer::KEY_OLDURL = L"oldUrl";
+const char* CrossfireServer::EVENT_CONTEXTSELECTED = "onContextSelected";
+ValueAtom* CrossfireServer::KEY_OLDCONTEXTID = ValueAtom::intern("oldContextId");
+ValueAtom* CrossfireServer::KEY_OLDURL = ValueAtom::intern("oldUrl");
 
 /* shared */
-const wchar_t* CrossfireServer::KEY_CONTEXTID = L"contextId";
-const wchar_t* CrossfireServer::KEY_TOOLS = L"tools";
-const wchar_t* CrossfireServer::KEY_URL = L"url";
+ValueAtom* CrossfireServer::KEY_CONTEXTID = ValueAtom::intern("contextId");
+ValueAtom* CrossfireServer::KEY_TOOLS = ValueAtom::intern("tools");
+ValueAtom* CrossfireServer::KEY_URL = ValueAtom::intern("url");
 
 
 CrossfireServer::CrossfireServer() {
+	m_activeContexts = new std::set<std::string>;
+	m_activeRequests = 0;
 	m_bpManager = new CrossfireBPManager();
 	m_connection = NULL;
 	m_connectionWarningShown = false;
 	m_contexts = new std::map<DWORD, CrossfireContext*>;
 	m_currentContextPID = 0;
+	m_dispatchScheduled = false;
+	m_exclusiveRequestActive = false;
+	m_frameDecoder = new CrossfireFrameDecoder();
 	m_handshakeReceived = false;
-	m_inProgressPacket = new std::wstring;
 	m_lastRequestSeq = -1;
 	m_browsers = new std::map<DWORD, IBrowserContext*>;
 	m_pendingEvents = new std::vector<CrossfireEvent*>;
 	m_port = -1;
-	m_processingRequest = false;
 	m_processor = new CrossfireProcessor();
+	m_requestQueue = new std::deque<CrossfirePacket*>;
+	m_resetPending = false;
 	m_windowHandle = 0;
 
 	/* create a message-only window to help clients detect the server's presence */
@@ -104,6 +112,9 @@ CrossfireServer::CrossfireServer() {
 	ex.lpszClassName = WindowClass;
 	RegisterClass(&ex);
 	m_messageWindow = CreateWindow(WindowClass, NULL, 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, module, NULL);
+	if (m_messageWindow) {
+		SetWindowLongPtr(m_messageWindow, GWLP_USERDATA, (LONG_PTR)this);
+	}
 }
 
 CrossfireServer::~CrossfireServer() {
@@ -132,8 +143,19 @@ CrossfireServer::~CrossfireServer() {
 		iterator3++;
 	}
 	delete m_pendingEvents;
+	if (m_connection) {
+		m_connection->flush();
+	}
 
-	delete m_inProgressPacket;
+	std::deque<CrossfirePacket*>::iterator iterator4 = m_requestQueue->begin();
+	while (iterator4 != m_requestQueue->end()) {
+		delete *iterator4;
+		iterator4++;
+	}
+	delete m_requestQueue;
+	delete m_activeContexts;
+
+	delete m_frameDecoder;
 	delete m_processor;
 	if (m_connection) {
 		delete m_connection;
@@ -325,12 +347,18 @@ HRESULT STDMETHODCALLTYPE CrossfireServer::start(unsigned int port, unsigned int
 	if (m_connection) {
 		return S_FALSE;
 	}
+	if (m_resetPending) {
+		/* the contexts of the last connection are still in use by its requests */
+		Logger::error("CrossfireServer.start(): the last connection's requests are still in progress");
+		return S_FALSE;
+	}
 
 	m_connection = new WindowsSocketConnection(this);
 	if (!m_connection->init(port)) {
 		delete m_connection;
 		return S_FALSE;
 	}
+	m_connection->setBatchWindow(getEventBatchWindow());
 	m_port = port;
 	if (m_connection->acceptConnection()) {
 		HWND current = FindWindowEx(HWND_MESSAGE, NULL, NULL, NULL);
@@ -373,6 +401,7 @@ void CrossfireServer::connected() {
 
 void CrossfireServer::disconnected() {
 	reset();
+	ValuePool::release();
 	HWND current = FindWindowEx(HWND_MESSAGE, NULL, NULL, NULL);
 	while (current) {
 		PostMessage(current, ServerStateChangeMsg, STATE_DISCONNECTED, 0);
@@ -380,14 +409,79 @@ void CrossfireServer::disconnected() {
 	}
 }
 
+/*
+ * Performs the queued requests that are not waiting on others.  Performing a
+ * request can call into the browser, and while the server waits on such a
+ * call it continues to receive messages, including the DispatchRequestsMsg
+ * that follows newly received requests.  Requests for other contexts can
+ * therefore be performed while a request waits, and each response is sent as
+ * soon as its request completes, tagged with the request's seq.
+ *
+ * These nested dispatches share the one stack, so a waiting request cannot
+ * resume until the requests started during its wait have completed.  Requests
+ * therefore complete in last-in first-out order, and a quick request waits
+ * for any slower one that was started during its own wait.
+ */
+void CrossfireServer::dispatchRequests() {
+	CrossfirePacket* packet = NULL;
+	while (findNextRequest(&packet)) {
+		if (packet->getType() == CrossfirePacket::TYPE_RESPONSE) {
+			sendResponse((CrossfireResponse*)packet);
+			delete packet;
+		} else {
+			runRequest((CrossfireRequest*)packet);
+		}
+	}
+}
+
+/*
+ * Removes and answers the first queued request that can be performed now.
+ * The protocol only requires requests to be ordered where they can affect
+ * one another, so:
+ *  - a request for a context waits for the earlier requests for that context
+ *  - a request for the server, such as setBreakpoints or createContext, can
+ *    affect every context, so it waits for all earlier requests and later
+ *    requests wait for it
+ *  - the response to a packet that could not be parsed has no requestSeq for
+ *    the client to match it by, so it is sent in order in the same way
+ */
+bool CrossfireServer::findNextRequest(CrossfirePacket** _value) {
+	*_value = NULL;
+	if (m_exclusiveRequestActive) {
+		return false;
+	}
+
+	std::set<std::string> waitingContexts;
+	std::deque<CrossfirePacket*>::iterator iterator = m_requestQueue->begin();
+	while (iterator != m_requestQueue->end()) {
+		CrossfirePacket* packet = *iterator;
+		std::string* contextId = packet->getContextId();
+		if (packet->getType() == CrossfirePacket::TYPE_RESPONSE || !contextId || isServerCommand(packet->getName())) {
+			if (iterator != m_requestQueue->begin() || m_activeRequests) {
+				return false;
+			}
+		} else {
+			if (m_activeContexts->find(*contextId) != m_activeContexts->end() || waitingContexts.find(*contextId) != waitingContexts.end()) {
+				waitingContexts.insert(*contextId);
+				iterator++;
+				continue;
+			}
+		}
+		m_requestQueue->erase(iterator);
+		*_value = packet;
+		return true;
+	}
+	return false;
+}
+
 CrossfireBPManager* CrossfireServer::getBreakpointManager() {
 	return m_bpManager;
 }
 
-CrossfireContext* CrossfireServer::getContext(wchar_t* contextId) {
+CrossfireContext* CrossfireServer::getContext(char* contextId) {
 	std::map<DWORD,CrossfireContext*>::iterator iterator = m_contexts->begin();
 	while (iterator != m_contexts->end()) {
-		if (wcscmp(iterator->second->getName(), contextId) == 0) {
+		if (strcmp(iterator->second->getName(), contextId) == 0) {
 			return iterator->second;
 		}
 		iterator++;
@@ -407,13 +501,40 @@ void CrossfireServer::getContextsArray(CrossfireContext*** _value) {
 	*_value = result;
 }
 
+/*
+ * Answers the number of milliseconds that events are held for so that they can
+ * be sent together, which can be set with the EventBatchWindow registry value.
+ */
+unsigned int CrossfireServer::getEventBatchWindow() {
+	unsigned int result = DEFAULT_EVENT_BATCH_WINDOW;
+	HKEY key;
+	LONG rc = RegOpenKeyEx(HKEY_CURRENT_USER, PREFERENCES_KEY, 0, KEY_QUERY_VALUE, &key);
+	if (rc != ERROR_SUCCESS) {
+		if (rc != ERROR_FILE_NOT_FOUND) {
+			Logger::error("CrossfireServer.getEventBatchWindow(): RegOpenKeyEx() failed", rc);
+		}
+		return result;
+	}
+
+	DWORD value = 0;
+	DWORD size = sizeof(DWORD);
+	rc = RegQueryValueEx(key, PREFERENCE_EVENTBATCHWINDOW, NULL, NULL, (LPBYTE)&value, &size);
+	if (rc == ERROR_SUCCESS) {
+		result = value < MAX_EVENT_BATCH_WINDOW ? value : MAX_EVENT_BATCH_WINDOW;
+	} else if (rc != ERROR_FILE_NOT_FOUND) {
+		Logger::error("CrossfireServer.getEventBatchWindow(): RegQueryValueEx() failed", rc);
+	}
+	RegCloseKey(key);
+	return result;
+}
+
 CrossfireContext* CrossfireServer::getRequestContext(CrossfireRequest* request) {
-	std::wstring* contextId = request->getContextId();
+	std::string* contextId = request->getContextId();
 	if (!contextId) {
 		return NULL;
 	}
 
-	wchar_t* searchString = (wchar_t*)contextId->c_str();
+	char* searchString = (char*)contextId->c_str();
 	return getContext(searchString);
 }
 
@@ -423,26 +544,47 @@ bool CrossfireServer::isConnected() {
 	return state == STATE_CONNECTED;
 }
 
+bool CrossfireServer::isServerCommand(const char* command) {
+	const char* commands[] = {
+		COMMAND_CHANGEBREAKPOINTS,
+		COMMAND_CREATECONTEXT,
+		COMMAND_DELETEBREAKPOINTS,
+		COMMAND_DISABLETOOLS,
+		COMMAND_ENABLETOOLS,
+		COMMAND_GETBREAKPOINTS,
+		COMMAND_GETTOOLS,
+		COMMAND_LISTCONTEXTS,
+		COMMAND_SETBREAKPOINTS,
+		COMMAND_VERSION,
+	};
+	for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+		if (strcmp(command, commands[i]) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
 bool CrossfireServer::performRequest(CrossfireRequest* request) {
-	wchar_t* command = request->getName();
+	char* command = request->getName();
 	Value* arguments = request->getArguments();
 	Value* responseBody = NULL;
-	wchar_t* message = NULL;
+	char* message = NULL;
 	int code = CODE_OK;
 
-	if (wcscmp(command, COMMAND_CREATECONTEXT) == 0) {
+	if (strcmp(command, COMMAND_CREATECONTEXT) == 0) {
 		code = commandCreateContext(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_DISABLETOOLS) == 0) {
+	} else if (strcmp(command, COMMAND_DISABLETOOLS) == 0) {
 		code = commandDisableTools(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_ENABLETOOLS) == 0) {
+	} else if (strcmp(command, COMMAND_ENABLETOOLS) == 0) {
 		code = commandEnableTools(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_GETTOOLS) == 0) {
+	} else if (strcmp(command, COMMAND_GETTOOLS) == 0) {
 		code = commandGetTools(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_LISTCONTEXTS) == 0) {
+	} else if (strcmp(command, COMMAND_LISTCONTEXTS) == 0) {
 		code = commandListContexts(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_VERSION) == 0) {
+	} else if (strcmp(command, COMMAND_VERSION) == 0) {
 		code = commandVersion(arguments, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_CHANGEBREAKPOINTS) == 0) {
+	} else if (strcmp(command, COMMAND_CHANGEBREAKPOINTS) == 0) {
 		CrossfireContext* context = getRequestContext(request);
 		CrossfireContext** contexts = NULL;
 		if (context) {
@@ -452,7 +594,7 @@ bool CrossfireServer::performRequest(CrossfireRequest* request) {
 		if (contexts) {
 			delete contexts;
 		}
-	} else if (wcscmp(command, COMMAND_DELETEBREAKPOINTS) == 0) {
+	} else if (strcmp(command, COMMAND_DELETEBREAKPOINTS) == 0) {
 		CrossfireContext* context = getRequestContext(request);
 		CrossfireContext** contexts = NULL;
 		if (context) {
@@ -462,11 +604,11 @@ bool CrossfireServer::performRequest(CrossfireRequest* request) {
 		if (contexts) {
 			delete contexts;
 		}
-	} else if (wcscmp(command, COMMAND_GETBREAKPOINTS) == 0) {
+	} else if (strcmp(command, COMMAND_GETBREAKPOINTS) == 0) {
 		CrossfireContext* context = getRequestContext(request);
 		IBreakpointTarget* target = context ? (IBreakpointTarget*)context : (IBreakpointTarget*)m_bpManager;
 		code = m_bpManager->commandGetBreakpoints(arguments, target, &responseBody, &message);
-	} else if (wcscmp(command, COMMAND_SETBREAKPOINTS) == 0) {
+	} else if (strcmp(command, COMMAND_SETBREAKPOINTS) == 0) {
 		CrossfireContext* context = getRequestContext(request);
 		CrossfireContext** contexts = NULL;
 		if (context) {
@@ -489,40 +631,66 @@ bool CrossfireServer::performRequest(CrossfireRequest* request) {
 	if (message) {
 		free(message);
 	}
-	if (code == CODE_OK) {
-		response.setBody(responseBody);
-	} else {
-		Value emptyBody;
-		emptyBody.setType(TYPE_OBJECT);
-		response.setBody(&emptyBody);
-	}
-	if (responseBody) {
-		delete responseBody;
+	if (code != CODE_OK) {
+		if (responseBody) {
+			delete responseBody;
+		}
+		responseBody = new Value();
+		responseBody->setType(TYPE_OBJECT);
 	}
+	response.adoptBody(responseBody);
 	sendResponse(&response);
 	return true;
 }
 
-bool CrossfireServer::processHandshake(wchar_t* msg) {
-	std::wstring string(msg);
-	size_t start = wcslen(HANDSHAKE);
-	size_t index = string.find_first_of(std::wstring(L"\r\n"), start);
-	if (index == std::wstring::npos) {
-		Logger::error("Invalid handshake packet, does not contain terminating '\\r\\n'");
-		return false;
-	}
-	if (index != string.length() - 2) {
-		Logger::error("Invalid handshake packet, length extends beyond terminating '\\r\\n'");
-		return false;
-	}
-
-	std::wstring tools = string.substr(start, index - start);
+bool CrossfireServer::processHandshake(const char* chars, size_t length) {
+	std::string tools(chars, length);
 	m_handshakeReceived = true;
 
-	std::wstring handshake(HANDSHAKE);
-	/* for now don't claim support for any tools */
-	handshake.append(std::wstring(L"\r\n"));
-	m_connection->send(handshake.c_str());
+	/*
+	 * A client can request that packets be encoded as CBOR rather than JSON by
+	 * including HANDSHAKE_ENCODING_CBOR in its comma-separated list of tools,
+	 * and that URLs and context ids be sent by id by including
+	 * HANDSHAKE_STRING_TABLE.  The server accepts these by including them in
+	 * the handshake that it sends back, and they then apply to all packets
+	 * that follow.
+	 */
+	int encoding = ENCODING_JSON;
+	bool useStringTable = false;
+	size_t toolStart = 0;
+	while (toolStart <= tools.length()) {
+		size_t toolEnd = tools.find(',', toolStart);
+		if (toolEnd == std::string::npos) {
+			toolEnd = tools.length();
+		}
+		std::string tool = tools.substr(toolStart, toolEnd - toolStart);
+		size_t nameStart = tool.find_first_not_of(' ');
+		if (nameStart != std::string::npos) {
+			tool = tool.substr(nameStart, tool.find_last_not_of(' ') + 1 - nameStart);
+			if (tool.compare(HANDSHAKE_ENCODING_CBOR) == 0) {
+				encoding = ENCODING_CBOR;
+			} else if (tool.compare(HANDSHAKE_STRING_TABLE) == 0) {
+				useStringTable = true;
+			}
+		}
+		toolStart = toolEnd + 1;
+	}
+	m_processor->setEncoding(encoding);
+	m_processor->setUseStringTable(useStringTable);
+
+	std::string handshake(HANDSHAKE);
+	/* for now don't claim support for any tools, only acknowledge the protocol extensions */
+	if (encoding == ENCODING_CBOR) {
+		handshake.append(HANDSHAKE_ENCODING_CBOR);
+	}
+	if (useStringTable) {
+		if (encoding == ENCODING_CBOR) {
+			handshake.append(",");
+		}
+		handshake.append(HANDSHAKE_STRING_TABLE);
+	}
+	handshake.append(LINEBREAK);
+	m_connection->send(handshake.c_str(), handshake.length());
 
 	/*
 	* Some events may have been queued in the interval between the initial connection
@@ -534,8 +702,7 @@ bool CrossfireServer::processHandshake(wchar_t* msg) {
 }
 
 void CrossfireServer::sendPendingEvents() {
-	if (m_pendingEvents->size() > 0) {
-		Sleep(500); // TODO HACK!
+	if (m_pendingEvents->size() > 0 && m_handshakeReceived) {
 		std::vector<CrossfireEvent*>::iterator iterator = m_pendingEvents->begin();
 		while (iterator != m_pendingEvents->end()) {
 			sendEvent(*iterator);
@@ -543,132 +710,120 @@ void CrossfireServer::sendPendingEvents() {
 			iterator++;
 		}
 		m_pendingEvents->clear();
+
+		/* the backlog has been queued as a single batch, so it does not need to wait for the batch window */
+		m_connection->flush();
 	}
 }
 
-void CrossfireServer::received(wchar_t* msg) {
-	if (!m_handshakeReceived) {
-		if (wcsncmp(msg, HANDSHAKE, wcslen(HANDSHAKE)) == 0) {
-			processHandshake(msg);
-			m_lastRequestSeq = -1;
-		} else {
-			Logger::error("Crossfire content received before handshake, not processing it");
+/*
+ * Queues a request that has been received to be performed once the received
+ * data has been handled, or if it could not be parsed then queues a response
+ * that informs the client of this.  The error message is freed by this method.
+ */
+void CrossfireServer::processRequest(CrossfireRequest* request, int code, char* parseErrorMessage) {
+	if (code != CODE_OK) {
+		CrossfireResponse* response = new CrossfireResponse();
+		response->setCode(CODE_MALFORMED_PACKET);
+		response->setMessage(parseErrorMessage);
+		free(parseErrorMessage);
+		Value* emptyBody = new Value();
+		emptyBody->setType(TYPE_OBJECT);
+		response->adoptBody(emptyBody);
+		m_requestQueue->push_back(response);
+	} else {
+		/*
+		 * Responses are matched to requests by their requestSeq, so a request that
+		 * is received out of sequence can still be performed.
+		 */
+		unsigned int seq = request->getSeq();
+		if (!(m_lastRequestSeq == -1 || seq == m_lastRequestSeq + 1)) {
+			Logger::log("packet received out of sequence, still processing it");
 		}
-		return;
+		m_lastRequestSeq = seq;
+		m_requestQueue->push_back(request);
 	}
 
-	m_inProgressPacket->append(std::wstring(msg));
-	std::wstring packet;
-	do {
-		wchar_t* parseErrorMessage = NULL;
-		bool errorMessageRequiresFree = false;
-		int code = CODE_OK;
-		packet.clear();
-
-		if (m_inProgressPacket->find(HEADER_CONTENTLENGTH) != 0) {
-			code = CODE_MALFORMED_PACKET;
-			parseErrorMessage = L"request packet does not start with 'Content-Length:', not processing it";
-			m_inProgressPacket->clear();
-			break;
-		}
-
-		size_t endIndex = m_inProgressPacket->find(wchar_t('\r'));
-		if (endIndex == std::wstring::npos) {
-			code = CODE_MALFORMED_PACKET;
-			parseErrorMessage = L"request packet does not contain '\r', not processing it";
-			m_inProgressPacket->clear();
-			break;
-		}
-
-		size_t headerLength = wcslen(HEADER_CONTENTLENGTH);
-		std::wstring lengthString = m_inProgressPacket->substr(headerLength, endIndex - headerLength);
-		int lengthValue = _wtoi(lengthString.c_str());
-		if (!lengthValue) {
-			code = CODE_MALFORMED_PACKET;
-			parseErrorMessage = L"request packet does not have a valid 'Content-Length' value, not processing it";
-			m_inProgressPacket->clear();
-			break;
-		}
-
-		if (m_inProgressPacket->find(L"\r\n", endIndex) != endIndex) {
-			code = CODE_MALFORMED_PACKET;
-			parseErrorMessage = L"request packet does not follow initial '\\r' with '\\n', not processing it";
-			m_inProgressPacket->clear();
-			break;
-		}
-
-		// TODO for now just skip over "tool:" lines, though these should really be validated
-
-		size_t toolEnd = m_inProgressPacket->find(L"\r\n\r\n", endIndex);
-		if (toolEnd == std::wstring::npos) {
-			code = CODE_MALFORMED_PACKET;
-			parseErrorMessage = L"request packet does not contain '\\r\\n\\r\\n' to delimit its header, not processing it";
-			m_inProgressPacket->clear();
-			break;
+	if (!m_dispatchScheduled) {
+		if (!PostMessage(m_messageWindow, DispatchRequestsMsg, 0, 0)) {
+			Logger::error("CrossfireServer.processRequest(): PostMessage() failed", GetLastError());
+			dispatchRequests();
+			return;
 		}
-		size_t toolsLength = toolEnd - endIndex;
-		size_t targetLength = wcslen(HEADER_CONTENTLENGTH) + lengthString.length() + 3 * LINEBREAK_LENGTH + toolsLength + lengthValue;
+		m_dispatchScheduled = true;
+	}
+}
 
-		if (targetLength <= m_inProgressPacket->length()) {
-			packet.assign(m_inProgressPacket->substr(0, targetLength));
-			m_inProgressPacket->erase(0, targetLength);
-		}
+/*
+ * The received bytes are framed in place by the decoder.  A packet's content
+ * is parsed in place if it has been received at once, and is otherwise passed
+ * to the processor in the portions that it is received in rather than being
+ * accumulated.
+ */
+void CrossfireServer::received(const char* msg, size_t length) {
+	const char* current = msg;
+	const char* end = msg + length;
+	while (current < end) {
+		CrossfireFrameDecoder::Frame frame;
+		current += m_frameDecoder->decode(current, end - current, &frame);
+
+		CrossfireRequest* request = NULL;
+		char* parseErrorMessage = NULL;
+		int code = CODE_OK;
+		switch (frame.type) {
+			case CrossfireFrameDecoder::FRAME_HANDSHAKE: {
+				processHandshake(frame.chars, frame.length);
+				m_lastRequestSeq = -1;
+				break;
+			}
+			case CrossfireFrameDecoder::FRAME_ERROR: {
+				if (!m_handshakeReceived) {
+					Logger::error((char*)frame.message);
+					break;
+				}
 
-		if (packet.length()) {
-			CrossfireRequest* request = NULL;
-			code = m_processor->parseRequestPacket(&packet, &request, &parseErrorMessage);
-			if (code != CODE_OK) {
-				errorMessageRequiresFree = true;
-			} else {
-				unsigned int seq = request->getSeq();
-				if (!(m_lastRequestSeq == -1 || seq == m_lastRequestSeq + 1)) {
-					// TODO handle out-of-order packets
-					Logger::log("packet received out of sequence, still processing it");
+				/* the remainder of the received content cannot be framed, so it has been discarded */
+				processRequest(NULL, CODE_MALFORMED_PACKET, _strdup(frame.message));
+				break;
+			}
+			case CrossfireFrameDecoder::FRAME_PACKET: {
+				if (!frame.isTerminated) {
+					code = CODE_MALFORMED_PACKET;
+					parseErrorMessage = _strdup("Request packet does not contain terminating '\\r\\n'");
+				} else {
+					code = m_processor->parseRequestContent(frame.chars, frame.length, &request, &parseErrorMessage);
 				}
-				m_lastRequestSeq = seq;
-				m_processingRequest = true;
-				if (!performRequest(request)) {
-					/*
-					 * the request's command was not handled by the server,
-					 * so try to delegate to the specified context, if any
-					 */
-					CrossfireContext* context = getRequestContext(request);
-					if (!context) {
-						Logger::error("request command was unknown to the server and a valid context id was not provided, not processing it");
-					} else {
-						if (!context->performRequest(request)) {
-							Logger::error("request command was unknown to the server and to the specified context, not processing it");
-						}
-					}
+				processRequest(request, code, parseErrorMessage);
+				break;
+			}
+			case CrossfireFrameDecoder::FRAME_CONTENT: {
+				if (frame.isFirst) {
+					m_processor->beginRequestContent();
 				}
-				m_processingRequest = false;
-				delete request;
-
-				/*
-				 * Debugger events may have been received in response to the request that was
-				 * just processed.  These events can be sent now that processing of the request
-				 * is complete.
-				 */
-				sendPendingEvents();
+				m_processor->pushRequestContent(frame.chars, frame.length);
+				break;
 			}
-		}
-
-		if (code) {
-			CrossfireResponse response;
-			response.setCode(CODE_MALFORMED_PACKET);
-			response.setMessage(parseErrorMessage);
-			if (errorMessageRequiresFree) {
-				free(parseErrorMessage);
+			case CrossfireFrameDecoder::FRAME_CONTENT_END: {
+				code = m_processor->endRequestContent(&request, &parseErrorMessage);
+				if (!frame.isTerminated) {
+					delete request;
+					request = NULL;
+					free(parseErrorMessage);
+					code = CODE_MALFORMED_PACKET;
+					parseErrorMessage = _strdup("Request packet does not contain terminating '\\r\\n'");
+				}
+				processRequest(request, code, parseErrorMessage);
+				break;
 			}
-			Value emptyBody;
-			emptyBody.setType(TYPE_OBJECT);
-			response.setBody(&emptyBody);
-			sendResponse(&response);
 		}
-	} while (packet.length() > 0 && m_inProgressPacket->length() > 0);
+	}
 }
 
-void CrossfireServer::reset() {
+/*
+ * Releases the browsers, contexts and breakpoints of the last connection,
+ * along with any events that were held for it.
+ */
+void CrossfireServer::releaseContexts() {
 	delete m_bpManager;
 	m_bpManager = new CrossfireBPManager();
 
@@ -679,10 +834,6 @@ void CrossfireServer::reset() {
 	}
 	m_browsers->clear();
 
-	m_connection->close();
-	delete m_connection;
-	m_connection = NULL;
-
 	std::map<DWORD, CrossfireContext*>::iterator iterator2 = m_contexts->begin();
 	while (iterator2 != m_contexts->end()) {
 		delete iterator2->second;
@@ -698,44 +849,131 @@ void CrossfireServer::reset() {
 	m_pendingEvents->clear();
 
 	m_currentContextPID = 0;
+	m_resetPending = false;
+}
+
+/*
+ * Closes the connection and discards its queued requests.  The server can
+ * be reset from a message that is received while requests wait on calls into
+ * the browser, in which case those requests are still on the stack and are
+ * using the contexts and breakpoints.  Releasing these is then deferred until
+ * the last of the requests completes, and their responses are dropped since
+ * the connection is gone.
+ */
+void CrossfireServer::reset() {
+	m_connection->close();
+	delete m_connection;
+	m_connection = NULL;
+
+	std::deque<CrossfirePacket*>::iterator iterator = m_requestQueue->begin();
+	while (iterator != m_requestQueue->end()) {
+		delete *iterator;
+		iterator++;
+	}
+	m_requestQueue->clear();
+
+	m_frameDecoder->reset();
 	m_handshakeReceived = false;
-	m_inProgressPacket->clear();
 	m_lastRequestSeq = -1;
 	m_port = -1;
-	m_processingRequest = false;
+	m_processor->setEncoding(ENCODING_JSON);
+	m_processor->setUseStringTable(false);
+
+	if (m_activeRequests) {
+		m_resetPending = true;
+		return;
+	}
+	releaseContexts();
+}
+
+void CrossfireServer::runRequest(CrossfireRequest* request) {
+	std::string* contextId = request->getContextId();
+	bool exclusive = !contextId || isServerCommand(request->getName());
+	if (exclusive) {
+		m_exclusiveRequestActive = true;
+	} else {
+		m_activeContexts->insert(*contextId);
+	}
+	m_activeRequests++;
+
+	if (!performRequest(request)) {
+		/*
+		 * the request's command was not handled by the server,
+		 * so try to delegate to the specified context, if any
+		 */
+		CrossfireContext* context = getRequestContext(request);
+		if (!context) {
+			Logger::error("request command was unknown to the server and a valid context id was not provided, not processing it");
+		} else {
+			if (!context->performRequest(request)) {
+				Logger::error("request command was unknown to the server and to the specified context, not processing it");
+			}
+		}
+	}
+
+	m_activeRequests--;
+	if (exclusive) {
+		m_exclusiveRequestActive = false;
+	} else {
+		m_activeContexts->erase(*contextId);
+	}
+	delete request;
+
+	if (!m_activeRequests) {
+		if (m_resetPending) {
+			/* the server was reset while these requests were in progress */
+			releaseContexts();
+			return;
+		}
+
+		/*
+		 * Debugger events may have been received in response to the requests that
+		 * were in progress.  These events can be sent now that all of them are complete.
+		 */
+		sendPendingEvents();
+	}
 }
 
 void CrossfireServer::sendEvent(CrossfireEvent* eventObj) {
 	/*
-	 * If a request is being processed, or if the client handshake has not
+	 * If requests are being processed, or if the client handshake has not
 	 * been received yet, then events to be sent to the client should be
 	 * queued and sent after these conditions have passed.
 	 */
-	if (m_processingRequest || !m_handshakeReceived) {
+	if (m_activeRequests || !m_handshakeReceived) {
 		CrossfireEvent* copy = NULL;
 		eventObj->clone((CrossfirePacket**)&copy);
 		m_pendingEvents->push_back(copy);
 		return;
 	}
 
-	std::wstring* string = NULL;
-	if (!m_processor->createEventPacket(eventObj, &string)) {
+	const char* packet = NULL;
+	size_t length = 0;
+	if (!m_processor->createEventPacket(eventObj, &packet, &length)) {
 		Logger::error("CrossfireServer.sendEvent(): Invalid event packet, not sending it");
 		return;
 	}
 
-	m_connection->send(string->c_str());
-	delete string;
+	/*
+	 * Events are queued rather than sent so that those which occur together, such
+	 * as the onScript events of a page's scripts, are written to the socket
+	 * together.  A response is sent immediately, after any events queued ahead of it.
+	 */
+	m_connection->queue(packet, length);
 }
 
 void CrossfireServer::sendResponse(CrossfireResponse* response) {
-	std::wstring* string = NULL;
-	if (!m_processor->createResponsePacket(response, &string)) {
+	if (!m_connection) {
+		/* the connection was closed while the request was in progress */
+		return;
+	}
+	const char* packet = NULL;
+	size_t length = 0;
+	if (!m_processor->createResponsePacket(response, &packet, &length)) {
 		Logger::error("CrossfireServer.sendResponse(): Invalid response packet, not sending it");
 		return;
 	}
-	m_connection->send(string->c_str());
-	delete string;
+	m_connection->send(packet, length);
 }
 
 void CrossfireServer::setWindowHandle(unsigned long value) {
@@ -743,26 +981,35 @@ void CrossfireServer::setWindowHandle(unsigned long value) {
 }
 
 LRESULT CALLBACK CrossfireServer::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+	if (message == DispatchRequestsMsg) {
+		CrossfireServer* instance = (CrossfireServer*)GetWindowLongPtr(hWnd, GWLP_USERDATA);
+		if (instance) {
+			instance->m_dispatchScheduled = false;
+			instance->dispatchRequests();
+		}
+		return 0;
+	}
 	return DefWindowProc(hWnd, message, wParam, lParam);
 }
 
 /* commands */
 
-int CrossfireServer::commandCreateContext(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireServer::commandCreateContext(Value* arguments, Value** _responseBody, char** _message) {
 	Value* value_url = arguments->getObjectValue(KEY_URL);
 	if (!value_url || value_url->getType() != TYPE_STRING) {
-		*_message = _wcsdup(L"'createContext' request does not have a valid 'url' value");
+		*_message = _strdup("'createContext' request does not have a valid 'url' value");
 		return CODE_INVALID_ARGUMENT;
 	}
-	std::wstring* url = value_url->getStringValue();
+	std::wstring url;
+	UTF8Transcoder::toWide(value_url->getStringValue(), value_url->getStringLength(), &url);
 
-	std::wstring* contextId = NULL;
+	const char* contextId = NULL;
 	Value* value_contextId = arguments->getObjectValue(KEY_CONTEXTID);
 	if (value_contextId) {
 		int type = value_contextId->getType();
 		if (type != TYPE_NULL) {
 			if (type != TYPE_STRING) {
-				*_message = _wcsdup(L"'createContext' request has an invalid 'contextId' value");
+				*_message = _strdup("'createContext' request has an invalid 'contextId' value");
 				return CODE_INVALID_ARGUMENT;
 			}
 			contextId = value_contextId->getStringValue();
@@ -771,9 +1018,9 @@ int CrossfireServer::commandCreateContext(Value* arguments, Value** _responseBod
 
 	CrossfireContext* context = NULL;
 	if (contextId) {
-		context = getContext((wchar_t*)contextId->c_str());
+		context = getContext((char*)contextId);
 		if (!context) {
-			*_message = _wcsdup(L"'createContext' request specified an unknown 'contextId' value");
+			*_message = _strdup("'createContext' request specified an unknown 'contextId' value");
 			return CODE_COMMAND_FAILED;
 		}
 		DWORD processId = context->getProcessId();
@@ -782,7 +1029,7 @@ int CrossfireServer::commandCreateContext(Value* arguments, Value** _responseBod
 			Logger::error("commandCreateContext(): the specified processId is not listening to the server");
 			return CODE_UNEXPECTED_EXCEPTION;
 		}
-		if (FAILED(listener->navigate((OLECHAR*)url->c_str(), false))) {
+		if (FAILED(listener->navigate((OLECHAR*)url.c_str(), false))) {
 			return CODE_COMMAND_FAILED;
 		}
 	} else {
@@ -791,7 +1038,7 @@ int CrossfireServer::commandCreateContext(Value* arguments, Value** _responseBod
 		std::map<DWORD,IBrowserContext*>::iterator iterator = m_browsers->begin();
 		while (iterator != m_browsers->end()) {
 			IBrowserContext* listener = iterator->second;
-			if (SUCCEEDED(listener->navigate((OLECHAR*)url->c_str(), true))) {
+			if (SUCCEEDED(listener->navigate((OLECHAR*)url.c_str(), true))) {
 				break;
 			}
 		}
@@ -807,54 +1054,44 @@ int CrossfireServer::commandCreateContext(Value* arguments, Value** _responseBod
 	return CODE_OK;
 }
 
-int CrossfireServer::commandDisableTools(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireServer::commandDisableTools(Value* arguments, Value** _responseBody, char** _message) {
 	Value* value_tools = arguments->getObjectValue(KEY_TOOLS);
 	if (!value_tools || value_tools->getType() != TYPE_ARRAY) {
-		*_message = _wcsdup(L"'disableTools' request does not have a valid 'tools' value");
+		*_message = _strdup("'disableTools' request does not have a valid 'tools' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
-	Value** values = NULL;
-	value_tools->getArrayValues(&values);
-	int index = 0;
-	Value* currentValue = values[index];
-	while (currentValue) {
+	size_t size = value_tools->getArraySize();
+	for (size_t index = 0; index < size; index++) {
+		Value* currentValue = value_tools->getArrayValueAt(index);
 		if (currentValue->getType() != TYPE_STRING) {
-			*_message = _wcsdup(L"'disableTools' request contains an invalid 'tools' value");
-			delete[] values;
+			*_message = _strdup("'disableTools' request contains an invalid 'tools' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		// TODO do something here
-		currentValue = values[++index];
 	}
-	delete[] values;
 
 //	Value* result = new Value();
 //	*_responseBody = result;
 	return CODE_COMMAND_NOT_IMPLEMENTED; // TODO implement
 }
 
-int CrossfireServer::commandEnableTools(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireServer::commandEnableTools(Value* arguments, Value** _responseBody, char** _message) {
 	Value* value_tools = arguments->getObjectValue(KEY_TOOLS);
 	if (!value_tools || value_tools->getType() != TYPE_ARRAY) {
-		*_message = _wcsdup(L"'enableTools' request does not have a valid 'tools' value");
+		*_message = _strdup("'enableTools' request does not have a valid 'tools' value");
 		return CODE_INVALID_ARGUMENT;
 	}
 
-	Value** values = NULL;
-	value_tools->getArrayValues(&values);
-	int index = 0;
-	Value* currentValue = values[index];
-	while (currentValue) {
+	size_t size = value_tools->getArraySize();
+	for (size_t index = 0; index < size; index++) {
+		Value* currentValue = value_tools->getArrayValueAt(index);
 		if (currentValue->getType() != TYPE_STRING) {
-			*_message = _wcsdup(L"'enableTools' request contains an invalid 'tools' value");
-			delete[] values;
+			*_message = _strdup("'enableTools' request contains an invalid 'tools' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 		// TODO do something here
-		currentValue = values[++index];
 	}
-	delete[] values;
 
 //	Value* result = new Value();
 //	result->addObjectValue(KEY_TOOLS, &toolsArray);
@@ -862,46 +1099,46 @@ int CrossfireServer::commandEnableTools(Value* arguments, Value** _responseBody,
 	return CODE_COMMAND_NOT_IMPLEMENTED; // TODO implement
 }
 
-int CrossfireServer::commandGetTools(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireServer::commandGetTools(Value* arguments, Value** _responseBody, char** _message) {
 	Value* value_tools = arguments->getObjectValue(KEY_TOOLS);
 	if (value_tools) {
 		if (value_tools->getType() != TYPE_ARRAY) {
-			*_message = _wcsdup(L"'getTools' request has an invalid 'tools' value");
+			*_message = _strdup("'getTools' request has an invalid 'tools' value");
 			return CODE_INVALID_ARGUMENT;
 		}
 	}
 
-	Value toolsArray;
-	toolsArray.setType(TYPE_ARRAY);
+	Value* toolsArray = new Value();
+	toolsArray->setType(TYPE_ARRAY);
 	Value* result = new Value();
-	result->addObjectValue(KEY_TOOLS, &toolsArray);
+	result->adoptObjectValue(KEY_TOOLS, toolsArray);
 	*_responseBody = result;
 	return CODE_OK;
 }
 
-int CrossfireServer::commandListContexts(Value* arguments, Value** _responseBody, wchar_t** _message) {
-	Value contexts;
-	contexts.setType(TYPE_ARRAY);
+int CrossfireServer::commandListContexts(Value* arguments, Value** _responseBody, char** _message) {
+	Value* contexts = new Value();
+	contexts->setType(TYPE_ARRAY);
 	std::map<DWORD,CrossfireContext*>::iterator iterator = m_contexts->begin();
 	while (iterator != m_contexts->end()) {
 		CrossfireContext* context = iterator->second;
-		Value value_context;
-		value_context.addObjectValue(KEY_CONTEXTID, &Value(context->getName()));
-		value_context.addObjectValue(KEY_URL, &Value(context->getUrl()));
-		value_context.addObjectValue(KEY_CURRENT, &Value((bool)(context->getProcessId() == m_currentContextPID)));
-		contexts.addArrayValue(&value_context);
+		Value* value_context = new Value();
+		value_context->adoptObjectValue(KEY_CONTEXTID, new Value(context->getName()));
+		value_context->adoptObjectValue(KEY_URL, new Value(context->getUrl()));
+		value_context->adoptObjectValue(KEY_CURRENT, new Value((bool)(context->getProcessId() == m_currentContextPID)));
+		contexts->adoptArrayValue(value_context);
 		iterator++;
 	}
 
 	Value* result = new Value();
-	result->addObjectValue(KEY_CONTEXTS, &contexts);
+	result->adoptObjectValue(KEY_CONTEXTS, contexts);
 	*_responseBody = result;
 	return CODE_OK;
 }
 
-int CrossfireServer::commandVersion(Value* arguments, Value** _responseBody, wchar_t** _message) {
+int CrossfireServer::commandVersion(Value* arguments, Value** _responseBody, char** _message) {
 	Value* result = new Value();
-	result->addObjectValue(KEY_VERSION, &Value(VERSION_STRING));
+	result->adoptObjectValue(KEY_VERSION, new Value(VERSION_STRING));
 	*_responseBody = result;
 	return CODE_OK;
 }
@@ -917,40 +1154,40 @@ void CrossfireServer::eventClosed() {
 void CrossfireServer::eventContextCreated(CrossfireContext* context) {
 	CrossfireEvent eventObj;
 	eventObj.setName(EVENT_CONTEXTCREATED);
-	Value body;
-	body.addObjectValue(KEY_URL, &Value(&std::wstring(context->getUrl())));
-	body.addObjectValue(KEY_CONTEXTID, &Value(&std::wstring(context->getName())));
-	eventObj.setBody(&body);
+	Value* body = new Value();
+	body->adoptObjectValue(KEY_URL, new Value(context->getUrl()));
+	body->adoptObjectValue(KEY_CONTEXTID, new Value(context->getName()));
+	eventObj.adoptBody(body);
 	sendEvent(&eventObj);
 }
 
 void CrossfireServer::eventContextDestroyed(CrossfireContext* context) {
 	CrossfireEvent eventObj;
 	eventObj.setName(EVENT_CONTEXTDESTROYED);
-	Value body;
-	body.addObjectValue(KEY_CONTEXTID, &Value(&std::wstring(context->getName())));
-	eventObj.setBody(&body);
+	Value* body = new Value();
+	body->adoptObjectValue(KEY_CONTEXTID, new Value(context->getName()));
+	eventObj.adoptBody(body);
 	sendEvent(&eventObj);
 }
 
 void CrossfireServer::eventContextLoaded(CrossfireContext* context) {
 	CrossfireEvent eventObj;
 	eventObj.setName(EVENT_CONTEXTLOADED);
-	Value body;
-	body.addObjectValue(KEY_URL, &Value(&std::wstring(context->getUrl())));
-	body.addObjectValue(KEY_CONTEXTID, &Value(&std::wstring(context->getName())));
-	eventObj.setBody(&body);
+	Value* body = new Value();
+	body->adoptObjectValue(KEY_URL, new Value(context->getUrl()));
+	body->adoptObjectValue(KEY_CONTEXTID, new Value(context->getName()));
+	eventObj.adoptBody(body);
 	sendEvent(&eventObj);
 }
 
 void CrossfireServer::eventContextSelected(CrossfireContext* context, CrossfireContext* oldContext) {
 	CrossfireEvent eventObj;
 	eventObj.setName(EVENT_CONTEXTSELECTED);
-	Value body;
-	body.addObjectValue(KEY_OLDCONTEXTID, &Value(&std::wstring(oldContext->getName())));
-	body.addObjectValue(KEY_OLDURL, &Value(&std::wstring(oldContext->getUrl())));
-	body.addObjectValue(KEY_CONTEXTID, &Value(&std::wstring(context->getName())));
-	body.addObjectValue(KEY_URL, &Value(&std::wstring(context->getUrl())));
-	eventObj.setBody(&body);
+	Value* body = new Value();
+	body->adoptObjectValue(KEY_OLDCONTEXTID, new Value(oldContext->getName()));
+	body->adoptObjectValue(KEY_OLDURL, new Value(oldContext->getUrl()));
+	body->adoptObjectValue(KEY_CONTEXTID, new Value(context->getName()));
+	body->adoptObjectValue(KEY_URL, new Value(context->getUrl()));
+	eventObj.adoptBody(body);
 	sendEvent(&eventObj);
 }
@@ -13,13 +13,17 @@
 #pragma once
 
 #include "resource.h"
+#include <deque>
 #include <map>
+#include <set>
 
 #include "CrossfireBPManager.h"
 #include "CrossfireContext.h"
 #include "CrossfireEvent.h"
+#include "CrossfireFrameDecoder.h"
 #include "CrossfireProcessor.h"
 #include "CrossfireResponse.h"
+#include "UTF8Transcoder.h"
 #include "WindowsSocketConnection.h"
 
 enum {
@@ -70,107 +74,124 @@ public:
 	void disconnected();
 	CrossfireBPManager* getBreakpointManager();
 	bool isConnected();
-	void received(wchar_t* msg);
+	void received(const char* msg, size_t length);
 	void sendEvent(CrossfireEvent* eventObj);
 	void sendResponse(CrossfireResponse* response);
 	void setWindowHandle(unsigned long value);
 
 private:
-	CrossfireContext* getContext(wchar_t* contextId);
+	void dispatchRequests();
+	bool findNextRequest(CrossfirePacket** _value);
+	CrossfireContext* getContext(char* contextId);
 	void getContextsArray(CrossfireContext*** _value);
+	unsigned int getEventBatchWindow();
 	CrossfireContext* getRequestContext(CrossfireRequest* request);
+	bool isServerCommand(const char* command);
 	bool performRequest(CrossfireRequest* request);
-	bool processHandshake(wchar_t* msg);
+	bool processHandshake(const char* chars, size_t length);
+	void processRequest(CrossfireRequest* request, int code, char* parseErrorMessage);
+	void releaseContexts();
 	void reset();
+	void runRequest(CrossfireRequest* request);
 	void sendPendingEvents();
 
+	std::set<std::string>* m_activeContexts;
+	unsigned int m_activeRequests;
 	CrossfireBPManager* m_bpManager;
 	std::map<DWORD, IBrowserContext*>* m_browsers;
 	WindowsSocketConnection* m_connection;
 	bool m_connectionWarningShown;
 	std::map<DWORD, CrossfireContext*>* m_contexts;
 	DWORD m_currentContextPID;
+	bool m_dispatchScheduled;
+	bool m_exclusiveRequestActive;
+	CrossfireFrameDecoder* m_frameDecoder;
 	bool m_handshakeReceived;
-	std::wstring* m_inProgressPacket;
 	unsigned int m_lastRequestSeq;
 	HWND m_messageWindow;
 	std::vector<CrossfireEvent*>* m_pendingEvents;
 	unsigned int m_port;
-	bool m_processingRequest;
 	CrossfireProcessor* m_processor;
+	std::deque<CrossfirePacket*>* m_requestQueue;
+	bool m_resetPending;
 	unsigned long m_windowHandle;
 
+	static const UINT DispatchRequestsMsg;
 	static const UINT ServerStateChangeMsg;
 	static const wchar_t* WindowClass;
 	static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
-	static const wchar_t* COMMAND_CHANGEBREAKPOINTS;
-	static const wchar_t* COMMAND_DELETEBREAKPOINTS;
-	static const wchar_t* COMMAND_GETBREAKPOINTS;
-	static const wchar_t* COMMAND_SETBREAKPOINTS;
+	static const char* COMMAND_CHANGEBREAKPOINTS;
+	static const char* COMMAND_DELETEBREAKPOINTS;
+	static const char* COMMAND_GETBREAKPOINTS;
+	static const char* COMMAND_SETBREAKPOINTS;
 
 	/* command: createContext */
-	static const wchar_t* COMMAND_CREATECONTEXT;
-	int commandCreateContext(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_CREATECONTEXT;
+	int commandCreateContext(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: disableTools */
-	static const wchar_t* COMMAND_DISABLETOOLS;
-	int commandDisableTools(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_DISABLETOOLS;
+	int commandDisableTools(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: enableTools */
-	static const wchar_t* COMMAND_ENABLETOOLS;
-	int commandEnableTools(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_ENABLETOOLS;
+	int commandEnableTools(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: getTools */
-	static const wchar_t* COMMAND_GETTOOLS;
-	int commandGetTools(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_GETTOOLS;
+	int commandGetTools(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: listContexts */
-	static const wchar_t* COMMAND_LISTCONTEXTS;
-	static const wchar_t* KEY_CONTEXTS;
-	static const wchar_t* KEY_CURRENT;
-	int commandListContexts(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_LISTCONTEXTS;
+	static ValueAtom* KEY_CONTEXTS;
+	static ValueAtom* KEY_CURRENT;
+	int commandListContexts(Value* arguments, Value** _responseBody, char** _message);
 
 	/* command: version */
-	static const wchar_t* COMMAND_VERSION;
-	static const wchar_t* KEY_VERSION;
-	static const wchar_t* VERSION_STRING;
-	int commandVersion(Value* arguments, Value** _responseBody, wchar_t** _message);
+	static const char* COMMAND_VERSION;
+	static ValueAtom* KEY_VERSION;
+	static const char* VERSION_STRING;
+	int commandVersion(Value* arguments, Value** _responseBody, char** _message);
 
 	/* event: closed */
-	static const wchar_t* EVENT_CLOSED;
+	static const char* EVENT_CLOSED;
 	void eventClosed();
 
 	/* event: onContextCreated */
-	static const wchar_t* EVENT_CONTEXTCREATED;
+	static const char* EVENT_CONTEXTCREATED;
 	void eventContextCreated(CrossfireContext* context);
 
 	/* event: onContextDestroyed */
-	static const wchar_t* EVENT_CONTEXTDESTROYED;
+	static const char* EVENT_CONTEXTDESTROYED;
 	void eventContextDestroyed(CrossfireContext* context);
 
 	/* event: onContextLoaded */
-	static const wchar_t* EVENT_CONTEXTLOADED;
+	static const char* EVENT_CONTEXTLOADED;
 	void eventContextLoaded(CrossfireContext* context);
 
 	/* event: onContextSelected */
-	static const wchar_t* EVENT_CONTEXTSELECTED;
-	static const wchar_t* KEY_OLDCONTEXTID;
-	static const wchar_t* KEY_OLDURL;
+	static const char* EVENT_CONTEXTSELECTED;
+	static ValueAtom* KEY_OLDCONTEXTID;
+	static ValueAtom* KEY_OLDURL;
 	void eventContextSelected(CrossfireContext* context, CrossfireContext* oldContext);
 
 	/* shared */
-	static const wchar_t* KEY_CONTEXTID;
-	static const wchar_t* KEY_TOOLS;
-	static const wchar_t* KEY_URL;
+	static ValueAtom* KEY_CONTEXTID;
+	static ValueAtom* KEY_TOOLS;
+	static ValueAtom* KEY_URL;
 
 	/* constants */
 	static const wchar_t* ABOUT_BLANK;
-	static const wchar_t* CONTEXTID_PREAMBLE;
-	static const wchar_t* HANDSHAKE;
-	static const wchar_t* HEADER_CONTENTLENGTH;
-	static const wchar_t* LINEBREAK;
-	static const size_t LINEBREAK_LENGTH;
+	static const char* CONTEXTID_PREAMBLE;
+	static const char* HANDSHAKE;
+	static const char* HANDSHAKE_ENCODING_CBOR;
+	static const char* HANDSHAKE_STRING_TABLE;
+	static const char* LINEBREAK;
+	static const wchar_t* PREFERENCE_EVENTBATCHWINDOW;
+	static const wchar_t* PREFERENCES_KEY;
+	static const unsigned int DEFAULT_EVENT_BATCH_WINDOW = 10;
+	static const unsigned int MAX_EVENT_BATCH_WINDOW = 100;
 };
 
 OBJECT_ENTRY_AUTO(__uuidof(CrossfireServer), CrossfireServer)
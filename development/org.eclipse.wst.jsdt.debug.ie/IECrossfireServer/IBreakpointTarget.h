@@ -25,7 +25,7 @@ public:
 	virtual ~IBreakpointTarget() {
 	}
 
-	virtual bool breakpointAttributeChanged(unsigned int handle, wchar_t* name, Value* value) = 0;
+	virtual bool breakpointAttributeChanged(unsigned int handle, char* name, Value* value) = 0;
 	virtual bool deleteBreakpoint(unsigned int handle) = 0;
 	virtual CrossfireBreakpoint* getBreakpoint(unsigned int handle) = 0;
 	virtual void getBreakpoints(CrossfireBreakpoint*** ___values) = 0;
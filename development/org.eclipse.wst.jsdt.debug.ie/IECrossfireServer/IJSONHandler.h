@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+
+#pragma once
+
+#include <string>
+
+/*
+ * Receives the content of a JSON document from JSONParser as it is parsed.
+ * Values within an object are each preceded by a call to onKey().  Returning
+ * false from any method stops the parse, which then fails.
+ */
+class IJSONHandler {
+
+public:
+	IJSONHandler() {
+	}
+
+	virtual ~IJSONHandler() {
+	}
+
+	virtual bool onBoolean(bool value) = 0;
+	virtual bool onEndArray() = 0;
+	virtual bool onEndObject() = 0;
+	virtual bool onKey(std::string* key) = 0;
+	virtual bool onNull() = 0;
+	virtual bool onNumber(double value) = 0;
+	virtual bool onStartArray() = 0;
+	virtual bool onStartObject() = 0;
+	virtual bool onString(std::string* value) = 0;
+};
@@ -0,0 +1,284 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "JSONDocument.h"
+
+#include <algorithm>
+
+#include "JSONParser.h"
+
+JSONDocument::JSONDocument() {
+	m_content = new std::vector<char>;
+	m_entries = new std::vector<Entry>;
+	m_keyBuffer = new std::string;
+	m_keyBuffer2 = new std::string;
+	m_keyHashes = new std::vector<KeyHash>;
+	m_openContainers = new std::vector<unsigned int>;
+	m_refCount = 1;
+	m_strings = new std::vector<std::string*>;
+}
+
+JSONDocument::~JSONDocument() {
+	clear();
+	delete m_content;
+	delete m_entries;
+	delete m_keyBuffer;
+	delete m_keyBuffer2;
+	delete m_keyHashes;
+	delete m_openContainers;
+	delete m_strings;
+}
+
+unsigned int JSONDocument::addEntry(int type, bool isKey) {
+	unsigned int index = (unsigned int)m_entries->size();
+	Entry entry;
+	entry.type = (unsigned short)type;
+	entry.flags = isKey ? FLAG_KEY : 0;
+	entry.next = index + 1;
+	entry.number = 0;
+	m_entries->push_back(entry);
+	if (!isKey && !m_openContainers->empty()) {
+		(*m_entries)[m_openContainers->back()].count++;
+	}
+	return index;
+}
+
+void JSONDocument::addRef() {
+	m_refCount++;
+}
+
+/*
+ * Records a string that is located within the document's content, which is
+ * only decoded if it is requested.
+ */
+bool JSONDocument::addString(unsigned int offset, unsigned int length, bool escaped, bool isKey) {
+	Entry* entry = &(*m_entries)[addEntry(TYPE_STRING, isKey)];
+	if (escaped) {
+		entry->flags |= FLAG_ESCAPED;
+	}
+	entry->string.offset = offset;
+	entry->string.length = length;
+	return true;
+}
+
+void JSONDocument::appendStringValue(unsigned int index, std::string* target) {
+	Entry* entry = &(*m_entries)[index];
+	if (entry->flags & FLAG_DECODED) {
+		target->append(*(*m_strings)[entry->string.offset]);
+	} else {
+		const char* start = getContent() + entry->string.offset;
+		JSONParser::decodeString(start, start + entry->string.length, target);
+	}
+}
+
+void JSONDocument::clear() {
+	std::vector<std::string*>::iterator iterator = m_strings->begin();
+	while (iterator != m_strings->end()) {
+		delete *iterator;
+		iterator++;
+	}
+	m_strings->clear();
+	m_content->clear();
+	m_entries->clear();
+	m_openContainers->clear();
+}
+
+bool JSONDocument::endContainer() {
+	unsigned int index = m_openContainers->back();
+	m_openContainers->pop_back();
+	(*m_entries)[index].next = (unsigned int)m_entries->size();
+	if ((*m_entries)[index].type == TYPE_OBJECT && !hasUniqueKeys(index)) {
+		Logger::error("JSON string has an object with a duplicate key");
+		return false;
+	}
+	return true;
+}
+
+const char* JSONDocument::getContent() {
+	if (m_content->empty()) {
+		return "";
+	}
+	return &(*m_content)[0];
+}
+
+unsigned int JSONDocument::getCount(unsigned int index) {
+	return (*m_entries)[index].count;
+}
+
+unsigned int JSONDocument::getNext(unsigned int index) {
+	return (*m_entries)[index].next;
+}
+
+double JSONDocument::getNumberValue(unsigned int index) {
+	return (*m_entries)[index].number;
+}
+
+/*
+ * Answers the decoded content of a string entry.  An unescaped string is
+ * answered in place, and only an escaped one is decoded, into the given buffer.
+ */
+void JSONDocument::getStringChars(unsigned int index, std::string* buffer, const char** _chars, size_t* _length) {
+	Entry* entry = &(*m_entries)[index];
+	if (entry->flags & FLAG_DECODED) {
+		std::string* string = (*m_strings)[entry->string.offset];
+		*_chars = string->data();
+		*_length = string->length();
+	} else if (entry->flags & FLAG_ESCAPED) {
+		buffer->clear();
+		appendStringValue(index, buffer);
+		*_chars = buffer->data();
+		*_length = buffer->length();
+	} else {
+		*_chars = getContent() + entry->string.offset;
+		*_length = entry->string.length;
+	}
+}
+
+void JSONDocument::getStringValue(unsigned int index, std::string** _value) {
+	std::string* result = new std::string;
+	appendStringValue(index, result);
+	*_value = result;
+}
+
+int JSONDocument::getType(unsigned int index) {
+	return (*m_entries)[index].type;
+}
+
+/*
+ * Verifies that an object's keys are unique by sorting them by a hash of
+ * their decoded content, so that only keys with equal hashes are compared.
+ * Unescaped keys are hashed in place and no memory is allocated once the
+ * buffers have grown to the size of the document's keys.
+ */
+bool JSONDocument::hasUniqueKeys(unsigned int index) {
+	unsigned int count = (*m_entries)[index].count;
+	if (count < 2) {
+		return true;
+	}
+
+	m_keyHashes->clear();
+	unsigned int keyIndex = index + 1;
+	for (unsigned int i = 0; i < count; i++) {
+		const char* chars = NULL;
+		size_t length = 0;
+		getStringChars(keyIndex, m_keyBuffer, &chars, &length);
+
+		/* FNV-1a */
+		unsigned int hash = 2166136261U;
+		for (size_t j = 0; j < length; j++) {
+			hash = (hash ^ (unsigned char)chars[j]) * 16777619U;
+		}
+		KeyHash key;
+		key.hash = hash;
+		key.index = keyIndex;
+		m_keyHashes->push_back(key);
+		keyIndex = getNext(getNext(keyIndex));
+	}
+
+	std::sort(m_keyHashes->begin(), m_keyHashes->end());
+	for (size_t i = 1; i < m_keyHashes->size(); i++) {
+		for (size_t j = i; j > 0 && (*m_keyHashes)[j - 1].hash == (*m_keyHashes)[i].hash; j--) {
+			const char* chars = NULL;
+			size_t length = 0;
+			const char* otherChars = NULL;
+			size_t otherLength = 0;
+			getStringChars((*m_keyHashes)[i].index, m_keyBuffer, &chars, &length);
+			getStringChars((*m_keyHashes)[j - 1].index, m_keyBuffer2, &otherChars, &otherLength);
+			if (length == otherLength && memcmp(chars, otherChars, length) == 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool JSONDocument::onBoolean(bool value) {
+	(*m_entries)[addEntry(TYPE_BOOLEAN, false)].number = value ? 1 : 0;
+	return true;
+}
+
+bool JSONDocument::onEndArray() {
+	return endContainer();
+}
+
+bool JSONDocument::onEndObject() {
+	return endContainer();
+}
+
+/*
+ * Strings that are reported already decoded (ie.- when the document is built
+ * incrementally) are kept as they are.
+ */
+bool JSONDocument::onKey(std::string* key) {
+	Entry* entry = &(*m_entries)[addEntry(TYPE_STRING, true)];
+	entry->flags |= FLAG_DECODED;
+	entry->string.offset = (unsigned int)m_strings->size();
+	entry->string.length = (unsigned int)key->length();
+	m_strings->push_back(new std::string(*key));
+	return true;
+}
+
+bool JSONDocument::onNull() {
+	addEntry(TYPE_NULL, false);
+	return true;
+}
+
+bool JSONDocument::onNumber(double value) {
+	(*m_entries)[addEntry(TYPE_NUMBER, false)].number = value;
+	return true;
+}
+
+bool JSONDocument::onStartArray() {
+	m_openContainers->push_back(addEntry(TYPE_ARRAY, false));
+	return true;
+}
+
+bool JSONDocument::onStartObject() {
+	m_openContainers->push_back(addEntry(TYPE_OBJECT, false));
+	return true;
+}
+
+bool JSONDocument::onString(std::string* value) {
+	Entry* entry = &(*m_entries)[addEntry(TYPE_STRING, false)];
+	entry->flags |= FLAG_DECODED;
+	entry->string.offset = (unsigned int)m_strings->size();
+	entry->string.length = (unsigned int)value->length();
+	m_strings->push_back(new std::string(*value));
+	return true;
+}
+
+bool JSONDocument::KeyHash::operator<(const KeyHash& other) const {
+	return hash < other.hash;
+}
+
+void JSONDocument::release() {
+	if (--m_refCount == 0) {
+		delete this;
+	}
+}
+
+void JSONDocument::setContent(const char* json, size_t length) {
+	m_content->assign(json, json + length);
+}
+
+/*
+ * Compares a string entry to the given value without decoding the entry, as
+ * long as it has no escape sequences.  The value's length is given since a
+ * decoded string can contain '\0'.
+ */
+bool JSONDocument::stringEquals(unsigned int index, const char* value, size_t length) {
+	const char* chars = NULL;
+	size_t stringLength = 0;
+	getStringChars(index, m_keyBuffer, &chars, &stringLength);
+	return stringLength == length && memcmp(chars, value, length) == 0;
+}
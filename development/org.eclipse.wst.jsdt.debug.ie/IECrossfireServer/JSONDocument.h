@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+
+#pragma once
+
+#include <vector>
+
+#include "IJSONHandler.h"
+#include "Value.h"
+#include "Logger.h"
+
+/*
+ * A parsed JSON document stored as a flat tape of entries, one per value and
+ * per object key, in document order.  Strings are recorded as ranges of the
+ * document's content and are only decoded when requested.  Each entry records
+ * the index of the entry that follows it and its contents, so a container can
+ * be skipped without examining its contents.
+ *
+ * Documents are shared by the Values that are created from them (see
+ * Value(JSONDocument*, unsigned int)) and are reference counted accordingly.
+ */
+class JSONDocument : public IJSONHandler {
+
+public:
+	JSONDocument();
+	void addRef();
+	bool addString(unsigned int offset, unsigned int length, bool escaped, bool isKey);
+	void appendStringValue(unsigned int index, std::string* target);
+	void clear();
+	const char* getContent();
+	unsigned int getCount(unsigned int index);
+	unsigned int getNext(unsigned int index);
+	double getNumberValue(unsigned int index);
+	void getStringValue(unsigned int index, std::string** _value);
+	int getType(unsigned int index);
+	void release();
+	void setContent(const char* json, size_t length);
+	bool stringEquals(unsigned int index, const char* value, size_t length);
+
+	/* IJSONHandler */
+	virtual bool onBoolean(bool value);
+	virtual bool onEndArray();
+	virtual bool onEndObject();
+	virtual bool onKey(std::string* key);
+	virtual bool onNull();
+	virtual bool onNumber(double value);
+	virtual bool onStartArray();
+	virtual bool onStartObject();
+	virtual bool onString(std::string* value);
+
+	static const unsigned int ROOT = 0;
+
+private:
+	virtual ~JSONDocument();
+
+	struct Entry {
+		unsigned short type;
+		unsigned short flags;
+		unsigned int next;
+		union {
+			double number;
+			unsigned int count;
+			struct {
+				unsigned int offset;
+				unsigned int length;
+			} string;
+		};
+	};
+
+	/* a key of the object being verified, ordered by the hash of its decoded content */
+	struct KeyHash {
+		unsigned int hash;
+		unsigned int index;
+		bool operator<(const KeyHash& other) const;
+	};
+
+	unsigned int addEntry(int type, bool isKey);
+	bool endContainer();
+	void getStringChars(unsigned int index, std::string* buffer, const char** _chars, size_t* _length);
+	bool hasUniqueKeys(unsigned int index);
+
+	std::vector<char>* m_content;
+	std::vector<Entry>* m_entries;
+	std::string* m_keyBuffer;
+	std::string* m_keyBuffer2;
+	std::vector<KeyHash>* m_keyHashes;
+	std::vector<unsigned int>* m_openContainers;
+	unsigned int m_refCount;
+	std::vector<std::string*>* m_strings;
+
+	/* entry flags */
+	static const unsigned short FLAG_DECODED = 0x1;
+	static const unsigned short FLAG_ESCAPED = 0x2;
+	static const unsigned short FLAG_KEY = 0x4;
+};
@@ -13,493 +13,822 @@
 #include "StdAfx.h"
 #include "JSONParser.h"
 
+#include "JSONDocument.h"
+#include "JSONStringScanner.h"
+
 /* initialize constants */
-const wchar_t* JSONParser::VALUE_FALSE = L"false";
-const wchar_t* JSONParser::VALUE_NULL = L"null";
-const wchar_t* JSONParser::VALUE_TRUE = L"true";
-const wchar_t* JSONParser::VALUE_UNDEFINED = L"\"undefined\"";
+const char* JSONParser::LITERAL_FALSE = "false";
+const char* JSONParser::LITERAL_NULL = "null";
+const char* JSONParser::LITERAL_TRUE = "true";
+const size_t JSONParser::INDEX_THRESHOLD = 1024;
+const size_t JSONParser::MAX_DEPTH = 512;
 
 JSONParser::JSONParser(void) {
+	m_builder = new JSONValueBuilder();
+	m_current = NULL;
+	m_document = NULL;
+	m_end = NULL;
+	m_handler = NULL;
+	m_indexed = false;
+	m_indexes = new std::vector<unsigned int>;
+	m_nextIndex = 0;
+	m_start = NULL;
+	m_pushContainers = new std::vector<int>;
+	m_pushState = PUSH_DONE;
+	m_pushStringIsKey = false;
+	m_pushToken = new std::string;
 }
 
 JSONParser::~JSONParser(void) {
+	delete m_builder;
+	delete m_indexes;
+	delete m_pushContainers;
+	delete m_pushToken;
+}
+
+/*
+ * Prepares to parse content that is provided incrementally through push(),
+ * typically as each portion of a packet is received from the socket.  All
+ * parse state is kept between calls, so each byte is examined only once
+ * regardless of how the content is divided.
+ */
+void JSONParser::beginPush() {
+	m_builder->clear();
+	beginPush(m_builder);
+}
+
+void JSONParser::beginPush(IJSONHandler* handler) {
+	m_handler = handler;
+	m_pushContainers->clear();
+	m_pushToken->clear();
+	m_pushState = PUSH_VALUE;
+}
+
+bool JSONParser::endPush() {
+	if (m_pushState == PUSH_ATOM) {
+		/* a top-level number or literal is only complete once the content ends */
+		completePushAtom();
+	}
+	bool success = m_pushState == PUSH_DONE;
+	if (!success && m_pushState != PUSH_ERROR) {
+		Logger::error("JSON string ended before its value was complete");
+	}
+	m_handler = NULL;
+	m_pushContainers->clear();
+	m_pushToken->clear();
+	m_pushState = PUSH_DONE;
+	return success;
 }
 
-void JSONParser::parse(std::wstring* jsonString, Value** _value) {
+void JSONParser::endPush(Value** _value) {
 	*_value = NULL;
+	if (endPush()) {
+		m_builder->getValue(_value);
+	}
+	m_builder->clear();
+}
+
+/*
+ * Parses UTF-8 encoded JSON content in place, without copying it into an
+ * intermediate stream or wide string first.  The content does not need to
+ * be null-terminated, so a packet's body can be parsed directly out of the
+ * buffer that it was received into.  The content is reported to the handler
+ * as it is parsed, so no Value is created unless the handler creates one.
+ *
+ * Larger content is first run through JSONStructuralIndex, after which the
+ * parser moves directly from one structural character to the next instead
+ * of examining the whitespace and string contents in between.  If the index
+ * cannot be built (the content ends within a string) then the content is
+ * parsed without it so that the usual detailed error is reported.  Content
+ * other than whitespace after the value is an error, as it is when the
+ * content is pushed.
+ */
+bool JSONParser::parse(const char* json, size_t length, IJSONHandler* handler) {
+	m_handler = handler;
+	m_current = m_start = json;
+	m_end = json + length;
+	m_nextIndex = 0;
+	m_indexed = INDEX_THRESHOLD <= length && JSONStructuralIndex::build(json, length, m_indexes);
+	bool success = parseValue(0);
+	if (success) {
+		/* as with pushed content, only whitespace can follow the value */
+		m_indexed = false;
+		skipWhitespace();
+		if (m_current != m_end) {
+			Logger::error("JSON string has unexpected content following its value");
+			success = false;
+		}
+	}
+	m_current = m_end = m_start = NULL;
+	m_handler = NULL;
+	m_indexed = false;
+	m_indexes->clear();
+	return success;
+}
 
-	std::wstringstream jsonStream(*jsonString);
-	parse(&jsonStream, _value);
+/*
+ * Parses the content into a JSONDocument, which keeps its own copy of the
+ * content.  The document's strings are recorded by their location within its
+ * content rather than being decoded here.
+ */
+bool JSONParser::parse(const char* json, size_t length, JSONDocument* document) {
+	document->clear();
+	document->setContent(json, length);
+	m_document = document;
+	bool success = parse(document->getContent(), length, (IJSONHandler*)document);
+	m_document = NULL;
+	return success;
 }
 
-void JSONParser::parse(std::wstringstream* jsonStream, Value** _value) {
+void JSONParser::parse(const char* json, size_t length, Value** _value) {
 	*_value = NULL;
 
-	skipWhitespace(jsonStream);
-	wchar_t firstChar = jsonStream->peek();
-	if (firstChar == wchar_t('n')) {
-		size_t length = wcslen(VALUE_NULL);
-		wchar_t* streamChars = new wchar_t[length];
-		jsonStream->read(streamChars, (std::streamsize)length);
-		if (wcsncmp(VALUE_NULL, streamChars, length) == 0) {
-			*_value = new Value();
-			(*_value)->setType(TYPE_NULL);
+	m_builder->clear();
+	if (parse(json, length, m_builder)) {
+		m_builder->getValue(_value);
+	}
+	m_builder->clear();
+}
+
+void JSONParser::parse(std::string* jsonString, Value** _value) {
+	parse(jsonString->c_str(), jsonString->length(), _value);
+}
+
+bool JSONParser::push(const char* json, size_t length) {
+	const char* current = json;
+	const char* end = json + length;
+	while (current < end) {
+		char currentChar = *current;
+		switch (m_pushState) {
+			case PUSH_STRING: {
+				/* copy the run of characters up to the next quote or backslash in bulk */
+				const char* runStart = current;
+				while (current < end && *current != '\"' && *current != '\\') {
+					current++;
+				}
+				m_pushToken->append(runStart, current - runStart);
+				if (current == end) {
+					continue;
+				}
+				m_pushToken->push_back(*current);
+				if (*current++ == '\\') {
+					m_pushState = PUSH_STRING_ESCAPE;
+				} else if (!completePushString()) {
+					return false;
+				}
+				continue;
+			}
+			case PUSH_STRING_ESCAPE: {
+				/* the escaped character is validated when the complete string is decoded */
+				m_pushToken->push_back(currentChar);
+				m_pushState = PUSH_STRING;
+				current++;
+				continue;
+			}
+			case PUSH_ATOM: {
+				switch (currentChar) {
+					case ' ':
+					case '\t':
+					case '\n':
+					case '\r':
+					case '\"':
+					case '{':
+					case '}':
+					case '[':
+					case ']':
+					case ':':
+					case ',': {
+						/* the atom is complete, the current character is handled in the resulting state */
+						if (!completePushAtom()) {
+							return false;
+						}
+						break;
+					}
+					default: {
+						m_pushToken->push_back(currentChar);
+						current++;
+						break;
+					}
+				}
+				continue;
+			}
+			case PUSH_ERROR: {
+				return false;
+			}
+		}
+
+		if (currentChar == ' ' || currentChar == '\t' || currentChar == '\n' || currentChar == '\r') {
+			current++;
+			continue;
+		}
+
+		switch (m_pushState) {
+			case PUSH_VALUE:
+			case PUSH_VALUE_OR_END: {
+				if (currentChar == ']' && m_pushState == PUSH_VALUE_OR_END) {
+					if (!endPushContainer(TYPE_ARRAY)) {
+						return false;
+					}
+					break;
+				}
+				if ((currentChar == '[' || currentChar == '{') && MAX_DEPTH <= m_pushContainers->size()) {
+					Logger::error("JSON string is nested too deeply");
+					m_pushState = PUSH_ERROR;
+					return false;
+				}
+				if (currentChar == '[') {
+					m_pushContainers->push_back(TYPE_ARRAY);
+					m_pushState = PUSH_VALUE_OR_END;
+					if (!m_handler->onStartArray()) {
+						m_pushState = PUSH_ERROR;
+						return false;
+					}
+					break;
+				}
+				if (currentChar == '{') {
+					m_pushContainers->push_back(TYPE_OBJECT);
+					m_pushState = PUSH_KEY_OR_END;
+					if (!m_handler->onStartObject()) {
+						m_pushState = PUSH_ERROR;
+						return false;
+					}
+					break;
+				}
+				if (currentChar == ']' || currentChar == '}' || currentChar == ':' || currentChar == ',') {
+					Logger::error("JSON string has a value that starts with an unexpected character");
+					m_pushState = PUSH_ERROR;
+					return false;
+				}
+				m_pushToken->clear();
+				m_pushToken->push_back(currentChar);
+				if (currentChar == '\"') {
+					m_pushStringIsKey = false;
+					m_pushState = PUSH_STRING;
+				} else {
+					m_pushState = PUSH_ATOM;
+				}
+				break;
+			}
+			case PUSH_KEY:
+			case PUSH_KEY_OR_END: {
+				if (currentChar == '}' && m_pushState == PUSH_KEY_OR_END) {
+					if (!endPushContainer(TYPE_OBJECT)) {
+						return false;
+					}
+					break;
+				}
+				if (currentChar != '\"') {
+					Logger::error("JSON string has an object with a non-String key value");
+					m_pushState = PUSH_ERROR;
+					return false;
+				}
+				m_pushToken->clear();
+				m_pushToken->push_back(currentChar);
+				m_pushStringIsKey = true;
+				m_pushState = PUSH_STRING;
+				break;
+			}
+			case PUSH_COLON: {
+				if (currentChar != ':') {
+					Logger::error("JSON string has an object without a ':' separating a key from its _value");
+					m_pushState = PUSH_ERROR;
+					return false;
+				}
+				m_pushState = PUSH_VALUE;
+				break;
+			}
+			case PUSH_SEPARATOR: {
+				bool isArray = m_pushContainers->back() == TYPE_ARRAY;
+				if (currentChar == ',') {
+					m_pushState = isArray ? PUSH_VALUE : PUSH_KEY;
+					break;
+				}
+				if (currentChar == (isArray ? ']' : '}')) {
+					if (!endPushContainer(m_pushContainers->back())) {
+						return false;
+					}
+					break;
+				}
+				if (isArray) {
+					Logger::error("JSON string has an array without expected closing ']'");
+				} else {
+					Logger::error("JSON string has an object without an expected closing '}'");
+				}
+				m_pushState = PUSH_ERROR;
+				return false;
+			}
+			case PUSH_DONE: {
+				Logger::error("JSON string has unexpected content following its value");
+				m_pushState = PUSH_ERROR;
+				return false;
+			}
+		}
+		current++;
+	}
+	return true;
+}
+
+void JSONParser::appendCodePoint(unsigned int codePoint, std::string* target) {
+	if (codePoint < 0x80) {
+		target->push_back((char)codePoint);
+	} else if (codePoint < 0x800) {
+		target->push_back((char)(0xC0 | (codePoint >> 6)));
+		target->push_back((char)(0x80 | (codePoint & 0x3F)));
+	} else if (codePoint < 0x10000) {
+		target->push_back((char)(0xE0 | (codePoint >> 12)));
+		target->push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+		target->push_back((char)(0x80 | (codePoint & 0x3F)));
+	} else {
+		target->push_back((char)(0xF0 | (codePoint >> 18)));
+		target->push_back((char)(0x80 | ((codePoint >> 12) & 0x3F)));
+		target->push_back((char)(0x80 | ((codePoint >> 6) & 0x3F)));
+		target->push_back((char)(0x80 | (codePoint & 0x3F)));
+	}
+}
+
+/*
+ * Numbers and literals are accumulated until the character following them is
+ * received, and are then parsed with the same code as non-incremental content.
+ */
+bool JSONParser::completePushAtom() {
+	m_current = m_pushToken->c_str();
+	m_end = m_current + m_pushToken->length();
+	bool success = parseValue(0);
+	if (success && m_current != m_end) {
+		Logger::error("JSON string has a value that is followed by an unexpected character");
+		success = false;
+	}
+	m_current = m_end = NULL;
+	if (!success) {
+		m_pushState = PUSH_ERROR;
+		return false;
+	}
+	completePushValue();
+	return true;
+}
+
+/*
+ * The raw characters of a string, including its quotes, are accumulated until
+ * its closing quote is received and are then decoded in a single pass.
+ */
+bool JSONParser::completePushString() {
+	m_current = m_pushToken->c_str();
+	m_end = m_current + m_pushToken->length();
+	std::string* stringValue = NULL;
+	parseString(&stringValue);
+	m_current = m_end = NULL;
+	if (!stringValue) {
+		m_pushState = PUSH_ERROR;
+		return false;
+	}
+
+	bool success;
+	if (m_pushStringIsKey) {
+		success = m_handler->onKey(stringValue);
+		m_pushState = PUSH_COLON;
+	} else {
+		success = m_handler->onString(stringValue);
+		completePushValue();
+	}
+	delete stringValue;
+	if (!success) {
+		m_pushState = PUSH_ERROR;
+	}
+	return success;
+}
+
+void JSONParser::completePushValue() {
+	m_pushState = m_pushContainers->empty() ? PUSH_DONE : PUSH_SEPARATOR;
+}
+
+/*
+ * Decodes the characters between a string's quotes, which must already have
+ * been validated by the parser.  The content is UTF-8 on both sides, so runs
+ * of unescaped bytes are located and appended in bulk as they are.
+ */
+void JSONParser::decodeString(const char* start, const char* end, std::string* target) {
+	const char* current = start;
+	while (current < end) {
+		const char* escape = JSONStringScanner::findQuoteOrBackslash(current, end);
+		target->append(current, escape - current);
+		if (escape == end) {
+			break;
+		}
+
+		current = escape + 1;
+		switch (*current) {
+			case 'b': {
+				target->push_back('\b');
+				break;
+			}
+			case 'f': {
+				target->push_back('\f');
+				break;
+			}
+			case 'n': {
+				target->push_back('\n');
+				break;
+			}
+			case 'r': {
+				target->push_back('\r');
+				break;
+			}
+			case 't': {
+				target->push_back('\t');
+				break;
+			}
+			case 'u': {
+				/*
+				 * An escaped surrogate pair is combined into the code point that it
+				 * denotes, and an unpaired surrogate, which cannot be represented in
+				 * UTF-8, is replaced with U+FFFD.
+				 */
+				unsigned int codePoint = (unsigned int)decodeUnicodeEscape(current + 1);
+				current += 4;
+				if (0xD800 <= codePoint && codePoint <= 0xDFFF) {
+					int low = -1;
+					if (codePoint < 0xDC00 && end - current > 6 && current[1] == '\\' && current[2] == 'u') {
+						low = decodeUnicodeEscape(current + 3);
+					}
+					if (0xDC00 <= low && low <= 0xDFFF) {
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						current += 6;
+					} else {
+						codePoint = 0xFFFD;
+					}
+				}
+				appendCodePoint(codePoint, target);
+				break;
+			}
+			default: {
+				/* '\"', '/' or '\\' */
+				target->push_back(*current);
+				break;
+			}
+		}
+		current++;
+	}
+}
+
+/*
+ * Returns the code unit denoted by the four hexadecimal digits of a \u escape,
+ * or -1 if they are not all hexadecimal digits.
+ */
+int JSONParser::decodeUnicodeEscape(const char* digits) {
+	int result = 0;
+	for (int i = 0; i < 4; i++) {
+		char c = digits[i];
+		int digit;
+		if ('0' <= c && c <= '9') {
+			digit = c - '0';
+		} else if ('a' <= c && c <= 'f') {
+			digit = c - 'a' + 10;
+		} else if ('A' <= c && c <= 'F') {
+			digit = c - 'A' + 10;
 		} else {
+			return -1;
+		}
+		result = (result << 4) | digit;
+	}
+	return result;
+}
+
+bool JSONParser::endPushContainer(int type) {
+	m_pushContainers->pop_back();
+	bool success = type == TYPE_ARRAY ? m_handler->onEndArray() : m_handler->onEndObject();
+	if (!success) {
+		m_pushState = PUSH_ERROR;
+		return false;
+	}
+	completePushValue();
+	return true;
+}
+
+/*
+ * Numbers and literals are the only values that are not terminated by a structural
+ * character, so when the index is in use it must be confirmed that such a value is
+ * followed by whitespace or a structural character, as nothing else is indexed.
+ */
+bool JSONParser::isAtomEnd() {
+	if (!m_indexed || m_current == m_end) {
+		return true;
+	}
+	switch (*m_current) {
+		case ' ':
+		case '\t':
+		case '\n':
+		case '\r':
+		case '\"':
+		case '{':
+		case '}':
+		case '[':
+		case ']':
+		case ':':
+		case ',': {
+			return true;
+		}
+	}
+	Logger::error("JSON string has a value that is followed by an unexpected character");
+	return false;
+}
+
+bool JSONParser::matchLiteral(const char* literal) {
+	size_t length = strlen(literal);
+	if ((size_t)(m_end - m_current) < length || strncmp(m_current, literal, length) != 0) {
+		return false;
+	}
+	m_current += length;
+	return true;
+}
+
+bool JSONParser::parseValue(int depth) {
+	skipWhitespace();
+	if (m_current == m_end) {
+		Logger::error("JSON string ended where a value was expected");
+		return false;
+	}
+
+	char firstChar = *m_current;
+	if (firstChar == 'n') {
+		if (!matchLiteral(LITERAL_NULL)) {
 			Logger::error("JSON string has invalid value that starts with 'n' but is not \"null\"");
+			return false;
 		}
-		delete[] streamChars;
-		return;
+		return isAtomEnd() && m_handler->onNull();
 	}
-	if (firstChar == wchar_t('t')) {
-		size_t length = wcslen(VALUE_TRUE);
-		wchar_t* streamChars = new wchar_t[length];
-		jsonStream->read(streamChars, (std::streamsize)length);
-		if (wcsncmp(VALUE_TRUE, streamChars, length) == 0) {
-			Value* result = new Value(true);
-			*_value = result;
-		} else {
+	if (firstChar == 't') {
+		if (!matchLiteral(LITERAL_TRUE)) {
 			Logger::error("JSON string has invalid value that starts with 't' but is not \"true\"");
+			return false;
 		}
-		delete[] streamChars;
-		return;
+		return isAtomEnd() && m_handler->onBoolean(true);
 	}
-	if (firstChar == wchar_t('f')) {
-		size_t length = wcslen(VALUE_FALSE);
-		wchar_t* streamChars = new wchar_t[length];
-		jsonStream->read(streamChars, (std::streamsize)length);
-		if (wcsncmp(VALUE_FALSE, streamChars, length) == 0) {
-			Value* result = new Value(false);
-			*_value = result;
-		} else {
+	if (firstChar == 'f') {
+		if (!matchLiteral(LITERAL_FALSE)) {
 			Logger::error("JSON string has invalid value that starts with 'f' but is not \"false\"");
+			return false;
 		}
-		delete[] streamChars;
-		return;
+		return isAtomEnd() && m_handler->onBoolean(false);
 	}
-	if (firstChar == wchar_t('\"')) {
-		std::wstring* stringValue = NULL;
-		parseString(jsonStream, &stringValue);
-		if (stringValue) {
-			Value* result = new Value(stringValue);
-			*_value = result;
-			delete stringValue;
-		} else {
-			/* parseString() already logs a detailed error message, so no error logged here */
-		}
-		return;
+	if (firstChar == '\"') {
+		return parseStringToken(false);
 	}
 
-	int index = 0;
 	switch (firstChar) {
-		case wchar_t('0'):
-		case wchar_t('1'):
-		case wchar_t('2'):
-		case wchar_t('3'):
-		case wchar_t('4'):
-		case wchar_t('5'):
-		case wchar_t('6'):
-		case wchar_t('7'):
-		case wchar_t('8'):
-		case wchar_t('9'):
-		case wchar_t('-'): {
-			double doubleValue = parseNumber(jsonStream);
-			if (doubleValue == -DBL_MAX) {
-				Logger::error("JSON string has a Number value with invalid character(s)");
-				return;
+		case '0':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+		case '-': {
+			double doubleValue = 0;
+			if (!parseNumber(&doubleValue)) {
+				return false;
 			}
-			Value* result = new Value(doubleValue);
-			*_value = result;
-			return;
+			return isAtomEnd() && m_handler->onNumber(doubleValue);
 		}
 	}
-	
-	if (firstChar == wchar_t('[')) {
-		parseArray(jsonStream, _value);
-		return;
+
+	if (firstChar == '[') {
+		return parseArray(depth);
 	}
 
-	if (firstChar == wchar_t('{')) {
-		parseObject(jsonStream, _value);
-		return;
+	if (firstChar == '{') {
+		return parseObject(depth);
 	}
-}
 
-void JSONParser::parseArray(std::wstringstream* jsonStream, Value** _value) {
-	*_value = NULL;
+	Logger::error("JSON string has a value that starts with an unexpected character");
+	return false;
+}
 
-	Value* result = new Value();
-	result->setType(TYPE_ARRAY);
+bool JSONParser::parseArray(int depth) {
+	if (MAX_DEPTH <= (size_t)depth) {
+		Logger::error("JSON string is nested too deeply");
+		return false;
+	}
+	if (!m_handler->onStartArray()) {
+		return false;
+	}
 
-	jsonStream->ignore(1);
-	skipWhitespace(jsonStream);
-	if (jsonStream->peek() == wchar_t(']')) {
-		jsonStream->ignore(1);
-		*_value = result;
-		return;
+	m_current++;
+	skipWhitespace();
+	if (m_current < m_end && *m_current == ']') {
+		m_current++;
+		return m_handler->onEndArray();
 	}
 
 	while (true) {
-		Value* currentValue = NULL;
-		parse(jsonStream, &currentValue);
-		if (!currentValue) {
-			delete result;
-			return;
+		if (!parseValue(depth + 1)) {
+			return false;
 		}
-		result->addArrayValue(currentValue);
-		delete currentValue;
-
-		skipWhitespace(jsonStream);
-		wchar_t nextChar = jsonStream->peek();
-		if (nextChar == wchar_t(',')) {
-			jsonStream->ignore(1);
-			skipWhitespace(jsonStream);
+
+		skipWhitespace();
+		char nextChar = m_current < m_end ? *m_current : '\0';
+		if (nextChar == ',') {
+			m_current++;
+			skipWhitespace();
 			continue;
 		}
-		if (nextChar == wchar_t(']')) {
-			jsonStream->ignore(1);
-			*_value = result;
-		} else {
-			Logger::error("JSON string has an array without expected closing ']'");
-			delete result;
+		if (nextChar == ']') {
+			m_current++;
+			return m_handler->onEndArray();
 		}
-		return;
+		Logger::error("JSON string has an array without expected closing ']'");
+		return false;
 	}
 }
 
-double JSONParser::parseNumber(std::wstringstream* jsonStream) {
-	int count = 0;
-	bool looking = true;
-	bool nonZeroEncountered = false;
-	wchar_t currentChar = jsonStream->peek();
-	while (looking) {
-		if (jsonStream->eof()) {
-			looking = false;
-			break;
-		}
-		switch (currentChar) {
-			case wchar_t('1'):
-			case wchar_t('2'):
-			case wchar_t('3'):
-			case wchar_t('4'):
-			case wchar_t('5'):
-			case wchar_t('6'):
-			case wchar_t('7'):
-			case wchar_t('8'):
-			case wchar_t('9'):
-			case wchar_t('-'):
-			case wchar_t('+'):
-			case wchar_t('e'):
-			case wchar_t('E'): {
-				nonZeroEncountered = true;
-			}
-			// FALL THROUGH
-			case wchar_t('0'):
-			case wchar_t('.'): {
-				jsonStream->ignore(1);
-				count++;
-				break;
-			}
-			default: {
-				looking = false;
-				break;
-			}
-		}
-		currentChar = jsonStream->peek();
-	}
-	for (int i = 0; i < count; i++) {
-		jsonStream->unget();
-	}
-
-	wchar_t* numberChars = new wchar_t[count + 1];
-	jsonStream->read(numberChars, count);
-	numberChars[count] = wchar_t('\0');
-	wchar_t* endPoint;
-	double numberValue = wcstod(numberChars, &endPoint);
-	delete[] numberChars;
-	if (numberValue == 0 && nonZeroEncountered) {
-		return -DBL_MAX;
+bool JSONParser::parseNumber(double* _value) {
+	const char* end = NULL;
+	if (!NumberParser::parse(m_current, m_end, _value, &end)) {
+		Logger::error("JSON string has a Number value that does not match the Number grammar");
+		return false;
 	}
-	return numberValue;
+	m_current = end;
+	return true;
 }
 
-void JSONParser::parseObject(std::wstringstream* jsonStream, Value** _value) {
-	*_value = NULL;
-
-	Value* result = new Value();
-	result->setType(TYPE_OBJECT);
+bool JSONParser::parseObject(int depth) {
+	if (MAX_DEPTH <= (size_t)depth) {
+		Logger::error("JSON string is nested too deeply");
+		return false;
+	}
+	if (!m_handler->onStartObject()) {
+		return false;
+	}
 
-	jsonStream->ignore(1);
-	skipWhitespace(jsonStream);
-	if (jsonStream->peek() == wchar_t('}')) {
-		jsonStream->ignore(1);
-		*_value = result;
-		return;
+	m_current++;
+	skipWhitespace();
+	if (m_current < m_end && *m_current == '}') {
+		m_current++;
+		return m_handler->onEndObject();
 	}
 
 	while (true) {
-		if (jsonStream->peek() != wchar_t('\"')) {
+		if (m_current == m_end || *m_current != '\"') {
 			Logger::error("JSON string has an object with a non-String key value");
-			delete result;
-			return;
+			return false;
 		}
-		std::wstring* key = NULL;
-		parseString(jsonStream, &key);
-		skipWhitespace(jsonStream);
-		if (jsonStream->get() != wchar_t(':')) {
-			Logger::error("JSON string has an object without a ':' separating a key from its _value");
-			delete key;
-			delete result;
-			return;
+		if (!parseStringToken(true)) {
+			return false;
 		}
-		Value* assocValue = NULL;
-		skipWhitespace(jsonStream);
-		parse(jsonStream, &assocValue);
-		if (!assocValue) {
-			delete key;
-			delete result;
-			return;
+		skipWhitespace();
+		if (m_current == m_end || *m_current != ':') {
+			Logger::error("JSON string has an object without a ':' separating a key from its _value");
+			return false;
 		}
-		bool success = result->addObjectValue(key, assocValue);
-		delete assocValue;
-		delete key;
-		if (!success) {
-			Logger::error("JSON string has an object with a duplicate key");
-			delete result;
-			return;
+		m_current++;
+		skipWhitespace();
+		if (!parseValue(depth + 1)) {
+			return false;
 		}
 
-		skipWhitespace(jsonStream);
-		wchar_t nextChar = jsonStream->peek();
-		if (nextChar == wchar_t(',')) {
-			jsonStream->ignore(1);
-			skipWhitespace(jsonStream);
+		skipWhitespace();
+		char nextChar = m_current < m_end ? *m_current : '\0';
+		if (nextChar == ',') {
+			m_current++;
+			skipWhitespace();
 			continue;
 		}
-		if (nextChar == wchar_t('}')) {
-			jsonStream->ignore(1);
-			*_value = result;
-		} else {
-			Logger::error("JSON string has an object without an expected closing '}'");
-			delete result;
+		if (nextChar == '}') {
+			m_current++;
+			return m_handler->onEndObject();
 		}
-		return;
+		Logger::error("JSON string has an object without an expected closing '}'");
+		return false;
 	}
 }
 
-void JSONParser::parseString(std::wstringstream* jsonStream, std::wstring** _value) {
+void JSONParser::parseString(std::string** _value) {
 	*_value = NULL;
 
-	std::wstring* result = new std::wstring;
-	jsonStream->ignore(1);
-	const wchar_t charBackslash = wchar_t('\\');
-	wchar_t charQuote = wchar_t('\"');
-	wchar_t currentChar = NULL;
-	jsonStream->read(&currentChar, 1);
-	while (currentChar != charQuote) {
-		if (jsonStream->eof()) {
-			Logger::error("JSON string has string value that does not end");
-			return;
-		}
-		if (currentChar == charBackslash) {
-			jsonStream->read(&currentChar, 1);
-			if (jsonStream->eof()) {
-				Logger::error("JSON string has string value that does not end");
-				return;
-			}
-			switch (currentChar) {
-				case wchar_t('\"'):
-				case wchar_t('/'):
-				case charBackslash: {
-					result->push_back(currentChar);
-					break;
-				}
-				case wchar_t('b'): {
-					result->push_back(wchar_t('\b'));
-					break;
-				}
-				case wchar_t('f'): {
-					result->push_back(wchar_t('\f'));
-					break;
-				}
-				case wchar_t('n'): {
-					result->push_back(wchar_t('\n'));
-					break;
-				}
-				case wchar_t('r'): {
-					result->push_back(wchar_t('\r'));
-					break;
-				}
-				case wchar_t('t'): {
-					result->push_back(wchar_t('\t'));
-					break;
-				}
-				case wchar_t('u'): {
-					Logger::log("FYI: unicode value encountered, not parsed, still //TODO");
-					// TODO
-					break;
-				}
-				default: {
-					Logger::error("JSON string has string value with an invalid escape sequence");
-					return;
-				}
-			}
-		} else {
-			result->push_back(currentChar);
-		}
-		jsonStream->read(&currentChar, 1);
+	const char* start = m_current + 1;
+	bool escaped;
+	if (!skipString(&escaped)) {
+		return;
 	}
 
+	std::string* result = new std::string;
+	if (escaped) {
+		decodeString(start, m_current - 1, result);
+	} else {
+		result->assign(start, m_current - 1 - start);
+	}
 	*_value = result;
 }
 
-void JSONParser::skipWhitespace(std::wstringstream* jsonStream) {
-	wchar_t current = jsonStream->peek();
-	while (current == wchar_t(' ') || current == wchar_t('\r') || current == wchar_t('\n') || current == wchar_t('\t')) {
-		jsonStream->ignore(1);
-		current = jsonStream->peek();
+/*
+ * Parses a string value or object key and reports it to the handler.  When
+ * parsing into a JSONDocument the string is only located, not decoded.
+ */
+bool JSONParser::parseStringToken(bool isKey) {
+	if (m_document) {
+		const char* start = m_current + 1;
+		bool escaped;
+		if (!skipString(&escaped)) {
+			return false;
+		}
+		return m_document->addString((unsigned int)(start - m_start), (unsigned int)(m_current - 1 - start), escaped, isKey);
+	}
+
+	std::string* stringValue = NULL;
+	parseString(&stringValue);
+	if (!stringValue) {
+		/* parseString() already logs a detailed error message, so no error logged here */
+		return false;
 	}
+	bool success = isKey ? m_handler->onKey(stringValue) : m_handler->onString(stringValue);
+	delete stringValue;
+	return success;
 }
 
-void JSONParser::stringify(Value* value, std::wstring** _jsonString) {
-	switch (value->getType()) {
-		case TYPE_NULL: {
-			std::wstring* result = new std::wstring;
-			result->assign(VALUE_NULL);
-			*_jsonString = result;
-			break;
+/*
+ * Moves past the string that starts at the current position, validating its
+ * escape sequences without decoding it.
+ */
+bool JSONParser::skipString(bool* _escaped) {
+	*_escaped = false;
+	m_current++;
+
+	if (m_indexed) {
+		/*
+		 * The index entry following the opening quote is the closing quote, so a
+		 * string without escapes does not need to be scanned here.
+		 */
+		const char* closingQuote = m_start + (*m_indexes)[m_nextIndex + 1];
+		if (!memchr(m_current, '\\', closingQuote - m_current)) {
+			m_current = closingQuote + 1;
+			return true;
 		}
-		case TYPE_BOOLEAN: {
-			std::wstring* result = new std::wstring;
-			result->assign(value->getBooleanValue() ? VALUE_TRUE : VALUE_FALSE);
-			*_jsonString = result;
-			break;
+	}
+
+	while (true) {
+		m_current = JSONStringScanner::findQuoteOrBackslash(m_current, m_end);
+		if (m_current == m_end) {
+			Logger::error("JSON string has string value that does not end");
+			return false;
 		}
-		case TYPE_NUMBER: {
-			std::wstring* result = new std::wstring;
-			std::wstringstream stringStream;
-			stringStream << value->getNumberValue();
-			result->assign(stringStream.str());
-			*_jsonString = result;
+		if (*m_current == '\"') {
 			break;
 		}
-		case TYPE_STRING: {
-			static const wchar_t char_quote('\"');
-			static const wchar_t char_backslash('\\');
-			static const wchar_t char_forwardslash('/');
-			static const wchar_t char_backspace('\b');
-			static const wchar_t char_formfeed('\f');
-			static const wchar_t char_newline('\n');
-			static const wchar_t char_cr('\r');
-			static const wchar_t char_tab('\t');
-
-			std::wstring* source = value->getStringValue();
-			size_t length = source->length();
-			wchar_t* chars = (wchar_t*)source->c_str();
-
-			std::wstringstream stringStream;
-			stringStream << char_quote;
-			for (size_t i = 0; i < length; i++) {
-				switch (chars[i]) {
-					case char_quote:
-					case char_backslash:
-					case char_forwardslash: {
-						stringStream << char_backslash;
-						stringStream << chars[i];
-						break;
-					}
-					case char_backspace: {
-						stringStream << "\\b";
-						break;
-					}
-					case char_formfeed: {
-						stringStream << "\\f";
-						break;
-					}
-					case char_newline: {
-						stringStream << "\\n";
-						break;
-					}
-					case char_cr: {
-						stringStream << "\\r";
-						break;
-					}
-  					case char_tab: {
-						stringStream << "\\t";
-						break;
-					}
-					default: {
-						stringStream << chars[i];
-						break;
-					}
-				}
-			}
-			stringStream << char_quote;
 
-			std::wstring* result = new std::wstring;
-			result->assign(stringStream.str());
-			*_jsonString = result;
-			break;
+		*_escaped = true;
+		if (++m_current == m_end) {
+			Logger::error("JSON string has string value that does not end");
+			return false;
 		}
-		case TYPE_ARRAY: {
-			Value** arrayValues = NULL;
-			value->getArrayValues(&arrayValues);
-			std::wstring* result = new std::wstring;
-			result->push_back(wchar_t('['));
-			int index = 0;
-			Value* currentValue = arrayValues[index];
-			while (currentValue) {
-				std::wstring* serializedValue = NULL;
-				stringify(currentValue, &serializedValue);
-				result->append(*serializedValue);
-				result->push_back(wchar_t(','));
-				delete serializedValue;
-				currentValue = arrayValues[++index];
+		switch (*m_current) {
+			case '\"':
+			case '/':
+			case '\\':
+			case 'b':
+			case 'f':
+			case 'n':
+			case 'r':
+			case 't': {
+				break;
 			}
-			delete[] arrayValues;
-
-			if (index > 0) {
-				result->erase(result->end() - 1);
+			case 'u': {
+				if (m_end - m_current <= 4 || decodeUnicodeEscape(m_current + 1) < 0) {
+					Logger::error("JSON string has string value with an invalid \\u escape sequence");
+					return false;
+				}
+				m_current += 4;
+				break;
 			}
-			result->push_back(wchar_t(']'));
-			*_jsonString = result;
-			break;
-		}
-		case TYPE_OBJECT: {
-			std::wstring** objectKeys = NULL;
-			Value** objectValues = NULL;
-			value->getObjectValues(&objectKeys, &objectValues);
-			std::wstring* result = new std::wstring;
-			result->push_back(wchar_t('{'));
-			int index = 0;
-			std::wstring* currentKey = objectKeys[index];
-			while (currentKey) {
-				result->push_back(wchar_t('\"'));
-				result->append(*currentKey);
-				result->push_back(wchar_t('\"'));
-				result->push_back(wchar_t(':'));
-				std::wstring* serializedValue = NULL;
-				stringify(objectValues[index], &serializedValue);
-				result->append(*serializedValue);
-				result->push_back(wchar_t(','));
-				delete serializedValue;
-				currentKey = objectKeys[++index];
+			default: {
+				Logger::error("JSON string has string value with an invalid escape sequence");
+				return false;
 			}
-			delete[] objectValues;
-			delete[] objectKeys;
+		}
+		m_current++;
+	}
+	m_current++; /* closing quote */
+	return true;
+}
 
-			if (index > 0) {
-				result->erase(result->end() - 1);
-			}
-			result->push_back(wchar_t('}'));
-			*_jsonString = result;
-			break;
+void JSONParser::skipWhitespace() {
+	if (m_indexed) {
+		/* only whitespace can precede the next structural character, so jump to it */
+		unsigned int offset = (unsigned int)(m_current - m_start);
+		size_t count = m_indexes->size();
+		while (m_nextIndex < count && (*m_indexes)[m_nextIndex] < offset) {
+			m_nextIndex++;
 		}
-		default: {
-			/* TYPE_UNDEFINED */
-			std::wstring* result = new std::wstring;
-			result->assign(VALUE_UNDEFINED);
-			*_jsonString = result;
-			break;
+		m_current = m_nextIndex < count ? m_start + (*m_indexes)[m_nextIndex] : m_end;
+		return;
+	}
+
+	while (m_current < m_end) {
+		char current = *m_current;
+		if (current != ' ' && current != '\r' && current != '\n' && current != '\t') {
+			return;
 		}
+		m_current++;
 	}
 }
@@ -12,30 +12,85 @@
 
 #pragma once
 
-#include <float.h>
+#include <vector>
 
+#include "IJSONHandler.h"
+#include "JSONStructuralIndex.h"
+#include "JSONValueBuilder.h"
+#include "NumberParser.h"
 #include "Value.h"
 #include "Logger.h"
 
+class JSONDocument; // forward declaration
+
 class JSONParser {
 
 public:
 	JSONParser();
 	~JSONParser();
-	void parse(std::wstring* jsonString, Value** _value);
-	void stringify(Value* value, std::wstring** _jsonString);
+	void beginPush();
+	void beginPush(IJSONHandler* handler);
+	bool endPush();
+	void endPush(Value** _value);
+	bool parse(const char* json, size_t length, IJSONHandler* handler);
+	bool parse(const char* json, size_t length, JSONDocument* document);
+	void parse(const char* json, size_t length, Value** _value);
+	void parse(std::string* jsonString, Value** _value);
+	bool push(const char* json, size_t length);
+
+	static void decodeString(const char* start, const char* end, std::string* target);
 
 private:
-	void parse(std::wstringstream* jsonStream, Value** _value);
-	void parseArray(std::wstringstream* jsonStream, Value** _value);
-	double parseNumber(std::wstringstream* jsonStream);
-	void parseObject(std::wstringstream* jsonStream, Value** _value);
-	void parseString(std::wstringstream* jsonStream, std::wstring** _value);
-	void skipWhitespace(std::wstringstream* jsonStream);
+	static void appendCodePoint(unsigned int codePoint, std::string* target);
+	bool completePushAtom();
+	bool completePushString();
+	void completePushValue();
+	static int decodeUnicodeEscape(const char* digits);
+	bool endPushContainer(int type);
+	bool isAtomEnd();
+	bool matchLiteral(const char* literal);
+	bool parseArray(int depth);
+	bool parseNumber(double* _value);
+	bool parseObject(int depth);
+	void parseString(std::string** _value);
+	bool parseStringToken(bool isKey);
+	bool parseValue(int depth);
+	bool skipString(bool* _escaped);
+	void skipWhitespace();
+
+	JSONValueBuilder* m_builder;
+	const char* m_current;
+	JSONDocument* m_document;
+	const char* m_end;
+	IJSONHandler* m_handler;
+	bool m_indexed;
+	std::vector<unsigned int>* m_indexes;
+	size_t m_nextIndex;
+	const char* m_start;
+	std::vector<int>* m_pushContainers;
+	int m_pushState;
+	bool m_pushStringIsKey;
+	std::string* m_pushToken;
 
 	/* constants */
-	static const wchar_t* VALUE_FALSE;
-	static const wchar_t* VALUE_NULL;
-	static const wchar_t* VALUE_TRUE;
-	static const wchar_t* VALUE_UNDEFINED;
+	static const size_t INDEX_THRESHOLD;
+	static const char* LITERAL_FALSE;
+	static const char* LITERAL_NULL;
+	static const char* LITERAL_TRUE;
+	static const size_t MAX_DEPTH;
+
+	/* push states */
+	enum {
+		PUSH_ATOM,
+		PUSH_COLON,
+		PUSH_DONE,
+		PUSH_ERROR,
+		PUSH_KEY,
+		PUSH_KEY_OR_END,
+		PUSH_SEPARATOR,
+		PUSH_STRING,
+		PUSH_STRING_ESCAPE,
+		PUSH_VALUE,
+		PUSH_VALUE_OR_END
+	};
 };
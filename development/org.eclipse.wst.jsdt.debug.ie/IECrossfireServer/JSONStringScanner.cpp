@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "JSONStringScanner.h"
+
+#include <intrin.h>
+#include <emmintrin.h>
+
+#include "JSONStructuralIndex.h"
+
+/* initialize statics */
+int JSONStringScanner::s_instructionSet = -1;
+
+JSONStringScanner::JSONStringScanner() {
+}
+
+JSONStringScanner::~JSONStringScanner() {
+}
+
+/*
+ * Returns the first byte from current on that must be escaped when it is
+ * written within a JSON string, which is '\"', '\\' or a control character,
+ * or end if there is none.  Bytes of multibyte UTF-8 sequences are written
+ * as they are.
+ */
+const char* JSONStringScanner::findCharacterToEscape(const char* current, const char* end) {
+	if (isSSE2Supported()) {
+		const __m128i quote = _mm_set1_epi8('\"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i lastControl = _mm_set1_epi8(0x1F);
+
+		while (end - current >= 16) {
+			__m128i chunk = _mm_loadu_si128((const __m128i*)current);
+
+			/* the unsigned minimum with 0x1F equals the byte only for control characters */
+			__m128i special = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+				_mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk));
+			unsigned long mask = (unsigned long)_mm_movemask_epi8(special);
+			if (mask) {
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+				return current + bit;
+			}
+			current += 16;
+		}
+	}
+
+	while (current < end) {
+		unsigned char c = (unsigned char)*current;
+		if (c < 0x20 || c == '\"' || c == '\\') {
+			return current;
+		}
+		current++;
+	}
+	return end;
+}
+
+/*
+ * Returns the first '\"' or '\\' from current on, or end if there is none.
+ */
+const char* JSONStringScanner::findQuoteOrBackslash(const char* current, const char* end) {
+	if (isSSE2Supported()) {
+		const __m128i quote = _mm_set1_epi8('\"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+
+		while (end - current >= 16) {
+			__m128i chunk = _mm_loadu_si128((const __m128i*)current);
+			unsigned long mask = (unsigned long)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+			if (mask) {
+				unsigned long bit;
+				_BitScanForward(&bit, mask);
+				return current + bit;
+			}
+			current += 16;
+		}
+	}
+
+	while (current < end) {
+		char c = *current;
+		if (c == '\"' || c == '\\') {
+			return current;
+		}
+		current++;
+	}
+	return end;
+}
+
+bool JSONStringScanner::isSSE2Supported() {
+	if (s_instructionSet < 0) {
+		s_instructionSet = JSONStructuralIndex::getInstructionSet();
+	}
+	return s_instructionSet != JSONStructuralIndex::ISA_SCALAR;
+}
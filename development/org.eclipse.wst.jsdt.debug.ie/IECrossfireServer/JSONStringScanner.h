@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+/*
+ * Scans the runs of plain characters within UTF-8 JSON strings 16 bytes at a
+ * time, so that JSONParser and JSONWriter only handle quotes, escapes and
+ * control characters one at a time.
+ */
+class JSONStringScanner {
+
+public:
+	static const char* findCharacterToEscape(const char* current, const char* end);
+	static const char* findQuoteOrBackslash(const char* current, const char* end);
+
+protected:
+	JSONStringScanner();
+	~JSONStringScanner();
+
+private:
+	static bool isSSE2Supported();
+
+	static int s_instructionSet;
+};
@@ -0,0 +1,269 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "JSONStructuralIndex.h"
+
+#include <intrin.h>
+#include <emmintrin.h>
+#ifdef JSON_AVX2_SUPPORTED
+#include <immintrin.h>
+#endif
+
+/* initialize statics */
+JSONStructuralIndex::Classifier JSONStructuralIndex::s_classifier = NULL;
+
+JSONStructuralIndex::JSONStructuralIndex() {
+}
+
+JSONStructuralIndex::~JSONStructuralIndex() {
+}
+
+bool JSONStructuralIndex::build(const char* json, size_t length, std::vector<unsigned int>* indexes) {
+	static const unsigned __int64 EVEN_BITS = 0x5555555555555555ULL;
+	static const unsigned __int64 ODD_BITS = ~EVEN_BITS;
+
+	indexes->clear();
+	Classifier classify = getClassifier();
+
+	unsigned __int64 prevEndsOddBackslash = 0;
+	unsigned __int64 prevInString = 0;
+	unsigned __int64 prevEndsSeparator = 1; /* the start of the content separates like whitespace */
+	char lastBlock[BLOCK_LENGTH];
+
+	for (size_t offset = 0; offset < length; offset += BLOCK_LENGTH) {
+		const char* block = json + offset;
+		if (length - offset < BLOCK_LENGTH) {
+			/* pad the final partial block with whitespace, which never produces a structural */
+			memset(lastBlock, ' ', BLOCK_LENGTH);
+			memcpy(lastBlock, block, length - offset);
+			block = lastBlock;
+		}
+
+		BlockMasks masks;
+		classify(block, &masks);
+
+		/*
+		 * A character is escaped if it follows an odd-length run of backslashes.  Find
+		 * the ends of such runs by adding each run's start bit to the run, which carries
+		 * through to the first character after it, and then checking the parity of the
+		 * carry's position relative to where the run started.
+		 */
+		unsigned __int64 backslash = masks.backslash;
+		unsigned __int64 startEdges = backslash & ~(backslash << 1);
+		unsigned __int64 evenStartMask = EVEN_BITS ^ prevEndsOddBackslash;
+		unsigned __int64 evenStarts = startEdges & evenStartMask;
+		unsigned __int64 oddStarts = startEdges & ~evenStartMask;
+		unsigned __int64 evenCarries = backslash + evenStarts;
+		unsigned __int64 oddCarries = backslash + oddStarts;
+		bool endsOddBackslash = oddCarries < backslash; /* the run continues into the next block */
+		oddCarries |= prevEndsOddBackslash;
+		prevEndsOddBackslash = endsOddBackslash ? 1 : 0;
+		unsigned __int64 evenStartOddEnd = evenCarries & ~backslash & ODD_BITS;
+		unsigned __int64 oddStartEvenEnd = oddCarries & ~backslash & EVEN_BITS;
+		unsigned __int64 escaped = evenStartOddEnd | oddStartEvenEnd;
+
+		/* the bits between each opening quote and its closing quote are within a string */
+		unsigned __int64 quotes = masks.quote & ~escaped;
+		unsigned __int64 inString = prefixXor(quotes) ^ prevInString;
+		prevInString = (inString >> 63) ? ~0ULL : 0;
+
+		/*
+		 * Every value that is not an object, array or string (ie.- a number or literal)
+		 * starts with a character that follows whitespace or a structural character.
+		 */
+		unsigned __int64 separators = masks.op | masks.whitespace | quotes;
+		unsigned __int64 followsSeparator = (separators << 1) | prevEndsSeparator;
+		prevEndsSeparator = separators >> 63;
+		unsigned __int64 valueStarts = followsSeparator & ~separators & ~inString;
+
+		unsigned __int64 structurals = (masks.op & ~inString) | quotes | valueStarts;
+		flatten(structurals, (unsigned int)offset, indexes);
+	}
+
+	/* content that ends within a string is not valid */
+	return prevInString == 0;
+}
+
+void JSONStructuralIndex::classifyScalar(const char* block, BlockMasks* masks) {
+	masks->backslash = masks->op = masks->quote = masks->whitespace = 0;
+	for (size_t i = 0; i < BLOCK_LENGTH; i++) {
+		unsigned __int64 bit = 1ULL << i;
+		switch (block[i]) {
+			case '\\': {
+				masks->backslash |= bit;
+				break;
+			}
+			case '\"': {
+				masks->quote |= bit;
+				break;
+			}
+			case '{':
+			case '}':
+			case '[':
+			case ']':
+			case ':':
+			case ',': {
+				masks->op |= bit;
+				break;
+			}
+			case ' ':
+			case '\t':
+			case '\n':
+			case '\r': {
+				masks->whitespace |= bit;
+				break;
+			}
+		}
+	}
+}
+
+void JSONStructuralIndex::classifySSE2(const char* block, BlockMasks* masks) {
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i quote = _mm_set1_epi8('\"');
+	const __m128i lowerCase = _mm_set1_epi8(0x20);
+	const __m128i openBrace = _mm_set1_epi8('{');	/* '[' | 0x20 */
+	const __m128i closeBrace = _mm_set1_epi8('}');	/* ']' | 0x20 */
+	const __m128i colon = _mm_set1_epi8(':');
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i cr = _mm_set1_epi8('\r');
+
+	masks->backslash = masks->op = masks->quote = masks->whitespace = 0;
+	for (int i = 0; i < 4; i++) {
+		__m128i chunk = _mm_loadu_si128((const __m128i*)(block + 16 * i));
+		__m128i folded = _mm_or_si128(chunk, lowerCase);
+		__m128i op = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, colon), _mm_cmpeq_epi8(chunk, comma)));
+		__m128i whitespace = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+			_mm_or_si128(_mm_cmpeq_epi8(chunk, newline), _mm_cmpeq_epi8(chunk, cr)));
+
+		int shift = 16 * i;
+		masks->backslash |= (unsigned __int64)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, backslash)) << shift;
+		masks->quote |= (unsigned __int64)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, quote)) << shift;
+		masks->op |= (unsigned __int64)(unsigned int)_mm_movemask_epi8(op) << shift;
+		masks->whitespace |= (unsigned __int64)(unsigned int)_mm_movemask_epi8(whitespace) << shift;
+	}
+}
+
+#ifdef JSON_AVX2_SUPPORTED
+void JSONStructuralIndex::classifyAVX2(const char* block, BlockMasks* masks) {
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i quote = _mm256_set1_epi8('\"');
+	const __m256i lowerCase = _mm256_set1_epi8(0x20);
+	const __m256i openBrace = _mm256_set1_epi8('{');	/* '[' | 0x20 */
+	const __m256i closeBrace = _mm256_set1_epi8('}');	/* ']' | 0x20 */
+	const __m256i colon = _mm256_set1_epi8(':');
+	const __m256i comma = _mm256_set1_epi8(',');
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i newline = _mm256_set1_epi8('\n');
+	const __m256i cr = _mm256_set1_epi8('\r');
+
+	masks->backslash = masks->op = masks->quote = masks->whitespace = 0;
+	for (int i = 0; i < 2; i++) {
+		__m256i chunk = _mm256_loadu_si256((const __m256i*)(block + 32 * i));
+		__m256i folded = _mm256_or_si256(chunk, lowerCase);
+		__m256i op = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, colon), _mm256_cmpeq_epi8(chunk, comma)));
+		__m256i whitespace = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), _mm256_cmpeq_epi8(chunk, tab)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(chunk, newline), _mm256_cmpeq_epi8(chunk, cr)));
+
+		int shift = 32 * i;
+		masks->backslash |= (unsigned __int64)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, backslash)) << shift;
+		masks->quote |= (unsigned __int64)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, quote)) << shift;
+		masks->op |= (unsigned __int64)(unsigned int)_mm256_movemask_epi8(op) << shift;
+		masks->whitespace |= (unsigned __int64)(unsigned int)_mm256_movemask_epi8(whitespace) << shift;
+	}
+}
+#endif
+
+void JSONStructuralIndex::flatten(unsigned __int64 bits, unsigned int offset, std::vector<unsigned int>* indexes) {
+	/* scan the 32-bit halves separately since _BitScanForward64() is not available on x86 */
+	unsigned long low = (unsigned long)(bits & 0xFFFFFFFF);
+	unsigned long high = (unsigned long)(bits >> 32);
+	unsigned long index;
+	while (_BitScanForward(&index, low)) {
+		indexes->push_back(offset + index);
+		low &= low - 1;
+	}
+	while (_BitScanForward(&index, high)) {
+		indexes->push_back(offset + 32 + index);
+		high &= high - 1;
+	}
+}
+
+JSONStructuralIndex::Classifier JSONStructuralIndex::getClassifier() {
+	if (!s_classifier) {
+		switch (getInstructionSet()) {
+#ifdef JSON_AVX2_SUPPORTED
+			case ISA_AVX2: {
+				s_classifier = classifyAVX2;
+				break;
+			}
+#endif
+			case ISA_SSE2: {
+				s_classifier = classifySSE2;
+				break;
+			}
+			default: {
+				s_classifier = classifyScalar;
+				break;
+			}
+		}
+	}
+	return s_classifier;
+}
+
+int JSONStructuralIndex::getInstructionSet() {
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+	if (maxLeaf < 1) {
+		return ISA_SCALAR;
+	}
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+
+	/* only report AVX2 if its classifier was compiled, so that the result always has a classifier */
+#ifdef JSON_AVX2_SUPPORTED
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	if (maxLeaf >= 7 && osxsave) {
+		/* the OS must also preserve the ymm registers across context switches */
+		bool ymmEnabled = (_xgetbv(0) & 0x6) == 0x6;
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		if (ymmEnabled && avx2) {
+			return ISA_AVX2;
+		}
+	}
+#endif
+	return sse2 ? ISA_SSE2 : ISA_SCALAR;
+}
+
+unsigned __int64 JSONStructuralIndex::prefixXor(unsigned __int64 bits) {
+	/* each bit becomes the xor of itself and all lower bits */
+	bits ^= bits << 1;
+	bits ^= bits << 2;
+	bits ^= bits << 4;
+	bits ^= bits << 8;
+	bits ^= bits << 16;
+	bits ^= bits << 32;
+	return bits;
+}
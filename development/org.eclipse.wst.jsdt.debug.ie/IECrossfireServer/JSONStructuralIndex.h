@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+/* AVX2 intrinsics are only available from Visual Studio 2012 on */
+#if defined(_MSC_VER) && _MSC_VER >= 1700
+#define JSON_AVX2_SUPPORTED
+#endif
+
+/*
+ * Locates the structural characters of UTF-8 encoded JSON content 64 bytes at a
+ * time: the start of every value, the opening and closing quotes of every string,
+ * and every '{', '}', '[', ']', ':' and ',' that is not within a string.  Escaped
+ * quotes and characters within strings are excluded.  The resulting offsets allow
+ * JSONParser to move from token to token without examining the bytes in between.
+ */
+class JSONStructuralIndex {
+
+public:
+	static bool build(const char* json, size_t length, std::vector<unsigned int>* indexes);
+	static int getInstructionSet();
+
+	enum {
+		ISA_SCALAR,
+		ISA_SSE2,
+		ISA_AVX2
+	};
+
+protected:
+	JSONStructuralIndex();
+	~JSONStructuralIndex();
+
+private:
+	struct BlockMasks {
+		unsigned __int64 backslash;
+		unsigned __int64 op;
+		unsigned __int64 quote;
+		unsigned __int64 whitespace;
+	};
+	typedef void (*Classifier)(const char* block, BlockMasks* masks);
+
+	static void classifyScalar(const char* block, BlockMasks* masks);
+	static void classifySSE2(const char* block, BlockMasks* masks);
+#ifdef JSON_AVX2_SUPPORTED
+	static void classifyAVX2(const char* block, BlockMasks* masks);
+#endif
+	static void flatten(unsigned __int64 bits, unsigned int offset, std::vector<unsigned int>* indexes);
+	static Classifier getClassifier();
+	static unsigned __int64 prefixXor(unsigned __int64 bits);
+
+	static Classifier s_classifier;
+
+	/* constants */
+	static const size_t BLOCK_LENGTH = 64;
+};
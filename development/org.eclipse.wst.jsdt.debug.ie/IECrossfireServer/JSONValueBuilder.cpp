@@ -0,0 +1,138 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+
+#include "StdAfx.h"
+#include "JSONValueBuilder.h"
+
+JSONValueBuilder::JSONValueBuilder() {
+	m_result = NULL;
+	m_stack = new std::vector<Frame>;
+}
+
+JSONValueBuilder::~JSONValueBuilder() {
+	clear();
+	delete m_stack;
+}
+
+bool JSONValueBuilder::addValue(Value* value) {
+	if (m_stack->empty()) {
+		if (m_result) {
+			delete m_result;
+		}
+		m_result = value;
+		return true;
+	}
+
+	Frame* frame = &m_stack->back();
+	if (frame->container->getType() == TYPE_ARRAY) {
+		frame->container->adoptArrayValue(value);
+		return true;
+	}
+
+	bool success = false;
+	if (frame->key) {
+		success = frame->container->adoptObjectValue(frame->key, value);
+	} else {
+		delete value;
+	}
+	delete frame->key;
+	frame->key = NULL;
+	if (!success) {
+		Logger::error("JSON string has an object with a duplicate key");
+		return false;
+	}
+	return true;
+}
+
+void JSONValueBuilder::clear() {
+	std::vector<Frame>::iterator iterator = m_stack->begin();
+	while (iterator != m_stack->end()) {
+		delete (*iterator).container;
+		delete (*iterator).key;
+		iterator++;
+	}
+	m_stack->clear();
+	if (m_result) {
+		delete m_result;
+		m_result = NULL;
+	}
+}
+
+bool JSONValueBuilder::endContainer() {
+	Value* container = m_stack->back().container;
+	delete m_stack->back().key;
+	m_stack->pop_back();
+	return addValue(container);
+}
+
+/*
+ * Transfers the most recently completed top-level value to the caller, or
+ * provides NULL if there is not one.
+ */
+void JSONValueBuilder::getValue(Value** _value) {
+	*_value = NULL;
+	if (m_stack->empty()) {
+		*_value = m_result;
+		m_result = NULL;
+	}
+}
+
+bool JSONValueBuilder::onBoolean(bool value) {
+	return addValue(new Value(value));
+}
+
+bool JSONValueBuilder::onEndArray() {
+	return endContainer();
+}
+
+bool JSONValueBuilder::onEndObject() {
+	return endContainer();
+}
+
+bool JSONValueBuilder::onKey(std::string* key) {
+	Frame* frame = &m_stack->back();
+	delete frame->key;
+	frame->key = new std::string(*key);
+	return true;
+}
+
+bool JSONValueBuilder::onNull() {
+	Value* value = new Value();
+	value->setType(TYPE_NULL);
+	return addValue(value);
+}
+
+bool JSONValueBuilder::onNumber(double value) {
+	return addValue(new Value(value));
+}
+
+bool JSONValueBuilder::onStartArray() {
+	return startContainer(TYPE_ARRAY);
+}
+
+bool JSONValueBuilder::onStartObject() {
+	return startContainer(TYPE_OBJECT);
+}
+
+bool JSONValueBuilder::onString(std::string* value) {
+	return addValue(new Value(value));
+}
+
+bool JSONValueBuilder::startContainer(int type) {
+	Frame frame;
+	frame.container = new Value();
+	frame.container->setType(type);
+	frame.key = NULL;
+	m_stack->push_back(frame);
+	return true;
+}
@@ -0,0 +1,56 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+
+#pragma once
+
+#include <vector>
+
+#include "IJSONHandler.h"
+#include "Value.h"
+#include "Logger.h"
+
+/*
+ * Builds a Value from the content reported by JSONParser.
+ */
+class JSONValueBuilder : public IJSONHandler {
+
+public:
+	JSONValueBuilder();
+	virtual ~JSONValueBuilder();
+	void clear();
+	void getValue(Value** _value);
+
+	/* IJSONHandler */
+	virtual bool onBoolean(bool value);
+	virtual bool onEndArray();
+	virtual bool onEndObject();
+	virtual bool onKey(std::string* key);
+	virtual bool onNull();
+	virtual bool onNumber(double value);
+	virtual bool onStartArray();
+	virtual bool onStartObject();
+	virtual bool onString(std::string* value);
+
+private:
+	struct Frame {
+		Value* container;
+		std::string* key;
+	};
+
+	bool addValue(Value* value);
+	bool endContainer();
+	bool startContainer(int type);
+
+	Value* m_result;
+	std::vector<Frame>* m_stack;
+};
@@ -0,0 +1,216 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "JSONWriter.h"
+
+#include "JSONStringScanner.h"
+#include "NumberFormatter.h"
+
+/* initialize constants */
+const char* JSONWriter::HEX_DIGITS = "0123456789abcdef";
+const char* JSONWriter::VALUE_FALSE = "false";
+const char* JSONWriter::VALUE_NULL = "null";
+const char* JSONWriter::VALUE_TRUE = "true";
+const char* JSONWriter::VALUE_UNDEFINED = "\"undefined\"";
+
+JSONWriter::JSONWriter() : PacketWriter() {
+	m_needsSeparator = false;
+}
+
+JSONWriter::~JSONWriter() {
+}
+
+void JSONWriter::beginObject() {
+	writeSeparator();
+	m_buffer->push_back('{');
+	m_needsSeparator = false;
+}
+
+void JSONWriter::clear() {
+	PacketWriter::clear();
+	m_needsSeparator = false;
+}
+
+void JSONWriter::endObject() {
+	m_buffer->push_back('}');
+	m_needsSeparator = true;
+}
+
+void JSONWriter::write(Value* value) {
+	switch (value->getType()) {
+		case TYPE_NULL: {
+			writeNull();
+			break;
+		}
+		case TYPE_BOOLEAN: {
+			writeBoolean(value->getBooleanValue());
+			break;
+		}
+		case TYPE_NUMBER: {
+			writeNumber(value->getNumberValue());
+			break;
+		}
+		case TYPE_STRING: {
+			writeString(value->getStringValue(), value->getStringLength());
+			break;
+		}
+		case TYPE_ARRAY: {
+			writeSeparator();
+			m_buffer->push_back('[');
+			m_needsSeparator = false;
+			size_t size = value->getArraySize();
+			for (size_t index = 0; index < size; index++) {
+				write(value->peekArrayValueAt(index));
+			}
+			m_buffer->push_back(']');
+			m_needsSeparator = true;
+			break;
+		}
+		case TYPE_OBJECT: {
+			beginObject();
+			size_t size = value->getObjectSize();
+			for (size_t index = 0; index < size; index++) {
+				const std::string* key = value->getObjectKeyAt(index);
+				writeQuoted(key->c_str(), key->length());
+				m_buffer->push_back(':');
+				m_needsSeparator = false;
+				beginMember(key);
+				write(value->peekObjectValueAt(index));
+				endMember();
+			}
+			endObject();
+			break;
+		}
+		default: {
+			/* TYPE_UNDEFINED */
+			writeSeparator();
+			m_buffer->append(VALUE_UNDEFINED);
+			m_needsSeparator = true;
+			break;
+		}
+	}
+}
+
+void JSONWriter::writeBoolean(bool value) {
+	writeSeparator();
+	m_buffer->append(value ? VALUE_TRUE : VALUE_FALSE);
+	m_needsSeparator = true;
+}
+
+void JSONWriter::writeKey(ValueAtom* key) {
+	writeQuoted(key->getChars(), key->getLength());
+	m_buffer->push_back(':');
+	m_needsSeparator = false;
+	setMember(key);
+}
+
+void JSONWriter::writeNull() {
+	writeSeparator();
+	m_buffer->append(VALUE_NULL);
+	m_needsSeparator = true;
+}
+
+void JSONWriter::writeNumber(double value) {
+	writeSeparator();
+	char chars[NumberFormatter::MAX_LENGTH];
+	m_buffer->append(chars, NumberFormatter::format(value, chars));
+	m_needsSeparator = true;
+}
+
+/*
+ * Writes a UTF-8 string.  Runs of characters that do not need to be escaped,
+ * including all non-ASCII characters, are copied into the buffer in bulk.
+ */
+void JSONWriter::writeQuoted(const char* chars, size_t length) {
+	writeSeparator();
+
+	m_buffer->push_back('\"');
+	const char* current = chars;
+	const char* end = chars + length;
+	while (true) {
+		const char* next = JSONStringScanner::findCharacterToEscape(current, end);
+		m_buffer->append(current, next - current);
+		if (next == end) {
+			break;
+		}
+
+		char c = *next;
+		switch (c) {
+			case '\"':
+			case '\\': {
+				m_buffer->push_back('\\');
+				m_buffer->push_back(c);
+				break;
+			}
+			case '\b': {
+				m_buffer->append("\\b", 2);
+				break;
+			}
+			case '\f': {
+				m_buffer->append("\\f", 2);
+				break;
+			}
+			case '\n': {
+				m_buffer->append("\\n", 2);
+				break;
+			}
+			case '\r': {
+				m_buffer->append("\\r", 2);
+				break;
+			}
+			case '\t': {
+				m_buffer->append("\\t", 2);
+				break;
+			}
+			default: {
+				/* other control characters */
+				writeUnicodeEscape((unsigned char)c);
+				break;
+			}
+		}
+		current = next + 1;
+	}
+	m_buffer->push_back('\"');
+	m_needsSeparator = true;
+}
+
+void JSONWriter::writeSeparator() {
+	if (m_needsSeparator) {
+		m_buffer->push_back(',');
+	}
+}
+
+void JSONWriter::writeString(const char* value) {
+	writeString(value, strlen(value));
+}
+
+void JSONWriter::writeString(std::string* value) {
+	writeString(value->c_str(), value->length());
+}
+
+void JSONWriter::writeString(const char* chars, size_t length) {
+	unsigned int id = 0;
+	if (findStringId(chars, length, &id)) {
+		writeNumber((double)id);
+		return;
+	}
+	writeQuoted(chars, length);
+}
+
+void JSONWriter::writeUnicodeEscape(unsigned int unit) {
+	char escape[6] = {'\\', 'u'};
+	for (int i = 0; i < 4; i++) {
+		escape[2 + i] = HEX_DIGITS[(unit >> (12 - 4 * i)) & 0xF];
+	}
+	m_buffer->append(escape, 6);
+}
@@ -0,0 +1,53 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+#include "PacketWriter.h"
+#include "Value.h"
+
+/*
+ * Writes packet content as UTF-8 JSON.
+ */
+class JSONWriter : public PacketWriter {
+
+public:
+	JSONWriter();
+	virtual ~JSONWriter();
+	virtual void beginObject();
+	virtual void clear();
+	virtual void endObject();
+	virtual void write(Value* value);
+	virtual void writeBoolean(bool value);
+	virtual void writeKey(ValueAtom* key);
+	virtual void writeNull();
+	virtual void writeNumber(double value);
+	virtual void writeString(const char* value);
+	virtual void writeString(std::string* value);
+	virtual void writeString(const char* chars, size_t length);
+
+private:
+	void writeQuoted(const char* chars, size_t length);
+	void writeSeparator();
+	void writeUnicodeEscape(unsigned int unit);
+
+	bool m_needsSeparator;
+
+	/* constants */
+	static const char* HEX_DIGITS;
+	static const char* VALUE_FALSE;
+	static const char* VALUE_NULL;
+	static const char* VALUE_TRUE;
+	static const char* VALUE_UNDEFINED;
+};
@@ -13,6 +13,8 @@
 #include "StdAfx.h"
 #include "Logger.h"
 
+#include "UTF8Transcoder.h"
+
 /* initialize constants */
 const char* Logger::PREAMBLE_LOG = "LOG::";
 const char* Logger::PREAMBLE_ERROR = "ERROR::";
@@ -62,12 +64,9 @@ void Logger::log(char* message, int code) {
 }
 
 void Logger::log(wchar_t* message) {
-	size_t newSize = 0;
-	wcstombs_s(&newSize, NULL, 0, message, 0);
-    char* chars = new char[newSize];
-    wcstombs_s(&newSize, chars, newSize, message, newSize);
-	log(chars);
-	delete[] chars;
+	std::string chars;
+	UTF8Transcoder::toUTF8(message, &chars);
+	log((char*)chars.c_str());
 }
 
 void Logger::log(std::wstring* message) {
@@ -0,0 +1,336 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "NumberFormatter.h"
+
+#include <float.h>
+
+/* initialize constants */
+
+/* the binary exponents of CACHED_POWERS_F */
+const int NumberFormatter::CACHED_POWERS_E[] = {
+	-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+	-901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+	-582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+	-263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+	56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+	375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+	694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+	1013, 1039, 1066
+};
+
+/* 10^k normalized to a 64-bit significand, for k = -348, -340, ..., 340 */
+const unsigned __int64 NumberFormatter::CACHED_POWERS_F[] = {
+	0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76, 0xcf42894a5dce35ea,
+	0x9a6bb0aa55653b2d, 0xe61acf033d1a45df, 0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f,
+	0xbe5691ef416bd60c, 0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+	0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57, 0xc21094364dfb5637,
+	0x9096ea6f3848984f, 0xd77485cb25823ac7, 0xa086cfcd97bf97f4, 0xef340a98172aace5,
+	0xb23867fb2a35b28e, 0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+	0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126, 0xb5b5ada8aaff80b8,
+	0x87625f056c7c4a8b, 0xc9bcff6034c13053, 0x964e858c91ba2655, 0xdff9772470297ebd,
+	0xa6dfbd9fb8e5b88f, 0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+	0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06, 0xaa242499697392d3,
+	0xfd87b5f28300ca0e, 0xbce5086492111aeb, 0x8cbccc096f5088cc, 0xd1b71758e219652c,
+	0x9c40000000000000, 0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+	0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068, 0x9f4f2726179a2245,
+	0xed63a231d4c4fb27, 0xb0de65388cc8ada8, 0x83c7088e1aab65db, 0xc45d1df942711d9a,
+	0x924d692ca61be758, 0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+	0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d, 0x952ab45cfa97a0b3,
+	0xde469fbd99a05fe3, 0xa59bc234db398c25, 0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece,
+	0x88fcf317f22241e2, 0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+	0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410, 0x8bab8eefb6409c1a,
+	0xd01fef10a657842c, 0x9b10a4e5e9913129, 0xe7109bfba19c0c9d, 0xac2820d9623bf429,
+	0x80444b5e7aa7cf85, 0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+	0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b
+};
+
+const unsigned int NumberFormatter::POWERS_OF_TEN[] = {
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+/*
+ * Writes value into buffer, which must have room for at least MAX_LENGTH
+ * characters, and returns the number of characters written.  The result is not
+ * terminated.  NaN and the infinities have no JSON representation, so they are
+ * written as null, as JSON.stringify() does.
+ */
+size_t NumberFormatter::format(double value, char* buffer) {
+	if (!_finite(value)) {
+		memcpy(buffer, "null", 4);
+		return 4;
+	}
+	if (value == 0) {
+		/* includes -0 */
+		buffer[0] = '0';
+		return 1;
+	}
+
+	size_t offset = 0;
+	if (value < 0) {
+		buffer[offset++] = '-';
+		value = -value;
+	}
+
+	/* integral values below 2^53 are exact, and are written without the Grisu2 pass */
+	if (value < 9007199254740992.0 && value == (double)(unsigned __int64)value) {
+		return offset + writeInteger((unsigned __int64)value, buffer + offset);
+	}
+
+	int length = 0;
+	int k = 0;
+	grisu2(value, buffer + offset, &length, &k);
+	return offset + prettify(buffer + offset, length, k);
+}
+
+/*
+ * Generates the digits of w, stopping as soon as the digits generated so far
+ * identify a value within delta of the upper boundary mp.
+ */
+void NumberFormatter::digitGen(DiyFp* w, DiyFp* mp, unsigned __int64 delta, char* buffer, int* _length, int* _k) {
+	int shift = -mp->e;
+	unsigned __int64 one = (unsigned __int64)1 << shift;
+	unsigned __int64 distance = mp->f - w->f;
+	unsigned int p1 = (unsigned int)(mp->f >> shift);
+	unsigned __int64 p2 = mp->f & (one - 1);
+
+	int kappa = 1;
+	while (kappa < 10 && POWERS_OF_TEN[kappa] <= p1) {
+		kappa++;
+	}
+
+	int length = 0;
+	while (kappa > 0) {
+		unsigned int divisor = POWERS_OF_TEN[kappa - 1];
+		unsigned int digit = p1 / divisor;
+		p1 %= divisor;
+		if (digit || length) {
+			buffer[length++] = (char)('0' + digit);
+		}
+		kappa--;
+		unsigned __int64 rest = ((unsigned __int64)p1 << shift) + p2;
+		if (rest <= delta) {
+			*_k += kappa;
+			round(buffer, length, delta, rest, (unsigned __int64)POWERS_OF_TEN[kappa] << shift, distance);
+			*_length = length;
+			return;
+		}
+	}
+
+	while (true) {
+		p2 *= 10;
+		delta *= 10;
+		distance *= 10;
+		unsigned int digit = (unsigned int)(p2 >> shift);
+		if (digit || length) {
+			buffer[length++] = (char)('0' + digit);
+		}
+		p2 &= one - 1;
+		kappa--;
+		if (p2 < delta) {
+			*_k += kappa;
+			round(buffer, length, delta, p2, one, distance);
+			*_length = length;
+			return;
+		}
+	}
+}
+
+/*
+ * Decomposes value into its significand and exponent, and computes the
+ * boundaries halfway to its neighbouring doubles, normalized to a common exponent.
+ */
+void NumberFormatter::getBoundaries(double value, DiyFp* _value, DiyFp* _minus, DiyFp* _plus) {
+	static const unsigned __int64 HIDDEN_BIT = (unsigned __int64)1 << 52;
+	unsigned __int64 bits = 0;
+	memcpy(&bits, &value, sizeof(bits));
+	int biasedExponent = (int)((bits >> 52) & 0x7FF);
+	unsigned __int64 significand = bits & (HIDDEN_BIT - 1);
+
+	DiyFp v;
+	if (biasedExponent) {
+		v.f = significand + HIDDEN_BIT;
+		v.e = biasedExponent - 1075;
+	} else {
+		/* subnormal */
+		v.f = significand;
+		v.e = -1074;
+	}
+
+	DiyFp plus;
+	plus.f = (v.f << 1) + 1;
+	plus.e = v.e - 1;
+	while (!(plus.f & (HIDDEN_BIT << 1))) {
+		plus.f <<= 1;
+		plus.e--;
+	}
+	plus.f <<= 10;
+	plus.e -= 10;
+
+	/* the lower boundary is closer when value is a power of two */
+	DiyFp minus;
+	if (v.f == HIDDEN_BIT) {
+		minus.f = (v.f << 2) - 1;
+		minus.e = v.e - 2;
+	} else {
+		minus.f = (v.f << 1) - 1;
+		minus.e = v.e - 1;
+	}
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+
+	while (!(v.f & ((unsigned __int64)1 << 63))) {
+		v.f <<= 1;
+		v.e--;
+	}
+
+	*_value = v;
+	*_minus = minus;
+	*_plus = plus;
+}
+
+/*
+ * Finds the cached power of ten that brings a significand with binary exponent
+ * e into the range in which digitGen() can work with 32-bit integer parts.
+ */
+void NumberFormatter::getCachedPower(int e, DiyFp* _value, int* _k) {
+	double dk = (-61 - e) * 0.30102999566398114 + 347;
+	int k = (int)dk;
+	if (dk - k > 0) {
+		k++;
+	}
+	unsigned int index = (unsigned int)((k >> 3) + 1);
+	*_k = -(CACHED_POWERS_MIN_EXPONENT + (int)index * 8);
+	_value->f = CACHED_POWERS_F[index];
+	_value->e = CACHED_POWERS_E[index];
+}
+
+/*
+ * Writes the shortest digits of a positive finite value into buffer, such that
+ * value is approximately digits * 10^k.
+ */
+void NumberFormatter::grisu2(double value, char* buffer, int* _length, int* _k) {
+	DiyFp v, minus, plus;
+	getBoundaries(value, &v, &minus, &plus);
+
+	DiyFp cachedPower;
+	getCachedPower(plus.e, &cachedPower, _k);
+
+	DiyFp w = multiply(&v, &cachedPower);
+	DiyFp wPlus = multiply(&plus, &cachedPower);
+	DiyFp wMinus = multiply(&minus, &cachedPower);
+
+	/* the products are imprecise by one unit, so stay safely within the boundaries */
+	wMinus.f++;
+	wPlus.f--;
+	digitGen(&w, &wPlus, wPlus.f - wMinus.f, buffer, _length, _k);
+}
+
+/*
+ * Returns the upper 64 bits of the product of the significands, rounded.
+ */
+NumberFormatter::DiyFp NumberFormatter::multiply(DiyFp* x, DiyFp* y) {
+	static const unsigned __int64 MASK_32 = 0xFFFFFFFF;
+	unsigned __int64 a = x->f >> 32;
+	unsigned __int64 b = x->f & MASK_32;
+	unsigned __int64 c = y->f >> 32;
+	unsigned __int64 d = y->f & MASK_32;
+	unsigned __int64 ac = a * c;
+	unsigned __int64 bc = b * c;
+	unsigned __int64 ad = a * d;
+	unsigned __int64 bd = b * d;
+	unsigned __int64 middle = (bd >> 32) + (ad & MASK_32) + (bc & MASK_32);
+	middle += (unsigned __int64)1 << 31;
+
+	DiyFp result;
+	result.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+	result.e = x->e + y->e + 64;
+	return result;
+}
+
+/*
+ * Lays out the digits representing digits * 10^k as JavaScript would, using
+ * exponential notation only for values below 1e-6 or from 1e21.
+ */
+size_t NumberFormatter::prettify(char* buffer, int length, int k) {
+	/* 10^(exponent - 1) <= value < 10^exponent */
+	int exponent = length + k;
+
+	if (0 <= k && exponent <= 21) {
+		/* integral, 1234e7 -> 12340000000 */
+		memset(buffer + length, '0', k);
+		return exponent;
+	}
+	if (0 < exponent && exponent <= 21) {
+		/* 1234e-2 -> 12.34 */
+		memmove(buffer + exponent + 1, buffer + exponent, length - exponent);
+		buffer[exponent] = '.';
+		return length + 1;
+	}
+	if (-6 < exponent && exponent <= 0) {
+		/* 1234e-6 -> 0.001234 */
+		int offset = 2 - exponent;
+		memmove(buffer + offset, buffer, length);
+		buffer[0] = '0';
+		buffer[1] = '.';
+		memset(buffer + 2, '0', offset - 2);
+		return length + offset;
+	}
+	if (length == 1) {
+		/* 1e30 */
+		buffer[1] = 'e';
+		return 2 + writeExponent(exponent - 1, buffer + 2);
+	}
+
+	/* 1234e30 -> 1.234e33 */
+	memmove(buffer + 2, buffer + 1, length - 1);
+	buffer[1] = '.';
+	buffer[length + 1] = 'e';
+	return length + 2 + writeExponent(exponent - 1, buffer + length + 2);
+}
+
+/*
+ * Moves the last digit towards w while the result stays within the boundaries,
+ * to find the candidate closest to the actual value.
+ */
+void NumberFormatter::round(char* buffer, int length, unsigned __int64 delta, unsigned __int64 rest, unsigned __int64 tenKappa, unsigned __int64 distance) {
+	while (rest < distance && delta - rest >= tenKappa && (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance)) {
+		buffer[length - 1]--;
+		rest += tenKappa;
+	}
+}
+
+size_t NumberFormatter::writeExponent(int exponent, char* buffer) {
+	size_t offset = 0;
+	if (exponent < 0) {
+		buffer[offset++] = '-';
+		exponent = -exponent;
+	} else {
+		buffer[offset++] = '+';
+	}
+	return offset + writeInteger((unsigned __int64)exponent, buffer + offset);
+}
+
+size_t NumberFormatter::writeInteger(unsigned __int64 value, char* buffer) {
+	char digits[20];
+	size_t count = 0;
+	do {
+		digits[count++] = (char)('0' + (unsigned int)(value % 10));
+		value /= 10;
+	} while (value);
+
+	for (size_t i = 0; i < count; i++) {
+		buffer[i] = digits[count - 1 - i];
+	}
+	return count;
+}
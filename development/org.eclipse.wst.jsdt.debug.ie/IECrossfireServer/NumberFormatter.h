@@ -0,0 +1,56 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+/*
+ * Formats doubles as the shortest decimal string that reads back as the same
+ * double, in the form used by JavaScript's Number.prototype.toString().  Integral
+ * values are formatted directly, and all others with the Grisu2 algorithm
+ * (Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with
+ * Integers", PLDI 2010).
+ */
+class NumberFormatter {
+
+public:
+	static size_t format(double value, char* buffer);
+
+	/* constants */
+	static const size_t MAX_LENGTH = 25;
+
+protected:
+	NumberFormatter();
+	~NumberFormatter();
+
+private:
+	/* a floating-point value as a 64-bit significand and a binary exponent */
+	struct DiyFp {
+		unsigned __int64 f;
+		int e;
+	};
+
+	static void digitGen(DiyFp* w, DiyFp* mp, unsigned __int64 delta, char* buffer, int* _length, int* _k);
+	static void getBoundaries(double value, DiyFp* _value, DiyFp* _minus, DiyFp* _plus);
+	static void getCachedPower(int e, DiyFp* _value, int* _k);
+	static void grisu2(double value, char* buffer, int* _length, int* _k);
+	static DiyFp multiply(DiyFp* x, DiyFp* y);
+	static size_t prettify(char* buffer, int length, int k);
+	static void round(char* buffer, int length, unsigned __int64 delta, unsigned __int64 rest, unsigned __int64 tenKappa, unsigned __int64 distance);
+	static size_t writeExponent(int exponent, char* buffer);
+	static size_t writeInteger(unsigned __int64 value, char* buffer);
+
+	/* constants */
+	static const int CACHED_POWERS_E[];
+	static const unsigned __int64 CACHED_POWERS_F[];
+	static const int CACHED_POWERS_MIN_EXPONENT = -348;
+	static const unsigned int POWERS_OF_TEN[];
+};
@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+/*
+ * Parses JSON numbers without allocating.  The significand is accumulated as an
+ * integer while the number is scanned, which alone yields the value of the small
+ * integers that dominate protocol traffic.  Other values are converted with
+ * Clinger's exact fast path where possible, and otherwise with the Eisel-Lemire
+ * algorithm (Lemire, "Number Parsing at a Gigabyte per Second", 2021).  The rare
+ * values that neither can convert exactly are passed to strtod().
+ */
+class NumberParser {
+
+public:
+	static bool parse(const char* start, const char* end, double* _value, const char** _end);
+
+protected:
+	NumberParser();
+	~NumberParser();
+
+private:
+	static bool computeEiselLemire(unsigned __int64 significand, int exponent, double* _value);
+	static void multiply(unsigned __int64 x, unsigned __int64 y, unsigned __int64* _high, unsigned __int64* _low);
+	static bool parseFallback(const char* start, const char* end, double* _value);
+
+	/* constants */
+	static const double EXACT_POWERS_OF_TEN[];
+	static const int MAX_EXACT_POWER = 22;
+	static const int MAX_POWER_OF_FIVE = 308;
+	static const int MAX_SIGNIFICAND_DIGITS = 19;
+	static const int MIN_POWER_OF_FIVE = -342;
+	static const unsigned __int64 POWERS_OF_FIVE[];
+};
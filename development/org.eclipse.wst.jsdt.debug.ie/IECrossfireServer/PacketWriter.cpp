@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "PacketWriter.h"
+
+/* initialize constants */
+const char* PacketWriter::HEADER_CONTENTLENGTH = "Content-Length:";
+const char* PacketWriter::LINEBREAK = "\r\n";
+const size_t PacketWriter::LINEBREAK_LENGTH = 2;
+const size_t PacketWriter::MAX_LENGTH_DIGITS = 10;
+
+PacketWriter::PacketWriter() {
+	m_buffer = new std::string;
+	m_memberEnd = std::string::npos;
+	m_opaqueDepth = 0;
+	m_reservedLength = 0;
+	m_start = 0;
+	m_stringTable = NULL;
+}
+
+PacketWriter::~PacketWriter() {
+	delete m_buffer;
+}
+
+/*
+ * Records the key of a Value's member whose value is written next, after the
+ * key itself has been written.  Once a member whose contents are not known to
+ * be generated by the server has been entered, no member nested within it is
+ * sent by id.  Each call must be matched by a call to endMember() once the
+ * member's value has been written.
+ */
+void PacketWriter::beginMember(const std::string* key) {
+	if (!m_stringTable) {
+		m_memberEnd = std::string::npos;
+		return;
+	}
+	ValueAtom* atom = ValueAtom::find(key->c_str(), key->length());
+	setMember(atom);
+	if (m_opaqueDepth || !atom || !StringTable::isGeneratedKey(atom)) {
+		m_opaqueDepth++;
+	}
+}
+
+void PacketWriter::beginPacket() {
+	clear();
+	m_reservedLength = strlen(HEADER_CONTENTLENGTH) + MAX_LENGTH_DIGITS + 2 * LINEBREAK_LENGTH;
+	m_buffer->append(m_reservedLength, ' ');
+}
+
+/*
+ * Discards the written content, but keeps the buffer's capacity for reuse.
+ */
+void PacketWriter::clear() {
+	m_buffer->clear();
+	m_memberEnd = std::string::npos;
+	m_opaqueDepth = 0;
+	m_reservedLength = 0;
+	m_start = 0;
+}
+
+void PacketWriter::endMember() {
+	if (m_opaqueDepth) {
+		m_opaqueDepth--;
+	}
+}
+
+void PacketWriter::endPacket() {
+	m_buffer->append(LINEBREAK, LINEBREAK_LENGTH);
+
+	/* the length includes the trailing linebreak */
+	char digits[MAX_LENGTH_DIGITS + 1];
+	_ltoa_s((long)(m_buffer->length() - m_reservedLength), digits, MAX_LENGTH_DIGITS + 1, 10);
+	size_t headerLength = strlen(HEADER_CONTENTLENGTH);
+	size_t digitsLength = strlen(digits);
+	m_start = m_reservedLength - (headerLength + digitsLength + 2 * LINEBREAK_LENGTH);
+
+	char* header = &(*m_buffer)[m_start];
+	memcpy(header, HEADER_CONTENTLENGTH, headerLength);
+	header += headerLength;
+	memcpy(header, digits, digitsLength);
+	header += digitsLength;
+	memcpy(header, LINEBREAK, LINEBREAK_LENGTH);
+	memcpy(header + LINEBREAK_LENGTH, LINEBREAK, LINEBREAK_LENGTH);
+}
+
+/*
+ * Returns true and sets the string's id if the string is the value of a
+ * StringTable member and has already been sent.  A string is only such a
+ * value if nothing has been written since setMember() was given the key of
+ * a StringTable member.
+ */
+bool PacketWriter::findStringId(const char* chars, size_t length, unsigned int* _value) {
+	if (!m_stringTable || m_buffer->length() != m_memberEnd) {
+		return false;
+	}
+	m_memberEnd = std::string::npos;
+	return m_stringTable->intern(chars, length, _value);
+}
+
+const char* PacketWriter::getContent() {
+	return m_buffer->data() + m_start;
+}
+
+size_t PacketWriter::getLength() {
+	return m_buffer->length() - m_start;
+}
+
+/*
+ * Records the key of the object member whose value is written next, after
+ * the key itself has been written.
+ */
+void PacketWriter::setMember(ValueAtom* key) {
+	bool isTableMember = m_stringTable && !m_opaqueDepth && key && StringTable::isTableKey(key);
+	m_memberEnd = isTableMember ? m_buffer->length() : std::string::npos;
+}
+
+void PacketWriter::setStringTable(StringTable* value) {
+	m_stringTable = value;
+	m_memberEnd = std::string::npos;
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+#include "StringTable.h"
+#include "Value.h"
+
+/*
+ * Writes packets into a single buffer that is reused from one packet to the
+ * next, leaving the encoding of the packet's content to subclasses.  Values
+ * are written with write(), and the members of an object can also be written
+ * one at a time, so a packet's envelope does not need to be built as a Value
+ * first.
+ *
+ * A packet's Content-Length header is not known until its content has been
+ * written, so beginPacket() reserves room for the longest possible header and
+ * endPacket() writes the actual header immediately before the content.  The
+ * packet is then contiguous without the content having been moved.
+ *
+ * If a StringTable is set then subclasses write the values of its members by
+ * id once they have been sent, as determined by findStringId().  The members
+ * of a Value are bracketed by beginMember() and endMember(), so that members
+ * nested within content that the server did not generate are never sent by id.
+ */
+class PacketWriter {
+
+public:
+	PacketWriter();
+	virtual ~PacketWriter();
+	virtual void beginObject() = 0;
+	void beginPacket();
+	virtual void clear();
+	virtual void endObject() = 0;
+	void endPacket();
+	const char* getContent();
+	size_t getLength();
+	void setStringTable(StringTable* value);
+	virtual void write(Value* value) = 0;
+	virtual void writeBoolean(bool value) = 0;
+	virtual void writeKey(ValueAtom* key) = 0;
+	virtual void writeNull() = 0;
+	virtual void writeNumber(double value) = 0;
+	virtual void writeString(const char* value) = 0;
+	virtual void writeString(std::string* value) = 0;
+	virtual void writeString(const char* chars, size_t length) = 0;
+
+protected:
+	void beginMember(const std::string* key);
+	void endMember();
+	bool findStringId(const char* chars, size_t length, unsigned int* _value);
+	void setMember(ValueAtom* key);
+
+	std::string* m_buffer;
+
+private:
+	size_t m_memberEnd;
+	unsigned int m_opaqueDepth;
+	size_t m_reservedLength;
+	size_t m_start;
+	StringTable* m_stringTable;
+
+	/* constants */
+	static const char* HEADER_CONTENTLENGTH;
+	static const char* LINEBREAK;
+	static const size_t LINEBREAK_LENGTH;
+	static const size_t MAX_LENGTH_DIGITS;
+};
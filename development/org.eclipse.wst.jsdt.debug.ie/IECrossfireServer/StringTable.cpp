@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "StringTable.h"
+
+/* initialize constants */
+ValueAtom* StringTable::KEY_BREAKPOINT = ValueAtom::intern("breakpoint");
+ValueAtom* StringTable::KEY_BREAKPOINTS = ValueAtom::intern("breakpoints");
+ValueAtom* StringTable::KEY_CONTEXTID = ValueAtom::intern("contextId");
+ValueAtom* StringTable::KEY_CONTEXTS = ValueAtom::intern("contexts");
+ValueAtom* StringTable::KEY_FRAME = ValueAtom::intern("frame");
+ValueAtom* StringTable::KEY_FRAMES = ValueAtom::intern("frames");
+ValueAtom* StringTable::KEY_LOCATION = ValueAtom::intern("location");
+ValueAtom* StringTable::KEY_OLDCONTEXTID = ValueAtom::intern("oldContextId");
+ValueAtom* StringTable::KEY_OLDURL = ValueAtom::intern("oldUrl");
+ValueAtom* StringTable::KEY_SCRIPT = ValueAtom::intern("script");
+ValueAtom* StringTable::KEY_SCRIPTS = ValueAtom::intern("scripts");
+ValueAtom* StringTable::KEY_URL = ValueAtom::intern("url");
+
+StringTable::StringTable() {
+	m_ids = new std::map<std::string, unsigned int>;
+	m_lookupKey = new std::string;
+}
+
+StringTable::~StringTable() {
+	delete m_ids;
+	delete m_lookupKey;
+}
+
+void StringTable::clear() {
+	m_ids->clear();
+}
+
+/*
+ * Returns true and sets the string's id if it is already in the table, or
+ * otherwise adds it with the next id and returns false, in which case the
+ * string itself must be sent.  The lookup key's buffer is reused, so looking
+ * up a string that is already in the table does not allocate.
+ */
+bool StringTable::intern(const char* chars, size_t length, unsigned int* _value) {
+	m_lookupKey->assign(chars, length);
+	std::map<std::string, unsigned int>::iterator iterator = m_ids->find(*m_lookupKey);
+	if (iterator != m_ids->end()) {
+		*_value = iterator->second;
+		return true;
+	}
+
+	unsigned int id = (unsigned int)m_ids->size();
+	m_ids->insert(std::pair<std::string, unsigned int>(*m_lookupKey, id));
+	*_value = id;
+	return false;
+}
+
+/*
+ * Answers whether the contents of a member with the given key are generated
+ * by the server, as opposed to being supplied by a client or a script.
+ */
+bool StringTable::isGeneratedKey(ValueAtom* key) {
+	return key == KEY_BREAKPOINT || key == KEY_BREAKPOINTS || key == KEY_CONTEXTS || key == KEY_FRAME
+		|| key == KEY_FRAMES || key == KEY_LOCATION || key == KEY_SCRIPT || key == KEY_SCRIPTS;
+}
+
+bool StringTable::isTableKey(ValueAtom* key) {
+	return key == KEY_CONTEXTID || key == KEY_OLDCONTEXTID || key == KEY_OLDURL || key == KEY_URL;
+}
@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "ValueAtom.h"
+
+/*
+ * Assigns ids to the URLs and context ids that are sent on a connection, for
+ * clients that request this in their handshake.  The first time a string is
+ * sent as the value of a "url", "oldUrl", "contextId" or "oldContextId" member
+ * it is written as usual, and the client assigns it the next id, starting at
+ * 0.  Each later time it is sent as such a value it is written as its id
+ * instead.  The table applies to packets sent by the server, and is cleared
+ * when the connection is reset.
+ *
+ * Only members that the server itself generates are sent by id, so that an
+ * id cannot be confused with a number that a client or a script supplied.
+ * These are the members of the packet's envelope and body, and of objects
+ * that are only reached through the members that isGeneratedKey() accepts,
+ * such as a breakpoint's location, but not its attributes.
+ */
+class StringTable {
+
+public:
+	StringTable();
+	~StringTable();
+	void clear();
+	bool intern(const char* chars, size_t length, unsigned int* _value);
+
+	static bool isGeneratedKey(ValueAtom* key);
+	static bool isTableKey(ValueAtom* key);
+
+private:
+	std::map<std::string, unsigned int>* m_ids;
+	std::string* m_lookupKey;
+
+	/* constants */
+	static ValueAtom* KEY_BREAKPOINT;
+	static ValueAtom* KEY_BREAKPOINTS;
+	static ValueAtom* KEY_CONTEXTID;
+	static ValueAtom* KEY_CONTEXTS;
+	static ValueAtom* KEY_FRAME;
+	static ValueAtom* KEY_FRAMES;
+	static ValueAtom* KEY_LOCATION;
+	static ValueAtom* KEY_OLDCONTEXTID;
+	static ValueAtom* KEY_OLDURL;
+	static ValueAtom* KEY_SCRIPT;
+	static ValueAtom* KEY_SCRIPTS;
+	static ValueAtom* KEY_URL;
+};
@@ -17,7 +17,7 @@ URL::URL() {
 	m_value = NULL;
 }
 
-URL::URL(wchar_t* urlString) {
+URL::URL(char* urlString) {
 	m_value = NULL;
 	setString(urlString);
 }
@@ -28,7 +28,7 @@ URL::~URL() {
 	}
 }
 
-wchar_t* URL::getString() {
+char* URL::getString() {
 	return m_value;
 }
 
@@ -42,57 +42,57 @@ bool URL::isEqual(URL* url) {
 	if (!url->isValid()) {
 		return false;
 	}
-	return wcscmp(m_value, url->getString()) == 0;
+	return strcmp(m_value, url->getString()) == 0;
 }
 
-bool URL::isEqual(wchar_t* urlString) {
+bool URL::isEqual(char* urlString) {
 	if (!urlString) {
 		return !isValid();
 	}
 
-	std::wstring string(urlString);
+	std::string string(urlString);
 	if (!standardize(&string)) {
 		return false;
 	}
 
-	return wcscmp(m_value, string.c_str()) == 0;
+	return strcmp(m_value, string.c_str()) == 0;
 }
 
 bool URL::isValid() {
 	return m_value != NULL;
 }
 
-bool URL::setString(wchar_t* value) {
+bool URL::setString(char* value) {
 	if (m_value) {
 		delete[] m_value;
 		m_value = NULL;
 	}
 
 	if (value) {
-		std::wstring string(value);
+		std::string string(value);
 		if (!standardize(&string)) {
 			return false;
 		}
-		m_value = _wcsdup(string.c_str());
+		m_value = _strdup(string.c_str());
 	}
 	return true;
 }
 
-bool URL::standardize(std::wstring* url) {
-	size_t startIndex = url->find(L":/");
-	if (startIndex == std::wstring::npos) {
+bool URL::standardize(std::string* url) {
+	size_t startIndex = url->find(":/");
+	if (startIndex == std::string::npos) {
 		return false;
 	}
 
 	size_t endIndex = ++startIndex;
-	wchar_t current = url->at(++endIndex);
-	while (current == wchar_t('/')) {
+	char current = url->at(++endIndex);
+	while (current == '/') {
 		current = url->at(++endIndex);
 	}
 
 	size_t diff = endIndex - startIndex;
 	if (diff == 1) {
-		url->insert(startIndex, 1, wchar_t('/'));
+		url->insert(startIndex, 1, '/');
 	} else if (diff > 2) {
 		url->erase(startIndex, diff - 2);
 	}
@@ -18,17 +18,17 @@ class URL {
 
 public:
 	URL();
-	URL(wchar_t* value);
+	URL(char* value);
 	~URL();
-	wchar_t* getString();
-	bool isEqual(wchar_t* urlString);
+	char* getString();
+	bool isEqual(char* urlString);
 	bool isEqual(URL* url);
 	bool isValid();
-	bool setString(wchar_t* value);
+	bool setString(char* value);
 
 private:
-	bool standardize(std::wstring* url);
+	bool standardize(std::string* url);
 
-	wchar_t* m_value;
+	char* m_value;
 };
 
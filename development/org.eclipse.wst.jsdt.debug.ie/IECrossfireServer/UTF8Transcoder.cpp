@@ -0,0 +1,213 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "UTF8Transcoder.h"
+
+#include <emmintrin.h>
+
+#include "JSONStructuralIndex.h"
+
+/* initialize constants */
+const unsigned int UTF8Transcoder::REPLACEMENT_CHARACTER = 0xFFFD;
+
+/* initialize statics */
+int UTF8Transcoder::s_instructionSet = -1;
+
+UTF8Transcoder::UTF8Transcoder() {
+}
+
+UTF8Transcoder::~UTF8Transcoder() {
+}
+
+/*
+ * Decodes UTF-8 into target, which must have room for length characters, and
+ * returns the number of characters written.  A code point beyond the BMP takes
+ * four bytes and becomes at most two UTF-16 code units, so the result is never
+ * longer than the input.
+ */
+size_t UTF8Transcoder::decode(const char* chars, size_t length, wchar_t* target) {
+	const unsigned char* current = (const unsigned char*)chars;
+	const unsigned char* end = current + length;
+	wchar_t* out = target;
+	bool simd = sizeof(wchar_t) == 2 && isSSE2Supported();
+
+	while (current < end) {
+		if (simd) {
+			const __m128i zero = _mm_setzero_si128();
+			while (end - current >= 16) {
+				__m128i chunk = _mm_loadu_si128((const __m128i*)current);
+				if (_mm_movemask_epi8(chunk)) {
+					break;
+				}
+				_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi8(chunk, zero));
+				_mm_storeu_si128((__m128i*)(out + 8), _mm_unpackhi_epi8(chunk, zero));
+				current += 16;
+				out += 16;
+			}
+			if (current == end) {
+				break;
+			}
+		}
+
+		unsigned int c = *current;
+		if (c < 0x80) {
+			*out++ = (wchar_t)c;
+			current++;
+			continue;
+		}
+
+		/* determine the sequence's length and the range that its code point must be in */
+		size_t count;
+		unsigned int codePoint, minimum;
+		if (0xC2 <= c && c <= 0xDF) {
+			count = 2;
+			codePoint = c & 0x1F;
+			minimum = 0x80;
+		} else if (0xE0 <= c && c <= 0xEF) {
+			count = 3;
+			codePoint = c & 0x0F;
+			minimum = 0x800;
+		} else if (0xF0 <= c && c <= 0xF4) {
+			count = 4;
+			codePoint = c & 0x07;
+			minimum = 0x10000;
+		} else {
+			*out++ = (wchar_t)REPLACEMENT_CHARACTER;
+			current++;
+			continue;
+		}
+
+		size_t index = 1;
+		while (index < count && current + index < end && (current[index] & 0xC0) == 0x80) {
+			codePoint = (codePoint << 6) | (current[index] & 0x3F);
+			index++;
+		}
+		if (index < count || codePoint < minimum || 0x10FFFF < codePoint || (0xD800 <= codePoint && codePoint <= 0xDFFF)) {
+			/* a truncated, overlong or out of range sequence is replaced as a whole */
+			*out++ = (wchar_t)REPLACEMENT_CHARACTER;
+			current += index;
+			continue;
+		}
+		current += count;
+
+		if (codePoint < 0x10000 || sizeof(wchar_t) > 2) {
+			*out++ = (wchar_t)codePoint;
+		} else {
+			codePoint -= 0x10000;
+			*out++ = (wchar_t)(0xD800 + (codePoint >> 10));
+			*out++ = (wchar_t)(0xDC00 + (codePoint & 0x3FF));
+		}
+	}
+	return out - target;
+}
+
+/*
+ * Encodes wide characters as UTF-8 into target, which must have room for three
+ * bytes per character, and returns the number of bytes written.  A surrogate pair
+ * is two characters that become four bytes, so three bytes per character is the
+ * longest possible result.
+ */
+size_t UTF8Transcoder::encode(const wchar_t* chars, size_t length, char* target) {
+	const wchar_t* current = chars;
+	const wchar_t* end = chars + length;
+	char* out = target;
+	bool simd = sizeof(wchar_t) == 2 && isSSE2Supported();
+
+	while (current < end) {
+		if (simd) {
+			const __m128i nonAscii = _mm_set1_epi16((short)0xFF80);
+			const __m128i zero = _mm_setzero_si128();
+			while (end - current >= 16) {
+				__m128i low = _mm_loadu_si128((const __m128i*)current);
+				__m128i high = _mm_loadu_si128((const __m128i*)(current + 8));
+				__m128i special = _mm_and_si128(_mm_or_si128(low, high), nonAscii);
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(special, zero)) != 0xFFFF) {
+					break;
+				}
+				_mm_storeu_si128((__m128i*)out, _mm_packus_epi16(low, high));
+				current += 16;
+				out += 16;
+			}
+			if (current == end) {
+				break;
+			}
+		}
+
+		unsigned int c = (unsigned int)*current++;
+		if (c < 0x80) {
+			*out++ = (char)c;
+			continue;
+		}
+		if (0xD800 <= c && c <= 0xDFFF) {
+			if (c <= 0xDBFF && current < end && 0xDC00 <= (unsigned int)*current && (unsigned int)*current <= 0xDFFF) {
+				c = 0x10000 + ((c - 0xD800) << 10) + ((unsigned int)*current++ - 0xDC00);
+			} else {
+				/* an unpaired surrogate cannot be encoded */
+				c = REPLACEMENT_CHARACTER;
+			}
+		} else if (0x10FFFF < c) {
+			c = REPLACEMENT_CHARACTER;
+		}
+
+		if (c < 0x800) {
+			*out++ = (char)(0xC0 | (c >> 6));
+			*out++ = (char)(0x80 | (c & 0x3F));
+		} else if (c < 0x10000) {
+			*out++ = (char)(0xE0 | (c >> 12));
+			*out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+			*out++ = (char)(0x80 | (c & 0x3F));
+		} else {
+			*out++ = (char)(0xF0 | (c >> 18));
+			*out++ = (char)(0x80 | ((c >> 12) & 0x3F));
+			*out++ = (char)(0x80 | ((c >> 6) & 0x3F));
+			*out++ = (char)(0x80 | (c & 0x3F));
+		}
+	}
+	return out - target;
+}
+
+bool UTF8Transcoder::isSSE2Supported() {
+	if (s_instructionSet < 0) {
+		s_instructionSet = JSONStructuralIndex::getInstructionSet();
+	}
+	return s_instructionSet != JSONStructuralIndex::ISA_SCALAR;
+}
+
+/*
+ * A NULL string, such as an empty BSTR, converts to an empty string.
+ */
+void UTF8Transcoder::toUTF8(const wchar_t* chars, std::string* target) {
+	toUTF8(chars, chars ? wcslen(chars) : 0, target);
+}
+
+void UTF8Transcoder::toUTF8(const wchar_t* chars, size_t length, std::string* target) {
+	if (!length) {
+		target->clear();
+		return;
+	}
+	target->resize(length * 3);
+	target->resize(encode(chars, length, &(*target)[0]));
+}
+
+void UTF8Transcoder::toWide(const char* chars, std::wstring* target) {
+	toWide(chars, chars ? strlen(chars) : 0, target);
+}
+
+void UTF8Transcoder::toWide(const char* chars, size_t length, std::wstring* target) {
+	if (!length) {
+		target->clear();
+		return;
+	}
+	target->resize(length);
+	target->resize(decode(chars, length, &(*target)[0]));
+}
@@ -0,0 +1,45 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+/*
+ * Converts between the UTF-8 strings that the protocol core works with and the
+ * UTF-16 strings of COM interfaces.  Each conversion is a single pass into the
+ * target, which is sized for the longest possible result up front and so can be
+ * reused without being reallocated.  Runs of ASCII characters are converted 16
+ * bytes at a time with SSE2, and invalid sequences are replaced with U+FFFD.
+ */
+class UTF8Transcoder {
+
+public:
+	static void toUTF8(const wchar_t* chars, std::string* target);
+	static void toUTF8(const wchar_t* chars, size_t length, std::string* target);
+	static void toWide(const char* chars, std::wstring* target);
+	static void toWide(const char* chars, size_t length, std::wstring* target);
+
+protected:
+	UTF8Transcoder();
+	~UTF8Transcoder();
+
+private:
+	static size_t decode(const char* chars, size_t length, wchar_t* target);
+	static size_t encode(const wchar_t* chars, size_t length, char* target);
+	static bool isSSE2Supported();
+
+	static int s_instructionSet;
+
+	/* constants */
+	static const unsigned int REPLACEMENT_CHARACTER;
+};
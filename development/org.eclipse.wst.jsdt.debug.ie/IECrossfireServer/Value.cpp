@@ -13,143 +13,208 @@
 #include "stdafx.h"
 #include "Value.h"
 
+#include "JSONDocument.h"
+#include "UTF8Transcoder.h"
+
 Value::Value() {
-	m_type = TYPE_UNDEFINED;
-	m_arrayValue = NULL;
-	m_numberValue = 0;
-	m_objectValue = NULL;
-	m_stringValue = NULL;
+	initialize();
 }
 
 Value::Value(bool value) {
+	initialize();
 	setValue(value);
 }
 
 Value::Value(double value) {
+	initialize();
+	setValue(value);
+}
+
+Value::Value(const char* value) {
+	initialize();
 	setValue(value);
 }
 
 Value::Value(const wchar_t* value) {
+	initialize();
 	setValue(value);
 }
 
-Value::Value(std::wstring* value) {
+Value::Value(std::string* value) {
+	initialize();
 	setValue(value);
 }
 
+/*
+ * Creates a Value for an entry of a parsed JSONDocument.  The contents of a
+ * string, array or object are not created until they are first accessed, at
+ * which point any nested arrays and objects are created in the same way.  The
+ * document is kept alive by each Value that still refers to it.
+ */
+Value::Value(JSONDocument* document, unsigned int index) {
+	initialize();
+
+	int type = document->getType(index);
+	switch (type) {
+		case TYPE_NULL: {
+			setType(TYPE_NULL);
+			break;
+		}
+		case TYPE_BOOLEAN: {
+			setValue(document->getNumberValue(index) != 0);
+			break;
+		}
+		case TYPE_NUMBER: {
+			setValue(document->getNumberValue(index));
+			break;
+		}
+		case TYPE_STRING:
+		case TYPE_ARRAY:
+		case TYPE_OBJECT: {
+			m_type = (unsigned char)type;
+			m_flags |= FLAG_LAZY;
+			m_value.lazy.document = document;
+			m_value.lazy.index = index;
+			document->addRef();
+			break;
+		}
+	}
+}
+
 Value::~Value() {
 	clearCurrentValue();
 }
 
 void Value::clearCurrentValue() {
+	if (m_flags & FLAG_LAZY) {
+		/* not materialized yet */
+		m_value.lazy.document->release();
+		initialize();
+		return;
+	}
+
 	switch (m_type) {
 		case TYPE_STRING: {
-			delete m_stringValue;
+			StringBlock* block = m_value.string;
+			if (!(m_flags & FLAG_INLINE) && --block->refCount == 0) {
+				ValuePool::deallocate(block, sizeof(StringBlock) + block->length);
+			}
 			break;
 		}
 		case TYPE_ARRAY: {
-			std::vector<Value*>::iterator iterator = m_arrayValue->begin();
-			std::vector<Value*>::iterator end = m_arrayValue->end();
-			while (iterator != end) {
-				delete *iterator;
-				iterator++;
+			ArrayBlock* block = m_value.array;
+			if (--block->refCount == 0) {
+				ArrayStorage::iterator iterator = block->items.begin();
+				ArrayStorage::iterator end = block->items.end();
+				while (iterator != end) {
+					delete *iterator;
+					iterator++;
+				}
+				ValuePool::destroy(block);
 			}
-			delete m_arrayValue;
 			break;
 		}
 		case TYPE_OBJECT: {
-			std::map<std::wstring, Value*>::iterator it = m_objectValue->begin();
-			std::map<std::wstring, Value*>::iterator end = m_objectValue->end();
-			while (it != end) {
-				delete (*it).second;
-				it++;
+			ObjectBlock* block = m_value.object;
+			if (--block->refCount == 0) {
+				size_t size = block->members.size();
+				for (size_t i = 0; i < size; i++) {
+					delete block->members.getValue(i);
+				}
+				ValuePool::destroy(block);
 			}
-			delete m_objectValue;
 			break;
 		}
 	}
-	m_type = TYPE_UNDEFINED;
+	initialize();
 }
 
 void Value::clone(Value** _value) {
-	switch (getType()) {
-		case TYPE_NULL: {
-			Value* result = new Value();
-			result->setType(TYPE_NULL);
-			*_value = result;
-			break;
-		}
-		case TYPE_BOOLEAN: {
-			Value* result = new Value();
-			result->setValue(getBooleanValue());
-			*_value = result;
-			break;
-		}
-		case TYPE_NUMBER: {
-			Value* result = new Value();
-			result->setValue(getNumberValue());
-			*_value = result;
-			break;
-		}
+	if (m_flags & FLAG_LAZY) {
+		/* share the document rather than materializing a copy of it */
+		*_value = new Value(m_value.lazy.document, m_value.lazy.index);
+		return;
+	}
+
+	/*
+	 * The contents of a long string, array or object are shared with the clone
+	 * rather than copied, and an array or object is only copied once either
+	 * Value is modified or one of its elements is accessed (see detach()).
+	 * An element that was answered before this Value was cloned is therefore
+	 * shared with the clone, so it must not be modified through that pointer.
+	 * Access the element again to get one that this Value owns.
+	 */
+	Value* result = new Value();
+	result->m_value = m_value;
+	result->m_flags = m_flags;
+	result->m_length = m_length;
+	result->m_type = m_type;
+	switch (m_type) {
 		case TYPE_STRING: {
-			Value* result = new Value();
-			result->setValue(getStringValue());
-			*_value = result;
+			if (!(m_flags & FLAG_INLINE)) {
+				m_value.string->refCount++;
+			}
 			break;
 		}
 		case TYPE_ARRAY: {
-			Value** values = NULL;
-			getArrayValues(&values);
-			Value* result = new Value();
-			result->setType(TYPE_ARRAY);
-			int index = 0;
-			while (values[index]) {
-				result->addArrayValue(values[index++]);
-			}
-			delete[] values;
-
-			*_value = result;
+			m_value.array->refCount++;
 			break;
 		}
 		case TYPE_OBJECT: {
-			std::wstring** keys = NULL;
-			Value** values = NULL;
-			getObjectValues(&keys, &values);
-			Value* result = new Value();
-			result->setType(TYPE_OBJECT);
-			int index = 0;
-			while (keys[index]) {
-				std::wstring keyCopy(*keys[index]);
-				result->addObjectValue(&keyCopy, values[index++]);
-			}
-			delete[] values;
-			delete[] keys;
-
-			*_value = result;
+			m_value.object->refCount++;
 			break;
 		}
-		default: {
-			/* TYPE_UNDEFINED */
-			Value* result = new Value();
-			result->setType(TYPE_UNDEFINED);
-			*_value = result;
-		}
 	}
+	*_value = result;
 }
 
 void Value::addArrayValue(Value *value) {
-	setType(TYPE_ARRAY);
 	Value* result = NULL;
 	value->clone(&result);
-	m_arrayValue->push_back(result);
+	adoptArrayValue(result);
+}
+
+bool Value::addObjectValue(const char* key, Value* value) {
+	Value* result = NULL;
+	value->clone(&result);
+	return insertObjectValue(key, strlen(key), result, false);
+}
+
+bool Value::addObjectValue(std::string* key, Value* value) {
+	Value* result = NULL;
+	value->clone(&result);
+	return insertObjectValue(key->c_str(), key->length(), result, false);
 }
 
-bool Value::addObjectValue(const wchar_t* key, Value* value) {
-	return addObjectValue(&std::wstring(key), value);
+bool Value::addObjectValue(ValueAtom* key, Value* value) {
+	Value* result = NULL;
+	value->clone(&result);
+	return insertObjectValue(key, result, false);
 }
 
-bool Value::addObjectValue(std::wstring* key, Value* value) {
-	return setObjectValue(key, value, false);
+/*
+ * The adopt methods take ownership of the given value instead of adding a
+ * clone of it, so a tree that is built from the bottom up is not copied once
+ * for each level that it is nested within.  Ownership is transferred even if
+ * the value cannot be added, in which case it is deleted, so callers never
+ * need to check whether the value was adopted.
+ */
+void Value::adoptArrayValue(Value* value) {
+	setType(TYPE_ARRAY);
+	detach();
+	m_value.array->items.push_back(value);
+}
+
+bool Value::adoptObjectValue(const char* key, Value* value) {
+	return insertObjectValue(key, strlen(key), value, false);
+}
+
+bool Value::adoptObjectValue(std::string* key, Value* value) {
+	return insertObjectValue(key->c_str(), key->length(), value, false);
+}
+
+bool Value::adoptObjectValue(ValueAtom* key, Value* value) {
+	return insertObjectValue(key, value, false);
 }
 
 //bool Value::clearObjectValue(const wchar_t* key) {
@@ -161,16 +226,102 @@ bool Value::addObjectValue(std::wstring* key, Value* value) {
 //		return false;
 //	}
 //
-//	std::map<std::wstring, Value*>::iterator iterator = m_objectValue->find(*key);
-//	if (iterator == m_objectValue->end()) {
+//	ObjectStorage::iterator iterator = m_value.object->find(*key);
+//	if (iterator == m_value.object->end()) {
 //		/* not found */
 //		return false;
 //	}
 //	delete (*iterator).second;
-//	m_objectValue->erase(iterator);
+//	m_value.object->erase(iterator);
 //	return true;
 //}
 
+bool Value::insertObjectValue(const char* key, size_t length, Value* value, bool overwrite) {
+	ValueAtom* atom = ValueAtom::intern(key, length);
+	bool result = insertObjectValue(atom, value, overwrite);
+	atom->release();
+	return result;
+}
+
+bool Value::insertObjectValue(ValueAtom* key, Value* value, bool overwrite) {
+	setType(TYPE_OBJECT);
+	ValueTable* members = &m_value.object->members;
+	int index = members->find(key);
+	if (index != -1) {
+		/* value with this key already exists in the object */
+		if (!overwrite) {
+			delete value;
+			return false;
+		}
+		detach();
+		members = &m_value.object->members;
+		delete members->getValue(index);
+		members->setValue(index, value);
+		return true;
+	}
+	detach();
+	m_value.object->members.append(key, value);
+	return true;
+}
+
+Value::ArrayBlock* Value::createArrayBlock() {
+	ArrayBlock* result = ValuePool::create<ArrayBlock>();
+	result->refCount = 1;
+	return result;
+}
+
+Value::ObjectBlock* Value::createObjectBlock() {
+	ObjectBlock* result = ValuePool::create<ObjectBlock>();
+	result->refCount = 1;
+	return result;
+}
+
+/*
+ * Gives this Value its own copy of an array or object whose contents are
+ * shared with a clone, before the contents are modified or an element is
+ * answered.  Only one level is copied, since the elements themselves are
+ * cloned by sharing and in turn detach when they are accessed, so an element
+ * that is answered can be modified without affecting the clone.
+ */
+void Value::detach() {
+	switch (m_type) {
+		case TYPE_ARRAY: {
+			ArrayBlock* shared = m_value.array;
+			if (shared->refCount == 1) {
+				return;
+			}
+			ArrayBlock* block = createArrayBlock();
+			size_t size = shared->items.size();
+			block->items.reserve(size + 1);
+			for (size_t i = 0; i < size; i++) {
+				Value* item = NULL;
+				shared->items[i]->clone(&item);
+				block->items.push_back(item);
+			}
+			shared->refCount--;
+			m_value.array = block;
+			break;
+		}
+		case TYPE_OBJECT: {
+			ObjectBlock* shared = m_value.object;
+			if (shared->refCount == 1) {
+				return;
+			}
+			ObjectBlock* block = createObjectBlock();
+			size_t size = shared->members.size();
+			block->members.reserve(size + 1);
+			for (size_t i = 0; i < size; i++) {
+				Value* member = NULL;
+				shared->members.getValue(i)->clone(&member);
+				block->members.append(shared->members.getKey(i), member);
+			}
+			shared->refCount--;
+			m_value.object = block;
+			break;
+		}
+	}
+}
+
 bool Value::equals(Value* value) {
 	if (!value || value->getType() != m_type) {
 		return false;
@@ -188,163 +339,208 @@ bool Value::equals(Value* value) {
 			return value->getNumberValue() == getNumberValue();
 		}
 		case TYPE_STRING: {
-			return value->getStringValue()->compare(*getStringValue()) == 0;
+			size_t length = getStringLength();
+			return value->getStringLength() == length && memcmp(value->getStringValue(), getStringValue(), length) == 0;
 		}
 		case TYPE_ARRAY: {
-			Value** selfItems = NULL;
-			getArrayValues(&selfItems);
-			Value** valueItems = NULL;
-			value->getArrayValues(&valueItems);
-			bool isEqual = true;
-			int index = 0;
-			while (selfItems[index]) {
-				if (!selfItems[index]->equals(valueItems[index])) {
-					isEqual = false;
-					break;
-				}
-				index++;
+			materialize();
+			value->materialize();
+			if (m_value.array == value->m_value.array) {
+				/* shared by clones */
+				return true;
+			}
+			ArrayStorage* items = &m_value.array->items;
+			ArrayStorage* valueItems = &value->m_value.array->items;
+			size_t size = items->size();
+			if (valueItems->size() != size) {
+				return false;
 			}
-			if (isEqual) {
-				isEqual = valueItems[index] == NULL;
+			for (size_t i = 0; i < size; i++) {
+				if (!(*items)[i]->equals((*valueItems)[i])) {
+					return false;
+				}
 			}
-			delete[] valueItems;
-			delete[] selfItems;
-			return isEqual;
+			return true;
 		}
 		case TYPE_OBJECT: {
-			std::wstring** selfKeys = NULL;
-			Value** selfValues = NULL;
-			getObjectValues(&selfKeys, &selfValues);
-			bool isEqual = true;
-			int index = 0;
-			while (selfKeys[index]) {
-				Value* valueValue = value->getObjectValue(selfKeys[index]);
-				if (!valueValue || !selfValues[index]->equals(valueValue)) {
-					isEqual = false;
-					break;
-				}
-				index++;
+			materialize();
+			value->materialize();
+			if (m_value.object == value->m_value.object) {
+				/* shared by clones */
+				return true;
+			}
+			/* compare the storage directly, since the accessors would detach shared contents */
+			ValueTable* members = &m_value.object->members;
+			ValueTable* valueMembers = &value->m_value.object->members;
+			size_t size = members->size();
+			if (valueMembers->size() != size) {
+				return false;
 			}
-			delete[] selfKeys;
-			delete[] selfValues;
-			if (isEqual) {
-				/* ensure that value does not contain extra keys/values */
-				std::wstring** valueKeys = NULL;
-				Value** valueValues = NULL;
-				value->getObjectValues(&valueKeys, &valueValues);
-				int length = 0;
-				while (valueKeys[length++]);
-				isEqual = length == index;
-				delete[] valueKeys;
-				delete[] valueValues;
+			for (size_t i = 0; i < size; i++) {
+				int index = valueMembers->find(members->getKey(i));
+				if (index == -1 || !members->getValue(i)->equals(valueMembers->getValue(index))) {
+					return false;
+				}
 			}
-			return isEqual;
+			return true;
 		}
 	}
 
 	return false;	/* should never happen */
 }
 
-void Value::getArrayValues(Value*** __values) {
+Value* Value::findObjectValue(const char* key, size_t length) {
+	materialize();
+	if (m_type != TYPE_OBJECT) {
+		return NULL;
+	}
+
+	/* a key that has not been interned cannot be in any object */
+	ValueAtom* atom = ValueAtom::find(key, length);
+	if (!atom) {
+		return NULL;
+	}
+	return getObjectValue(atom);
+}
+
+/*
+ * The indexed accessors refer directly to the storage of an array or object,
+ * so walking a Value that is not shared with a clone does not allocate, and
+ * the peek accessors walk one that is.  They return NULL for an index that is
+ * out of range.
+ */
+size_t Value::getArraySize() {
+	materialize();
 	if (m_type != TYPE_ARRAY) {
-		*__values = NULL;
-		return;
+		return 0;
 	}
-	size_t size = m_arrayValue->size();
-	Value** result = new Value*[size + 1];
-	for (int i = 0; i < (int)size; i++) {
-		result[i] = m_arrayValue->at(i);
+	return m_value.array->items.size();
+}
+
+Value* Value::getArrayValueAt(size_t index) {
+	if (getArraySize() <= index) {
+		return NULL;
 	}
-	result[size] = NULL;
-	*__values = result;
+	detach();
+	return m_value.array->items[index];
 }
 
 bool Value::getBooleanValue() {
 	if (m_type != TYPE_BOOLEAN) {
 		return false;
 	}
-	return m_numberValue != 0;
+	return m_value.number != 0;
 }
 
 double Value::getNumberValue() {
 	if (m_type != TYPE_NUMBER) {
 		return 0;
 	}
-	return m_numberValue;
+	return m_value.number;
+}
+
+const std::string* Value::getObjectKeyAt(size_t index) {
+	if (getObjectSize() <= index) {
+		return NULL;
+	}
+	return m_value.object->members.getKey(index)->getString();
+}
+
+size_t Value::getObjectSize() {
+	materialize();
+	if (m_type != TYPE_OBJECT) {
+		return 0;
+	}
+	return m_value.object->members.size();
+}
+
+Value* Value::getObjectValue(const char* key) {
+	return findObjectValue(key, strlen(key));
 }
 
-Value* Value::getObjectValue(const wchar_t* key) {
-	return getObjectValue(&std::wstring(key));
+Value* Value::getObjectValue(std::string* key) {
+	return findObjectValue(key->c_str(), key->length());
 }
 
-Value* Value::getObjectValue(std::wstring* key) {
+Value* Value::getObjectValue(ValueAtom* key) {
+	materialize();
 	if (m_type != TYPE_OBJECT) {
 		return NULL;
 	}
 
-	std::map<std::wstring, Value*>::iterator result = m_objectValue->find(*key);
-	if (result == m_objectValue->end()) {
+	int index = m_value.object->members.find(key);
+	if (index == -1) {
 		/* not found */
 		return NULL;
 	}
-	return result->second;
+	detach();
+	return m_value.object->members.getValue(index);
 }
 
-void Value::getObjectValues(std::wstring*** __keys, Value*** __values) {
-	if (m_type != TYPE_OBJECT) {
-		*__keys = NULL;
-		*__values = NULL;
-		return;
+Value* Value::getObjectValueAt(size_t index) {
+	if (getObjectSize() <= index) {
+		return NULL;
 	}
-	size_t size = m_objectValue->size();
-	std::wstring** keysResult = new std::wstring*[size + 1];
-	Value** valuesResult = new Value*[size + 1];
-
-	std::map<std::wstring, Value*>::iterator it = m_objectValue->begin();
-	std::map<std::wstring, Value*>::iterator end = m_objectValue->end();
-	int index = 0;
-	while (it != end) {
-		keysResult[index] = (std::wstring*)&(*it).first;
-		valuesResult[index++] = (*it).second;
-		it++;
+	detach();
+	return m_value.object->members.getValue(index);
+}
+
+/*
+ * The peek accessors answer an element to be read but not modified, such as
+ * by a writer.  Unlike the get accessors they do not copy contents that are
+ * shared with a clone, so reading a shared Value does not allocate.
+ */
+Value* Value::peekArrayValueAt(size_t index) {
+	if (getArraySize() <= index) {
+		return NULL;
 	}
-	keysResult[index] = NULL;
-	valuesResult[index] = NULL;
+	return m_value.array->items[index];
+}
 
-	*__keys = keysResult;
-	*__values = valuesResult;
+Value* Value::peekObjectValueAt(size_t index) {
+	if (getObjectSize() <= index) {
+		return NULL;
+	}
+	return m_value.object->members.getValue(index);
 }
 
-bool Value::setObjectValue(const wchar_t* key, Value* value) {
-	return setObjectValue(&std::wstring(key), value);
+bool Value::setObjectValue(const char* key, Value* value) {
+	Value* result = NULL;
+	value->clone(&result);
+	return insertObjectValue(key, strlen(key), result, true);
 }
 
-bool Value::setObjectValue(std::wstring* key, Value* value) {
-	return setObjectValue(key, value, true);
+bool Value::setObjectValue(std::string* key, Value* value) {
+	Value* result = NULL;
+	value->clone(&result);
+	return insertObjectValue(key->c_str(), key->length(), result, true);
 }
 
-bool Value::setObjectValue(std::wstring* key, Value* value, bool overwrite) {
-	setType(TYPE_OBJECT);
-	std::map<std::wstring, Value*>::iterator it = m_objectValue->find(*key);
-	if (it != m_objectValue->end()) {
-		/* value with this key already exists in map */
-		if (!overwrite) {
-			return false;
-		}
-		delete (*it).second;
-		m_objectValue->erase(it);
-	}
+bool Value::setObjectValue(ValueAtom* key, Value* value) {
 	Value* result = NULL;
 	value->clone(&result);
-	m_objectValue->insert(std::pair<std::wstring,Value*>(*key, result));
-	return true;
+	return insertObjectValue(key, result, true);
+}
+
+size_t Value::getStringLength() {
+	materialize();
+	if (m_type != TYPE_STRING) {
+		return 0;
+	}
+	return (m_flags & FLAG_INLINE) ? m_length : m_value.string->length;
 }
 
-std::wstring* Value::getStringValue() {
+/*
+ * Returns the string's UTF-8 bytes, which are null-terminated.  Strings can
+ * contain null characters, so getStringLength() should be used to determine
+ * where the string ends.
+ */
+const char* Value::getStringValue() {
+	materialize();
 	if (m_type != TYPE_STRING) {
 		return NULL;
 	}
-	return m_stringValue;
+	return (m_flags & FLAG_INLINE) ? m_value.chars : m_value.string->chars;
 }
 
 int Value::getType() {
@@ -354,32 +550,125 @@ int Value::getType() {
 void Value::setValue(bool value) {
 	setType(TYPE_BOOLEAN);
 	if (value) {
-		m_numberValue = 1;
+		m_value.number = 1;
 	} else {
-		m_numberValue = 0;
+		m_value.number = 0;
 	}
 }
 
 void Value::setValue(double value) {
 	setType(TYPE_NUMBER);
-	m_numberValue = value;
+	m_value.number = value;
+}
+
+void Value::setValue(const char* value) {
+	setValue(value, strlen(value));
 }
 
+/*
+ * Converts a UTF-16 string, such as one that is received through a COM
+ * interface, to UTF-8.
+ */
 void Value::setValue(const wchar_t* value) {
-	setType(TYPE_STRING);
-	m_stringValue = new std::wstring;
-	m_stringValue->assign(value);
+	std::string string;
+	UTF8Transcoder::toUTF8(value, &string);
+	setValue(string.c_str(), string.length());
 }
 
-void Value::setValue(std::wstring* value) {
-	setType(TYPE_STRING);
-	m_stringValue = new std::wstring;
-	m_stringValue->assign(*value);
+void Value::setValue(std::string* value) {
+	setValue(value->c_str(), value->length());
+}
+
+void Value::setValue(const char* value, size_t length) {
+	clearCurrentValue();
+	m_type = TYPE_STRING;
+	char* chars = NULL;
+	if (length <= INLINE_STRING_LENGTH) {
+		m_flags |= FLAG_INLINE;
+		m_length = (unsigned short)length;
+		chars = m_value.chars;
+	} else {
+		StringBlock* block = (StringBlock*)ValuePool::allocate(sizeof(StringBlock) + length);
+		block->length = length;
+		block->refCount = 1;
+		m_value.string = block;
+		chars = block->chars;
+	}
+	memcpy(chars, value, length);
+	chars[length] = '\0';
+}
+
+/*
+ * Values are allocated from ValuePool, as are their containers and strings.
+ */
+void* Value::operator new(size_t size) {
+	return ValuePool::allocate(size);
+}
+
+void Value::operator delete(void* pointer, size_t size) {
+	ValuePool::deallocate(pointer, size);
+}
+
+void Value::initialize() {
+	m_flags = 0;
+	m_length = 0;
+	m_type = TYPE_UNDEFINED;
+	m_value.number = 0;
+}
+
+void Value::materialize() {
+	if (!(m_flags & FLAG_LAZY)) {
+		return;
+	}
+
+	JSONDocument* document = m_value.lazy.document;
+	unsigned int documentIndex = m_value.lazy.index;
+	m_flags &= ~FLAG_LAZY;
+	switch (m_type) {
+		case TYPE_STRING: {
+			std::string stringValue;
+			document->appendStringValue(documentIndex, &stringValue);
+			m_type = TYPE_UNDEFINED;
+			setValue(stringValue.c_str(), stringValue.length());
+			break;
+		}
+		case TYPE_ARRAY: {
+			unsigned int count = document->getCount(documentIndex);
+			m_value.array = createArrayBlock();
+			m_value.array->items.reserve(count);
+			unsigned int index = documentIndex + 1;
+			for (unsigned int i = 0; i < count; i++) {
+				m_value.array->items.push_back(new Value(document, index));
+				index = document->getNext(index);
+			}
+			break;
+		}
+		case TYPE_OBJECT: {
+			/* the document has already verified that the object's keys are unique */
+			unsigned int count = document->getCount(documentIndex);
+			m_value.object = createObjectBlock();
+			m_value.object->members.reserve(count);
+			std::string key;
+			unsigned int index = documentIndex + 1;
+			for (unsigned int i = 0; i < count; i++) {
+				key.clear();
+				document->appendStringValue(index, &key);
+				index = document->getNext(index);
+				ValueAtom* atom = ValueAtom::intern(key.c_str(), key.length());
+				m_value.object->members.append(atom, new Value(document, index));
+				atom->release();
+				index = document->getNext(index);
+			}
+			break;
+		}
+	}
+	document->release();
 }
 
 void Value::setType(int value) {
 	if (m_type == value) {
 		/* nothing to do */
+		materialize();
 		return;
 	}
 
@@ -391,14 +680,19 @@ void Value::setType(int value) {
 		return;
 	}
 
-	m_type = value;
+	m_type = (unsigned char)value;
 	switch (m_type) {
+		case TYPE_STRING: {
+			m_flags |= FLAG_INLINE;
+			m_value.chars[0] = '\0';
+			break;
+		}
 		case TYPE_ARRAY: {
-			m_arrayValue = new std::vector<Value*>;
+			m_value.array = createArrayBlock();
 			break;
 		}
 		case TYPE_OBJECT: {
-			m_objectValue = new std::map<std::wstring, Value*>;
+			m_value.object = createObjectBlock();
 			break;
 		}
 	}
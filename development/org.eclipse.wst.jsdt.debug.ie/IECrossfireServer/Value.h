@@ -17,6 +17,9 @@
 #include <sstream>
 #include <vector>
 
+#include "ValuePool.h"
+#include "ValueTable.h"
+
 enum {
 	TYPE_UNDEFINED = 0x0,
 	TYPE_NULL = 0x1,
@@ -27,45 +30,118 @@ enum {
 	TYPE_OBJECT = 0x20,
 };
 
+class JSONDocument; // forward declaration
+
 class Value {
 
 public:
 	Value();
 	Value(bool value);
 	Value(double value);
+	Value(const char* value);
 	Value(const wchar_t* value);
-	Value(std::wstring* value);
+	Value(std::string* value);
+	Value(JSONDocument* document, unsigned int index);
 	~Value();
 	void addArrayValue(Value* value);
-	bool addObjectValue(const wchar_t* key, Value* value);
-	bool addObjectValue(std::wstring* key, Value* value);
+	bool addObjectValue(const char* key, Value* value);
+	bool addObjectValue(std::string* key, Value* value);
+	bool addObjectValue(ValueAtom* key, Value* value);
+	void adoptArrayValue(Value* value);
+	bool adoptObjectValue(const char* key, Value* value);
+	bool adoptObjectValue(std::string* key, Value* value);
+	bool adoptObjectValue(ValueAtom* key, Value* value);
 //	bool clearObjectValue(const wchar_t* key);
 //	bool clearObjectValue(std::wstring* key);
 	void clone(Value** _value);
 	bool equals(Value* value);
-	void getArrayValues(Value*** __values);
+	size_t getArraySize();
+	Value* getArrayValueAt(size_t index);
 	bool getBooleanValue();
 	double getNumberValue();
-	Value* getObjectValue(const wchar_t* key);
-	Value* getObjectValue(std::wstring* key);
-	void getObjectValues(std::wstring*** __keys, Value*** __values);
-	std::wstring* getStringValue();
+	const std::string* getObjectKeyAt(size_t index);
+	size_t getObjectSize();
+	Value* getObjectValue(const char* key);
+	Value* getObjectValue(std::string* key);
+	Value* getObjectValue(ValueAtom* key);
+	Value* getObjectValueAt(size_t index);
+	size_t getStringLength();
+	const char* getStringValue();
 	int getType();
-	bool setObjectValue(const wchar_t* key, Value* value);
-	bool setObjectValue(std::wstring* key, Value* value);
+	Value* peekArrayValueAt(size_t index);
+	Value* peekObjectValueAt(size_t index);
+	bool setObjectValue(const char* key, Value* value);
+	bool setObjectValue(std::string* key, Value* value);
+	bool setObjectValue(ValueAtom* key, Value* value);
 	void setType(int type);
 	void setValue(bool value);
 	void setValue(double value);
+	void setValue(const char* value);
 	void setValue(const wchar_t* value);
-	void setValue(std::wstring* value);
+	void setValue(std::string* value);
+	void setValue(const char* value, size_t length);
+
+	static void* operator new(size_t size);
+	static void operator delete(void* pointer, size_t size);
 
 private:
+	/* flags */
+	static const unsigned char FLAG_INLINE = 0x1;
+	static const unsigned char FLAG_LAZY = 0x2;
+
+	/* constants */
+	static const size_t INLINE_STRING_LENGTH = 15;
+
+	typedef std::vector<Value*, ValuePoolAllocator<Value*> > ArrayStorage;
+
+	/* the elements of an array, which are shared by the array's clones */
+	struct ArrayBlock {
+		ArrayStorage items;
+		unsigned int refCount;
+	};
+
+	/* the members of an object, which are shared by the object's clones */
+	struct ObjectBlock {
+		ValueTable members;
+		unsigned int refCount;
+	};
+
+	/* a string that is too long to be stored inline, allocated as a single block */
+	struct StringBlock {
+		size_t length;
+		unsigned int refCount;
+		char chars[1];
+	};
+
+	static ArrayBlock* createArrayBlock();
+	static ObjectBlock* createObjectBlock();
+
 	void clearCurrentValue();
-	bool setObjectValue(std::wstring* key, Value* value, bool overwrite);
+	void detach();
+	Value* findObjectValue(const char* key, size_t length);
+	void initialize();
+	bool insertObjectValue(const char* key, size_t length, Value* value, bool overwrite);
+	bool insertObjectValue(ValueAtom* key, Value* value, bool overwrite);
+	void materialize();
 
-	std::vector<Value*>* m_arrayValue;
-	double m_numberValue;
-	std::map<std::wstring, Value*>* m_objectValue;
-	std::wstring* m_stringValue;
-	int m_type;
+	/*
+	 * The member of m_value that is in use is determined by m_type and m_flags.
+	 * Strings are stored as UTF-8, and those of up to INLINE_STRING_LENGTH bytes
+	 * are stored within the Value itself, while longer strings, arrays and objects each refer to a single
+	 * block that clones share.
+	 */
+	union {
+		ArrayBlock* array;
+		char chars[INLINE_STRING_LENGTH + 1];
+		struct {
+			JSONDocument* document;
+			unsigned int index;
+		} lazy;
+		double number;
+		ObjectBlock* object;
+		StringBlock* string;
+	} m_value;
+	unsigned char m_flags;
+	unsigned short m_length;
+	unsigned char m_type;
 };
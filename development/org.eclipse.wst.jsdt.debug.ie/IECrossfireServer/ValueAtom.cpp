@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "ValueAtom.h"
+
+/* initialize statics */
+ValueAtom::Table* ValueAtom::s_table = NULL;
+
+ValueAtom::ValueAtom(const char* chars, size_t length, unsigned int hash) {
+	m_hash = hash;
+	m_next = NULL;
+	m_refCount = 1;
+	m_string.assign(chars, length);
+}
+
+ValueAtom::~ValueAtom() {
+}
+
+void ValueAtom::addRef() {
+	m_refCount++;
+}
+
+/*
+ * Returns the interned atom for the given key, or NULL if there is none, in
+ * which case no object has a member with the key.  A reference is not added.
+ */
+ValueAtom* ValueAtom::find(const char* chars, size_t length) {
+	Table* table = getTable();
+	unsigned int keyHash = hash(chars, length);
+	ValueAtom* current = table->buckets[keyHash & (table->bucketCount - 1)];
+	while (current) {
+		if (current->m_hash == keyHash && current->m_string.length() == length && memcmp(current->m_string.data(), chars, length) == 0) {
+			return current;
+		}
+		current = current->m_next;
+	}
+	return NULL;
+}
+
+const char* ValueAtom::getChars() {
+	return m_string.c_str();
+}
+
+unsigned int ValueAtom::getHash() {
+	return m_hash;
+}
+
+size_t ValueAtom::getLength() {
+	return m_string.length();
+}
+
+const std::string* ValueAtom::getString() {
+	return &m_string;
+}
+
+ValueAtom::Table* ValueAtom::getTable() {
+	/* created on first use since atoms are interned during static initialization */
+	if (!s_table) {
+		s_table = new Table;
+		s_table->buckets = NULL;
+		s_table->bucketCount = 0;
+		s_table->count = 0;
+		rehash(s_table, INITIAL_BUCKET_COUNT);
+	}
+	return s_table;
+}
+
+/* FNV-1a */
+unsigned int ValueAtom::hash(const char* chars, size_t length) {
+	unsigned int result = 2166136261U;
+	for (size_t i = 0; i < length; i++) {
+		result = (result ^ (unsigned char)chars[i]) * 16777619U;
+	}
+	return result;
+}
+
+ValueAtom* ValueAtom::intern(const char* chars) {
+	return intern(chars, strlen(chars));
+}
+
+/*
+ * Returns the atom for the given key, creating it if necessary.  The caller
+ * owns a reference to the result.
+ */
+ValueAtom* ValueAtom::intern(const char* chars, size_t length) {
+	ValueAtom* result = find(chars, length);
+	if (result) {
+		result->addRef();
+		return result;
+	}
+
+	Table* table = getTable();
+	result = new ValueAtom(chars, length, hash(chars, length));
+	size_t bucket = result->m_hash & (table->bucketCount - 1);
+	result->m_next = table->buckets[bucket];
+	table->buckets[bucket] = result;
+	if (++table->count > table->bucketCount) {
+		rehash(table, table->bucketCount * 2);
+	}
+	return result;
+}
+
+void ValueAtom::rehash(Table* table, size_t bucketCount) {
+	ValueAtom** buckets = new ValueAtom*[bucketCount];
+	memset(buckets, 0, bucketCount * sizeof(ValueAtom*));
+	for (size_t i = 0; i < table->bucketCount; i++) {
+		ValueAtom* current = table->buckets[i];
+		while (current) {
+			ValueAtom* next = current->m_next;
+			size_t bucket = current->m_hash & (bucketCount - 1);
+			current->m_next = buckets[bucket];
+			buckets[bucket] = current;
+			current = next;
+		}
+	}
+	delete[] table->buckets;
+	table->buckets = buckets;
+	table->bucketCount = bucketCount;
+}
+
+void ValueAtom::release() {
+	if (--m_refCount) {
+		return;
+	}
+
+	Table* table = getTable();
+	ValueAtom** link = &table->buckets[m_hash & (table->bucketCount - 1)];
+	while (*link != this) {
+		link = &(*link)->m_next;
+	}
+	*link = m_next;
+	table->count--;
+	delete this;
+}
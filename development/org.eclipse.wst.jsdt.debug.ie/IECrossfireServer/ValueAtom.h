@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <string>
+
+/*
+ * An interned object key, in UTF-8.  Each distinct key is stored once,
+ * together with its hash, so the members of object Values refer to shared
+ * atoms and compare keys by address.  Lookups with the protocol's KEY_*
+ * constants, which are interned when the server starts, do not hash or
+ * compare any characters.
+ *
+ * Atoms are reference counted, and are removed from the table when the last
+ * reference is released.  Like Values, they are only used on the server's
+ * message thread.
+ */
+class ValueAtom {
+
+public:
+	static ValueAtom* find(const char* chars, size_t length);
+	static ValueAtom* intern(const char* chars);
+	static ValueAtom* intern(const char* chars, size_t length);
+	void addRef();
+	const char* getChars();
+	unsigned int getHash();
+	size_t getLength();
+	const std::string* getString();
+	void release();
+
+private:
+	ValueAtom(const char* chars, size_t length, unsigned int hash);
+	~ValueAtom();
+
+	/* constants */
+	static const size_t INITIAL_BUCKET_COUNT = 256;
+
+	struct Table {
+		ValueAtom** buckets;
+		size_t bucketCount;
+		size_t count;
+	};
+
+	static Table* getTable();
+	static unsigned int hash(const char* chars, size_t length);
+	static void rehash(Table* table, size_t bucketCount);
+
+	unsigned int m_hash;
+	ValueAtom* m_next;
+	unsigned int m_refCount;
+	std::string m_string;
+
+	static Table* s_table;
+};
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "ValuePool.h"
+
+/* initialize statics */
+__declspec(thread) ValuePool::Pool* ValuePool::s_pool = NULL;
+
+ValuePool::ValuePool() {
+}
+
+ValuePool::~ValuePool() {
+}
+
+void* ValuePool::allocate(size_t size) {
+	size_t sizeClass = size ? (size - 1) / GRANULARITY : 0;
+	if (SIZE_CLASS_COUNT <= sizeClass) {
+		return ::operator new(size);
+	}
+
+	Pool* pool = getPool();
+	pool->liveBlocks++;
+	Block* block = pool->freeBlocks[sizeClass];
+	if (block) {
+		pool->freeBlocks[sizeClass] = block->next;
+		return block;
+	}
+
+	size_t blockLength = (sizeClass + 1) * GRANULARITY;
+	if ((size_t)(pool->slabEnd - pool->slabCurrent) < blockLength) {
+		/* the remainder of the current slab is too small, so it is abandoned */
+		char* slab = new char[SLAB_LENGTH];
+		pool->slabs->push_back(slab);
+		pool->slabCurrent = slab;
+		pool->slabEnd = slab + SLAB_LENGTH;
+	}
+	void* result = pool->slabCurrent;
+	pool->slabCurrent += blockLength;
+	return result;
+}
+
+void ValuePool::deallocate(void* block, size_t size) {
+	if (!block) {
+		return;
+	}
+	size_t sizeClass = size ? (size - 1) / GRANULARITY : 0;
+	if (SIZE_CLASS_COUNT <= sizeClass) {
+		::operator delete(block);
+		return;
+	}
+
+	Pool* pool = s_pool;
+	Block* freed = (Block*)block;
+	freed->next = pool->freeBlocks[sizeClass];
+	pool->freeBlocks[sizeClass] = freed;
+	pool->liveBlocks--;
+}
+
+ValuePool::Pool* ValuePool::getPool() {
+	Pool* pool = s_pool;
+	if (!pool) {
+		pool = new Pool;
+		for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+			pool->freeBlocks[i] = NULL;
+		}
+		pool->liveBlocks = 0;
+		pool->slabCurrent = pool->slabEnd = NULL;
+		pool->slabs = new std::vector<char*>;
+		s_pool = pool;
+	}
+	return pool;
+}
+
+/*
+ * Returns the current thread's slabs to the heap at once, rather than freeing
+ * their blocks individually.  This is only possible once every block has been
+ * freed, which is typically the case once a connection has been closed.
+ */
+bool ValuePool::release() {
+	Pool* pool = s_pool;
+	if (!pool || pool->liveBlocks) {
+		return false;
+	}
+
+	std::vector<char*>::iterator iterator = pool->slabs->begin();
+	while (iterator != pool->slabs->end()) {
+		delete[] *iterator;
+		iterator++;
+	}
+	pool->slabs->clear();
+	for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+		pool->freeBlocks[i] = NULL;
+	}
+	pool->slabCurrent = pool->slabEnd = NULL;
+	return true;
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <new>
+#include <vector>
+
+/*
+ * Allocates the small, short-lived blocks that make up Values (the nodes, their
+ * containers and the containers' elements) from slabs that are kept by the
+ * current thread.  Each block size is rounded up to a size class with its own
+ * free list, so a freed block is simply reused by the next allocation of its
+ * class.  Blocks larger than the largest size class are passed on to the heap.
+ *
+ * Blocks must be freed on the thread that allocated them.  The server processes
+ * all packets on its message thread, so in practice this is always the case.
+ */
+class ValuePool {
+
+public:
+	static void* allocate(size_t size);
+	static void deallocate(void* block, size_t size);
+	static bool release();
+
+	template<class T> static T* create() {
+		return new (allocate(sizeof(T))) T;
+	}
+
+	template<class T> static void destroy(T* object) {
+		if (object) {
+			object->~T();
+			deallocate(object, sizeof(T));
+		}
+	}
+
+protected:
+	ValuePool();
+	~ValuePool();
+
+private:
+	/* constants */
+	static const size_t GRANULARITY = 16;
+	static const size_t SIZE_CLASS_COUNT = 8; /* blocks of up to 128 bytes */
+	static const size_t SLAB_LENGTH = 16384;
+
+	struct Block {
+		Block* next;
+	};
+
+	struct Pool {
+		Block* freeBlocks[SIZE_CLASS_COUNT];
+		size_t liveBlocks;
+		char* slabCurrent;
+		char* slabEnd;
+		std::vector<char*>* slabs;
+	};
+
+	static Pool* getPool();
+
+	static __declspec(thread) Pool* s_pool;
+};
+
+/*
+ * An STL allocator that allocates from ValuePool, for the containers of Values.
+ */
+template<class T> class ValuePoolAllocator {
+
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<class U> struct rebind {
+		typedef ValuePoolAllocator<U> other;
+	};
+
+	ValuePoolAllocator() {}
+	ValuePoolAllocator(const ValuePoolAllocator&) {}
+	template<class U> ValuePoolAllocator(const ValuePoolAllocator<U>&) {}
+
+	pointer address(reference value) const {
+		return &value;
+	}
+
+	const_pointer address(const_reference value) const {
+		return &value;
+	}
+
+	pointer allocate(size_type count, const void* hint = 0) {
+		return (pointer)ValuePool::allocate(count * sizeof(T));
+	}
+
+	void construct(pointer location, const T& value) {
+		new ((void*)location) T(value);
+	}
+
+	void deallocate(pointer location, size_type count) {
+		ValuePool::deallocate(location, count * sizeof(T));
+	}
+
+	void destroy(pointer location) {
+		location->~T();
+	}
+
+	size_type max_size() const {
+		return ((size_type)-1) / sizeof(T);
+	}
+};
+
+template<class T, class U> bool operator==(const ValuePoolAllocator<T>&, const ValuePoolAllocator<U>&) {
+	return true;
+}
+
+template<class T, class U> bool operator!=(const ValuePoolAllocator<T>&, const ValuePoolAllocator<U>&) {
+	return false;
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#include "StdAfx.h"
+#include "ValueTable.h"
+
+ValueTable::ValueTable() {
+	m_index = NULL;
+	m_indexCapacity = 0;
+	m_members = ValuePool::create<MemberStorage>();
+}
+
+ValueTable::~ValueTable() {
+	if (m_index) {
+		ValuePool::deallocate(m_index, m_indexCapacity * sizeof(unsigned int));
+	}
+	MemberStorage::iterator iterator = m_members->begin();
+	while (iterator != m_members->end()) {
+		iterator->key->release();
+		iterator++;
+	}
+	ValuePool::destroy(m_members);
+}
+
+void ValueTable::append(ValueAtom* key, Value* value) {
+	Member member;
+	member.key = key;
+	member.value = value;
+	m_members->push_back(member);
+	key->addRef();
+
+	size_t count = m_members->size();
+	if (count <= HASH_THRESHOLD) {
+		return;
+	}
+
+	/* keep the index at most half full */
+	if (m_indexCapacity < count * 2) {
+		index(m_indexCapacity ? m_indexCapacity * 2 : HASH_THRESHOLD * 4);
+		return;
+	}
+	size_t mask = m_indexCapacity - 1;
+	size_t slot = key->getHash() & mask;
+	while (m_index[slot]) {
+		slot = (slot + 1) & mask;
+	}
+	m_index[slot] = (unsigned int)count;
+}
+
+int ValueTable::find(ValueAtom* key) {
+	if (!m_index) {
+		size_t count = m_members->size();
+		for (size_t i = 0; i < count; i++) {
+			if ((*m_members)[i].key == key) {
+				return (int)i;
+			}
+		}
+		return -1;
+	}
+
+	size_t mask = m_indexCapacity - 1;
+	size_t slot = key->getHash() & mask;
+	while (m_index[slot]) {
+		unsigned int position = m_index[slot] - 1;
+		if ((*m_members)[position].key == key) {
+			return (int)position;
+		}
+		slot = (slot + 1) & mask;
+	}
+	return -1;
+}
+
+ValueAtom* ValueTable::getKey(size_t index) {
+	return (*m_members)[index].key;
+}
+
+Value* ValueTable::getValue(size_t index) {
+	return (*m_members)[index].value;
+}
+
+void ValueTable::index(size_t capacity) {
+	if (m_index) {
+		ValuePool::deallocate(m_index, m_indexCapacity * sizeof(unsigned int));
+	}
+	m_index = (unsigned int*)ValuePool::allocate(capacity * sizeof(unsigned int));
+	m_indexCapacity = capacity;
+	memset(m_index, 0, capacity * sizeof(unsigned int));
+
+	size_t mask = capacity - 1;
+	size_t count = m_members->size();
+	for (size_t i = 0; i < count; i++) {
+		size_t slot = (*m_members)[i].key->getHash() & mask;
+		while (m_index[slot]) {
+			slot = (slot + 1) & mask;
+		}
+		m_index[slot] = (unsigned int)(i + 1);
+	}
+}
+
+void ValueTable::reserve(size_t count) {
+	m_members->reserve(count);
+}
+
+void ValueTable::setValue(size_t index, Value* value) {
+	(*m_members)[index].value = value;
+}
+
+size_t ValueTable::size() {
+	return m_members->size();
+}
@@ -0,0 +1,62 @@
+/*******************************************************************************
+ * Copyright (c) 2012 IBM Corporation and others.
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * which accompanies this distribution, and is available at
+ * http://www.eclipse.org/legal/epl-v10.html
+ *
+ * Contributors:
+ *     IBM Corporation - initial API and implementation
+ *******************************************************************************/
+
+
+#pragma once
+
+#include <vector>
+
+#include "ValueAtom.h"
+#include "ValuePool.h"
+
+class Value; // forward declaration
+
+/*
+ * Holds the members of an object Value in the order in which they were added.
+ * Keys are interned ValueAtoms, so they are compared by address.  Protocol
+ * objects rarely have more than a handful of members, so a small table is
+ * searched linearly.  Once a table grows past HASH_THRESHOLD members it also
+ * maintains an open-addressing index from key hashes to members.
+ *
+ * The table holds a reference to each of its keys but does not own its values,
+ * and members cannot be removed.
+ */
+class ValueTable {
+
+public:
+	ValueTable();
+	~ValueTable();
+	void append(ValueAtom* key, Value* value);
+	int find(ValueAtom* key);
+	ValueAtom* getKey(size_t index);
+	Value* getValue(size_t index);
+	void reserve(size_t count);
+	void setValue(size_t index, Value* value);
+	size_t size();
+
+private:
+	/* constants */
+	static const size_t HASH_THRESHOLD = 8;
+
+	struct Member {
+		ValueAtom* key;
+		Value* value;
+	};
+
+	typedef std::vector<Member, ValuePoolAllocator<Member> > MemberStorage;
+
+	void index(size_t capacity);
+
+	/* slots hold a member's position plus one, or zero if they are empty */
+	unsigned int* m_index;
+	size_t m_indexCapacity;
+	MemberStorage* m_members;
+};
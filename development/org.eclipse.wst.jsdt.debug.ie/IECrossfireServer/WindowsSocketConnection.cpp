@@ -17,13 +17,29 @@
 std::map<HWND, WindowsSocketConnection*>* WindowsSocketConnection::s_connections = new std::map<HWND, WindowsSocketConnection*>; /* leaked */
 
 WindowsSocketConnection::WindowsSocketConnection(CrossfireServer* server) {
+	m_batchWindow = 0;
 	m_clientSocket = INVALID_SOCKET;
+	m_destroyed = NULL;
+	m_flushScheduled = false;
 	m_server = server;
 	m_hWnd = NULL;
 	m_listenSocket = INVALID_SOCKET;	
+	m_queuedLength = 0;
+	m_readBufferSize = MIN_READ_BUFFER_SIZE;
+	m_readBuffer = new char[m_readBufferSize];
+	m_sendOffset = 0;
+	m_sendQueue = new std::deque<std::string*>;
+	m_smallReads = 0;
+	m_writeBlocked = false;
 }
 
 WindowsSocketConnection::~WindowsSocketConnection() {
+	if (m_destroyed) {
+		*m_destroyed = true;
+	}
+	delete[] m_readBuffer;
+	clearSendQueue();
+	delete m_sendQueue;
 }
 
 bool WindowsSocketConnection::acceptConnection() {
@@ -35,7 +51,54 @@ bool WindowsSocketConnection::acceptConnection() {
 	return true;
 }
 
+/*
+ * Appends data to the send queue.  Small packets are coalesced into the last
+ * queued buffer so that a burst of them is sent with a single WSASend().  If
+ * the queue would exceed MAX_QUEUED_LENGTH then the client is not reading
+ * what it is sent, so the connection is dropped instead.
+ */
+bool WindowsSocketConnection::appendToSendQueue(const char* msg, size_t length) {
+	if (MAX_QUEUED_LENGTH - m_queuedLength < length) {
+		Logger::error("WindowsSocketConnection.appendToSendQueue(): send queue is full, dropping the connection");
+		dropConnection();
+		return false;
+	}
+	m_queuedLength += length;
+	if (!m_sendQueue->empty()) {
+		std::string* last = m_sendQueue->back();
+		if (last->length() + length <= MAX_COALESCED_LENGTH) {
+			last->append(msg, length);
+			return true;
+		}
+	}
+	m_sendQueue->push_back(new std::string(msg, length));
+	return true;
+}
+
+void WindowsSocketConnection::clearSendQueue() {
+	std::deque<std::string*>::iterator iterator = m_sendQueue->begin();
+	while (iterator != m_sendQueue->end()) {
+		delete *iterator;
+		iterator++;
+	}
+	m_sendQueue->clear();
+	m_queuedLength = 0;
+	m_sendOffset = 0;
+}
+
 bool WindowsSocketConnection::close() {
+	/*
+	 * Make a last attempt to send what is queued, such as a closed event.  This
+	 * is made even if the socket would last have blocked, since no FD_WRITE
+	 * notification will follow to send it.
+	 */
+	if (m_flushScheduled) {
+		KillTimer(m_hWnd, TIMER_FLUSH);
+		m_flushScheduled = false;
+	}
+	m_writeBlocked = false;
+	flushSendQueue();
+	clearSendQueue();
 	deregisterConnection(m_hWnd);
 	closesocket(m_clientSocket);
 	closesocket(m_listenSocket);
@@ -43,6 +106,87 @@ bool WindowsSocketConnection::close() {
 	return true;
 }
 
+/*
+ * Closes a client socket that can no longer be written to and discards what
+ * is queued for it.  The server is notified of the disconnection once the
+ * current message has been handled rather than from here, since it deletes
+ * this connection in response.
+ */
+void WindowsSocketConnection::dropConnection() {
+	clearSendQueue();
+	m_writeBlocked = false;
+	closesocket(m_clientSocket);
+	m_clientSocket = INVALID_SOCKET;
+	if (!PostMessage(m_hWnd, EW_CLOSE_MSG, 0, 0)) {
+		Logger::error("WindowsSocketConnection.dropConnection(): PostMessage() failed", GetLastError());
+	}
+}
+
+/*
+ * Sends the queued data now rather than at the end of the batch window.
+ */
+bool WindowsSocketConnection::flush() {
+	if (m_flushScheduled) {
+		KillTimer(m_hWnd, TIMER_FLUSH);
+		m_flushScheduled = false;
+	}
+	if (m_writeBlocked) {
+		/* the queue will be flushed by the FD_WRITE notification */
+		return true;
+	}
+	return flushSendQueue();
+}
+
+/*
+ * Sends as much of the queued data as the socket accepts, gathering up to
+ * MAX_SEND_BUFFERS queued packets into each WSASend().  A packet that is only
+ * partly sent stays at the front of the queue with m_sendOffset marking where
+ * the next send resumes.  Sending continues until the queue is empty or the
+ * socket would block, in which case an FD_WRITE notification follows once it
+ * is writable again.  Any other failure drops the connection.
+ */
+bool WindowsSocketConnection::flushSendQueue() {
+	while (!m_sendQueue->empty()) {
+		WSABUF buffers[MAX_SEND_BUFFERS];
+		DWORD count = 0;
+		std::deque<std::string*>::iterator iterator = m_sendQueue->begin();
+		while (iterator != m_sendQueue->end() && count < MAX_SEND_BUFFERS) {
+			size_t offset = count ? 0 : m_sendOffset;
+			buffers[count].buf = (char*)(*iterator)->data() + offset;
+			buffers[count].len = (ULONG)((*iterator)->length() - offset);
+			count++;
+			iterator++;
+		}
+
+		DWORD sent = 0;
+		if (WSASend(m_clientSocket, buffers, count, &sent, 0, NULL, NULL) == SOCKET_ERROR) {
+			int error = WSAGetLastError();
+			if (error == WSAEWOULDBLOCK) {
+				m_writeBlocked = true;
+				return true;
+			}
+			Logger::error("WindowsSocketConnection.flushSendQueue(): WSASend() failed", error);
+			dropConnection();
+			return false;
+		}
+
+		while (sent) {
+			std::string* packet = m_sendQueue->front();
+			size_t remaining = packet->length() - m_sendOffset;
+			if (sent < remaining) {
+				m_sendOffset += sent;
+				break;
+			}
+			sent -= (DWORD)remaining;
+			m_queuedLength -= packet->length();
+			delete packet;
+			m_sendQueue->pop_front();
+			m_sendOffset = 0;
+		}
+	}
+	return true;
+}
+
 void WindowsSocketConnection::handleSocketAccept() {
 	m_clientSocket = accept(m_listenSocket, NULL, NULL);
 	if (m_clientSocket == INVALID_SOCKET) {
@@ -50,7 +194,7 @@ void WindowsSocketConnection::handleSocketAccept() {
 		return;
 	}
 
-	int rc = WSAAsyncSelect(m_clientSocket, m_hWnd, EW_SOCKET_MSG, FD_READ | FD_CLOSE);
+	int rc = WSAAsyncSelect(m_clientSocket, m_hWnd, EW_SOCKET_MSG, FD_READ | FD_WRITE | FD_CLOSE);
 	if (rc == SOCKET_ERROR) {
 		closesocket(m_clientSocket);
 		m_clientSocket = INVALID_SOCKET;
@@ -68,30 +212,63 @@ void WindowsSocketConnection::handleSocketClose() {
 	m_server->disconnected();
 }
 
+/*
+ * Reads until the socket has no more data available, rather than reading once
+ * per FD_READ notification, so that a large packet does not need a message
+ * pump round trip for each buffer of it.  The reads of a single notification
+ * are bounded by MAX_READ_PER_NOTIFICATION so that other messages are not
+ * starved, and since recv() re-enables FD_READ a notification follows for any
+ * data that remains.
+ *
+ * The server queues received requests and performs them once received() has
+ * returned, so it should not run a nested message loop while it handles the
+ * received data.  Should it do so, a notification that arrives during this
+ * is ignored, since the read buffer is still in use and the outer read
+ * continues to drain the socket once the server returns.
+ * The connection can also be closed and deleted by the nested loop, in which
+ * case the outer read stops.
+ */
 void WindowsSocketConnection::handleSocketRead() {
-	const int LENGTH_BUFFER = 4096;
-	char buffer[LENGTH_BUFFER];
-	ZeroMemory(buffer, LENGTH_BUFFER);
-
-	int length = recv(m_clientSocket, buffer, LENGTH_BUFFER, 0);
-	if (length == SOCKET_ERROR) {
-		Logger::error("WindowsSocketConnection.handleSocketRead(): recv() failed", errno);
+	if (m_destroyed) {
 		return;
 	}
-	if (length == 0) {
-		/* connection closed */
-		Logger::log("WindowsSocketConnection.handleSocketRead(): recv() length 0, implies socket closed");
-		PostQuitMessage(0);
-		return;
+
+	bool destroyed = false;
+	m_destroyed = &destroyed;
+	size_t total = 0;
+	while (isConnected() && total < MAX_READ_PER_NOTIFICATION) {
+		int length = recv(m_clientSocket, m_readBuffer, (int)m_readBufferSize, 0);
+		if (length == SOCKET_ERROR) {
+			int error = WSAGetLastError();
+			if (error != WSAEWOULDBLOCK) {
+				Logger::error("WindowsSocketConnection.handleSocketRead(): recv() failed", error);
+			}
+			break;
+		}
+		if (length == 0) {
+			/* connection closed */
+			Logger::log("WindowsSocketConnection.handleSocketRead(): recv() length 0, implies socket closed");
+			PostQuitMessage(0);
+			break;
+		}
+
+		/*
+		 * The received UTF-8 bytes are handed to the server as a slice of the read
+		 * buffer, it frames and parses them in place before returning.
+		 */
+		m_server->received(m_readBuffer, length);
+		if (destroyed) {
+			return;
+		}
+		total += length;
+		resizeReadBuffer(length);
 	}
+	m_destroyed = NULL;
+}
 
-	length = MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)buffer, -1, NULL, 0);
-	wchar_t* content = new wchar_t[length];
-	MultiByteToWideChar(CP_UTF8, 0, (LPCSTR)buffer, -1, content, length);
-//Logger::log("-----\nReceived:");
-//Logger::log(content);
-	m_server->received(content);
-	delete[] content;
+void WindowsSocketConnection::handleSocketWrite() {
+	m_writeBlocked = false;
+	flushSendQueue();
 }
 
 bool WindowsSocketConnection::init(unsigned int port) {
@@ -178,19 +355,76 @@ bool WindowsSocketConnection::isConnected() {
 	return m_clientSocket != INVALID_SOCKET;
 }
 
-bool WindowsSocketConnection::send(const wchar_t* msg) {
-//Logger::log("-----\nSent:");
-//Logger::log((wchar_t*)msg);
-	int length = WideCharToMultiByte(CP_UTF8, 0, msg, -1, NULL, 0, NULL, NULL);
-	char* content = new char[length];
-	WideCharToMultiByte(CP_UTF8, 0, msg, -1, content, length, NULL, NULL);
-	if (::send(m_clientSocket, content, length - 1, 0) == SOCKET_ERROR) { /* uses length - 1 to not send null terminator */
-		Logger::error("WindowsSocketConnection.send(): send() failed", errno);
+/*
+ * Queues a packet to be sent with any others that are queued within the batch
+ * window.  A batch window of 0 sends the packets that are queued during the
+ * current message dispatch once it has completed.  The queue is flushed early
+ * if it grows to MAX_SEND_BUFFERS buffers, which is as much as can be sent with
+ * a single WSASend().
+ */
+bool WindowsSocketConnection::queue(const char* msg, size_t length) {
+	if (!isConnected() || !appendToSendQueue(msg, length)) {
 		return false;
 	}
+	if (m_sendQueue->size() >= MAX_SEND_BUFFERS) {
+		return flush();
+	}
+	if (!m_flushScheduled) {
+		if (m_batchWindow) {
+			if (!SetTimer(m_hWnd, TIMER_FLUSH, m_batchWindow, NULL)) {
+				Logger::error("WindowsSocketConnection.queue(): SetTimer() failed", GetLastError());
+				return flush();
+			}
+		} else if (!PostMessage(m_hWnd, EW_FLUSH_MSG, 0, 0)) {
+			Logger::error("WindowsSocketConnection.queue(): PostMessage() failed", GetLastError());
+			return flush();
+		}
+		m_flushScheduled = true;
+	}
 	return true;
 }
 
+/*
+ * Sends a packet, or queues whatever part of it the socket does not accept
+ * immediately.  The packet is sent directly from the caller's buffer if
+ * nothing is queued ahead of it, so it is only copied if it cannot be sent
+ * at once.  Otherwise it is sent together with the queued packets ahead of
+ * it, which preserves their order.
+ */
+bool WindowsSocketConnection::send(const char* msg, size_t length) {
+	if (!isConnected()) {
+		return false;
+	}
+	const char* current = msg;
+	size_t remaining = length;
+	if (m_sendQueue->empty()) {
+		while (remaining) {
+			int sent = ::send(m_clientSocket, current, (int)remaining, 0);
+			if (sent == SOCKET_ERROR) {
+				int error = WSAGetLastError();
+				if (error == WSAEWOULDBLOCK) {
+					m_writeBlocked = true;
+					break;
+				}
+				Logger::error("WindowsSocketConnection.send(): send() failed", error);
+				dropConnection();
+				return false;
+			}
+			current += sent;
+			remaining -= sent;
+		}
+		if (remaining) {
+			return appendToSendQueue(current, remaining);
+		}
+		return true;
+	}
+
+	if (!appendToSendQueue(current, remaining)) {
+		return false;
+	}
+	return flush();
+}
+
 bool WindowsSocketConnection::deregisterConnection(HWND hWnd) {
 	std::map<HWND, WindowsSocketConnection*>::iterator iterator = s_connections->find(hWnd);
 	if (iterator != s_connections->end()) {
@@ -211,6 +445,40 @@ WindowsSocketConnection* WindowsSocketConnection::getConnection(HWND hWnd) {
 	return iterator->second;
 }
 
+/*
+ * Adapts the read buffer to the amount of data that recent reads have
+ * returned.  The buffer is doubled when a read fills it, since more data is
+ * likely waiting, and is halved after a run of reads that use no more than a
+ * quarter of it, so that a single large packet does not hold on to a large
+ * buffer for the rest of the connection.
+ */
+void WindowsSocketConnection::resizeReadBuffer(size_t lastLength) {
+	size_t size = m_readBufferSize;
+	if (lastLength == m_readBufferSize) {
+		m_smallReads = 0;
+		if (m_readBufferSize < MAX_READ_BUFFER_SIZE) {
+			size = m_readBufferSize * 2;
+		}
+	} else if (lastLength <= m_readBufferSize / 4 && MIN_READ_BUFFER_SIZE < m_readBufferSize) {
+		if (++m_smallReads == SHRINK_AFTER_READS) {
+			m_smallReads = 0;
+			size = m_readBufferSize / 2;
+		}
+	} else {
+		m_smallReads = 0;
+	}
+
+	if (size != m_readBufferSize) {
+		delete[] m_readBuffer;
+		m_readBuffer = new char[size];
+		m_readBufferSize = size;
+	}
+}
+
+void WindowsSocketConnection::setBatchWindow(unsigned int milliseconds) {
+	m_batchWindow = milliseconds;
+}
+
 void WindowsSocketConnection::registerConnection(HWND hWnd, WindowsSocketConnection* connection) {
 	s_connections->insert(std::pair<HWND,WindowsSocketConnection*>(hWnd, connection));
 }
@@ -232,6 +500,10 @@ LRESULT CALLBACK WindowsSocketConnection::WndProc(HWND hWnd, UINT message, WPARA
 					instance->handleSocketAccept();
 					break;
 				}
+				case FD_WRITE: {
+					instance->handleSocketWrite();
+					break;
+				}
 				case FD_CLOSE: {
 					instance->handleSocketClose();
 					break;
@@ -243,6 +515,24 @@ LRESULT CALLBACK WindowsSocketConnection::WndProc(HWND hWnd, UINT message, WPARA
 			}
 			break;
 		}
+		case EW_CLOSE_MSG: {
+			WindowsSocketConnection* instance = WindowsSocketConnection::getConnection(hWnd);
+			if (instance) {
+				instance->handleSocketClose();
+			}
+			break;
+		}
+		case EW_FLUSH_MSG:
+		case WM_TIMER: {
+			if (message == WM_TIMER && wParam != TIMER_FLUSH) {
+				return DefWindowProc(hWnd, message, wParam, lParam);
+			}
+			WindowsSocketConnection* instance = WindowsSocketConnection::getConnection(hWnd);
+			if (instance) {
+				instance->flush();
+			}
+			break;
+		}
 		default: {
 			return DefWindowProc(hWnd, message, wParam, lParam);
 		}
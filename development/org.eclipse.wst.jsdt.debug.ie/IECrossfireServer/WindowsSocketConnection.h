@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <deque>
 #include <iostream>
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -21,6 +22,15 @@
 class WindowsSocketConnection; // forward declaration
 #include "CrossfireServer.h"
 
+/*
+ * The connection to a client.  Packets that cannot be sent immediately, in
+ * whole or in part, are queued and sent as the socket becomes writable, so a
+ * slow client neither blocks the server nor loses the end of a packet.
+ * Packets that are queued rather than sent, such as events, are held for up
+ * to the batch window and then sent together with the fewest possible writes.
+ * A client that stops reading, or a send that fails, drops the connection
+ * rather than letting the queue grow without bound.
+ */
 class WindowsSocketConnection {
 
 public:
@@ -28,19 +38,38 @@ public:
 	~WindowsSocketConnection();
 	bool acceptConnection();
 	bool close();
+	bool flush();
 	bool init(unsigned int port);
 	bool isConnected();
-	bool send(const wchar_t* msg);
+	bool queue(const char* msg, size_t length);
+	bool send(const char* msg, size_t length);
+	void setBatchWindow(unsigned int milliseconds);
 
 private:
+	bool appendToSendQueue(const char* msg, size_t length);
+	void clearSendQueue();
+	void dropConnection();
+	bool flushSendQueue();
 	void handleSocketAccept();
 	void handleSocketClose();
 	void handleSocketRead();
+	void handleSocketWrite();
+	void resizeReadBuffer(size_t lastLength);
 
+	unsigned int m_batchWindow;
 	SOCKET m_clientSocket;
+	bool* m_destroyed;
+	bool m_flushScheduled;
 	CrossfireServer* m_server;
 	HWND m_hWnd;
 	SOCKET m_listenSocket;
+	char* m_readBuffer;
+	size_t m_readBufferSize;
+	size_t m_queuedLength;
+	size_t m_sendOffset;
+	std::deque<std::string*>* m_sendQueue;
+	unsigned int m_smallReads;
+	bool m_writeBlocked;
 
 	static bool deregisterConnection(HWND hWnd);
 	static WindowsSocketConnection* getConnection(HWND hWnd);
@@ -50,5 +79,15 @@ private:
 	static std::map<HWND, WindowsSocketConnection*>* s_connections;
 
 	/* constants */
+	static const int EW_CLOSE_MSG = WM_APP + 3;
+	static const int EW_FLUSH_MSG = WM_APP + 2;
 	static const int EW_SOCKET_MSG = WM_APP + 1;
+	static const size_t MAX_COALESCED_LENGTH = 64 * 1024;
+	static const size_t MAX_QUEUED_LENGTH = 32 * 1024 * 1024;
+	static const size_t MAX_READ_BUFFER_SIZE = 1024 * 1024;
+	static const size_t MAX_READ_PER_NOTIFICATION = 4 * 1024 * 1024;
+	static const DWORD MAX_SEND_BUFFERS = 16;
+	static const size_t MIN_READ_BUFFER_SIZE = 4096;
+	static const unsigned int SHRINK_AFTER_READS = 16;
+	static const UINT_PTR TIMER_FLUSH = 1;
 };